@@ -0,0 +1,68 @@
+﻿// Copyright Nikita Zolotukhin. All Rights Reserved.
+
+#include "BVPPathAnalysis.h"
+
+void FBVPSpeedProfile::SetNumSamples( int32 NumSamples )
+{
+	SampleSpeeds.SetNumZeroed( NumSamples );
+	SampleDistances.SetNumZeroed( NumSamples );
+	SampleGrades.SetNumZeroed( NumSamples );
+}
+
+void FBVPSpeedProfile::ApplyAccelerationLimits( double MaxAcceleration, double MaxDeceleration )
+{
+	const int32 NumSamples = GetNumSamples();
+	if ( NumSamples < 2 )
+	{
+		return;
+	}
+	constexpr double MinEffectiveAcceleration = 0.1;
+
+	// The profile is a loop, so start both passes from the slowest sample, which can never go faster than it already does
+	int32 SlowestSampleIndex = 0;
+	for ( int32 i = 1; i < NumSamples; i++ )
+	{
+		if ( SampleSpeeds[i] < SampleSpeeds[SlowestSampleIndex] )
+		{
+			SlowestSampleIndex = i;
+		}
+	}
+
+	// Forward pass limits the speed by how fast the vehicle can accelerate from the previous sample
+	for ( int32 Step = 1; Step < NumSamples; Step++ )
+	{
+		const int32 PrevIndex = ( SlowestSampleIndex + Step - 1 ) % NumSamples;
+		const int32 SampleIndex = ( SlowestSampleIndex + Step ) % NumSamples;
+
+		const double Acceleration = FMath::Max( MaxAcceleration - GravityAcceleration * SampleGrades[PrevIndex], MinEffectiveAcceleration );
+		const double ReachableSpeed = FMath::Sqrt( FMath::Square( SampleSpeeds[PrevIndex] ) + 2.0 * Acceleration * SampleDistances[PrevIndex] );
+		SampleSpeeds[SampleIndex] = FMath::Min( SampleSpeeds[SampleIndex], ReachableSpeed );
+	}
+
+	// Backward pass limits the speed by the braking distance to the slower samples ahead
+	for ( int32 Step = 1; Step < NumSamples; Step++ )
+	{
+		const int32 NextIndex = ( SlowestSampleIndex - Step + 1 + NumSamples ) % NumSamples;
+		const int32 SampleIndex = ( SlowestSampleIndex - Step + NumSamples ) % NumSamples;
+
+		const double Deceleration = FMath::Max( MaxDeceleration + GravityAcceleration * SampleGrades[SampleIndex], MinEffectiveAcceleration );
+		const double BrakingSpeed = FMath::Sqrt( FMath::Square( SampleSpeeds[NextIndex] ) + 2.0 * Deceleration * SampleDistances[SampleIndex] );
+		SampleSpeeds[SampleIndex] = FMath::Min( SampleSpeeds[SampleIndex], BrakingSpeed );
+	}
+}
+
+double FBVPSpeedProfile::ComputeTravelTime( int32 StartSample, int32 EndSample ) const
+{
+	const int32 NumSamples = GetNumSamples();
+	constexpr double MinSpeed = 0.1;
+
+	// Speed changes linearly between the samples, so each step is driven at the average speed of its ends
+	double TravelTime = 0.0;
+	for ( int32 i = StartSample; i < EndSample; i++ )
+	{
+		const int32 SampleIndex = i % NumSamples;
+		const double AverageSpeed = ( SampleSpeeds[SampleIndex] + SampleSpeeds[( SampleIndex + 1 ) % NumSamples] ) * 0.5;
+		TravelTime += SampleDistances[SampleIndex] / FMath::Max( AverageSpeed, MinSpeed );
+	}
+	return TravelTime;
+}
@@ -0,0 +1,199 @@
+﻿// Copyright Nikita Zolotukhin. All Rights Reserved.
+
+#include "BVPPathConflictDetector.h"
+#include "Algo/BinarySearch.h"
+#include "BVPSettings.h"
+#include "BVPVehiclePathSegmentVisualization.h"
+#include "BVPVehiclePathVisualization.h"
+#include "WheeledVehicles/FGTargetPointLinkedList.h"
+
+bool FBVPPathConflictDetector::Update( const TArray<FBVPVehiclePathVisualization*>& PathVisualizations )
+{
+	// Find the paths that have changed, appeared or disappeared since the last update. A re-created visualization of the same list counts as changed,
+	// since the sweep entries point to its segments
+	TSet<TObjectKey<AFGDrivingTargetList>> ChangedTargetLists;
+	TMap<TObjectKey<AFGDrivingTargetList>, FAnalyzedPath> CurrentPaths;
+	CurrentPaths.Reserve( PathVisualizations.Num() );
+
+	for ( const FBVPVehiclePathVisualization* PathVisualization : PathVisualizations )
+	{
+		const TObjectKey<AFGDrivingTargetList> TargetListKey = PathVisualization->GetTargetListKey();
+		const FAnalyzedPath* AnalyzedPath = AnalyzedPaths.Find( TargetListKey );
+
+		if ( !AnalyzedPath || AnalyzedPath->PathVisualization != PathVisualization || AnalyzedPath->GeometryGeneration != PathVisualization->GetGeometryGeneration() )
+		{
+			ChangedTargetLists.Add( TargetListKey );
+		}
+		CurrentPaths.Add( TargetListKey, FAnalyzedPath{ PathVisualization, PathVisualization->GetGeometryGeneration() } );
+	}
+	for ( const TPair<TObjectKey<AFGDrivingTargetList>, FAnalyzedPath>& Pair : AnalyzedPaths )
+	{
+		if ( !CurrentPaths.Contains( Pair.Key ) )
+		{
+			ChangedTargetLists.Add( Pair.Key );
+		}
+	}
+
+	if ( ChangedTargetLists.IsEmpty() )
+	{
+		return false;
+	}
+	AnalyzedPaths = MoveTemp( CurrentPaths );
+
+	// Conflicts between two unchanged paths are still valid, the rest will be found again
+	Conflicts.RemoveAll( [&]( const FConflictRecord& ConflictRecord )
+	{
+		return ChangedTargetLists.Contains( ConflictRecord.TargetListA ) || ChangedTargetLists.Contains( ConflictRecord.TargetListB );
+	} );
+
+	// Removing the entries keeps the rest of them sorted
+	SweepEntries.RemoveAll( [&]( const FSweepEntry& SweepEntry ) { return ChangedTargetLists.Contains( SweepEntry.TargetList ); } );
+
+	const UBVPSettings* BVPSettings = UBVPSettings::Get();
+	const double MaxDistance = FMath::Max( BVPSettings->ConflictMaxDistance, 0.0f );
+	const double MinCrossingAngleCosine = FMath::Cos( FMath::DegreesToRadians( BVPSettings->ConflictOverlapMaxAngle ) );
+
+	// Bounds are expanded by half of the distance, so that the segments within the distance from each other have overlapping bounds
+	ChangedSweepEntries.Reset();
+	for ( const FBVPVehiclePathVisualization* PathVisualization : PathVisualizations )
+	{
+		const TObjectKey<AFGDrivingTargetList> TargetListKey = PathVisualization->GetTargetListKey();
+		if ( !ChangedTargetLists.Contains( TargetListKey ) )
+		{
+			continue;
+		}
+
+		for ( const FBVPVehiclePathSegmentVisualization* SegmentVisualization : PathVisualization->GetVisualizationSegments() )
+		{
+			const FBox& SegmentBounds = SegmentVisualization->GetSegmentMetrics().Bounds;
+			if ( SegmentBounds.IsValid && SegmentVisualization->GetStartPathNode() )
+			{
+				FSweepEntry& SweepEntry = ChangedSweepEntries.AddDefaulted_GetRef();
+				SweepEntry.Bounds = SegmentBounds.ExpandBy( MaxDistance * 0.5 );
+				SweepEntry.SegmentVisualization = SegmentVisualization;
+				SweepEntry.TargetList = TargetListKey;
+			}
+		}
+	}
+	const auto SweepEntryMinX = []( const FSweepEntry& SweepEntry ) { return SweepEntry.Bounds.Min.X; };
+	ChangedSweepEntries.Sort( []( const FSweepEntry& A, const FSweepEntry& B ) { return A.Bounds.Min.X < B.Bounds.Min.X; } );
+
+	// Changed entries are tested against each other the same way as a full sweep: only the following entries that start before the entry ends can overlap it
+	for ( int32 i = 0; i < ChangedSweepEntries.Num(); i++ )
+	{
+		const FSweepEntry& EntryA = ChangedSweepEntries[i];
+		for ( int32 j = i + 1; j < ChangedSweepEntries.Num() && ChangedSweepEntries[j].Bounds.Min.X <= EntryA.Bounds.Max.X; j++ )
+		{
+			TestSweepEntryPair( EntryA, ChangedSweepEntries[j], MaxDistance, MinCrossingAngleCosine );
+		}
+	}
+
+	// Against the unchanged entries, an overlapping entry cannot start further before the changed one than the longest entry is
+	for ( const FSweepEntry& ChangedEntry : ChangedSweepEntries )
+	{
+		const int32 FirstEntryIndex = Algo::LowerBoundBy( SweepEntries, ChangedEntry.Bounds.Min.X - MaxSweepEntryExtentX, SweepEntryMinX );
+		for ( int32 i = FirstEntryIndex; i < SweepEntries.Num() && SweepEntries[i].Bounds.Min.X <= ChangedEntry.Bounds.Max.X; i++ )
+		{
+			TestSweepEntryPair( ChangedEntry, SweepEntries[i], MaxDistance, MinCrossingAngleCosine );
+		}
+	}
+
+	// Merge the changed entries into the sorted ones in a single pass
+	MergedSweepEntries.Reset( SweepEntries.Num() + ChangedSweepEntries.Num() );
+	int32 SweepEntryIndex = 0;
+	int32 ChangedEntryIndex = 0;
+	while ( SweepEntryIndex < SweepEntries.Num() || ChangedEntryIndex < ChangedSweepEntries.Num() )
+	{
+		const bool bTakeChangedEntry = SweepEntryIndex == SweepEntries.Num() ||
+			( ChangedEntryIndex < ChangedSweepEntries.Num() && ChangedSweepEntries[ChangedEntryIndex].Bounds.Min.X < SweepEntries[SweepEntryIndex].Bounds.Min.X );
+		MergedSweepEntries.Add( bTakeChangedEntry ? ChangedSweepEntries[ChangedEntryIndex++] : SweepEntries[SweepEntryIndex++] );
+	}
+	Swap( SweepEntries, MergedSweepEntries );
+
+	MaxSweepEntryExtentX = 0.0;
+	for ( const FSweepEntry& SweepEntry : SweepEntries )
+	{
+		MaxSweepEntryExtentX = FMath::Max( MaxSweepEntryExtentX, SweepEntry.Bounds.Max.X - SweepEntry.Bounds.Min.X );
+	}
+	return true;
+}
+
+void FBVPPathConflictDetector::TestSweepEntryPair( const FSweepEntry& EntryA, const FSweepEntry& EntryB, double MaxDistance, double MinCrossingAngleCosine )
+{
+	if ( EntryA.TargetList == EntryB.TargetList || !EntryA.Bounds.Intersect( EntryB.Bounds ) )
+	{
+		return;
+	}
+
+	FBVPPathConflict Conflict;
+	if ( RefineConflict( EntryA.SegmentVisualization, EntryB.SegmentVisualization, MaxDistance, MinCrossingAngleCosine, Conflict ) )
+	{
+		Conflicts.Add( FConflictRecord{ EntryA.TargetList, EntryB.TargetList, Conflict } );
+	}
+}
+
+void FBVPPathConflictDetector::GetConflicts( TArray<FBVPPathConflict>& OutConflicts ) const
+{
+	OutConflicts.Reserve( OutConflicts.Num() + Conflicts.Num() );
+	for ( const FConflictRecord& ConflictRecord : Conflicts )
+	{
+		OutConflicts.Add( ConflictRecord.Conflict );
+	}
+}
+
+void FBVPPathConflictDetector::GetPathConflicts( const AFGDrivingTargetList* TargetList, TArray<FBVPPathConflict>& OutConflicts ) const
+{
+	const TObjectKey<AFGDrivingTargetList> TargetListKey( TargetList );
+	for ( const FConflictRecord& ConflictRecord : Conflicts )
+	{
+		if ( ConflictRecord.TargetListA == TargetListKey || ConflictRecord.TargetListB == TargetListKey )
+		{
+			OutConflicts.Add( ConflictRecord.Conflict );
+		}
+	}
+}
+
+void FBVPPathConflictDetector::GetConflictingSegmentStartNodes( TMap<TObjectKey<AFGDrivingTargetList>, TArray<TObjectKey<AFGTargetPoint>>>& OutSegmentStartNodes ) const
+{
+	for ( const FConflictRecord& ConflictRecord : Conflicts )
+	{
+		OutSegmentStartNodes.FindOrAdd( ConflictRecord.TargetListA ).Add( ConflictRecord.Conflict.SegmentStartNodeA.Get() );
+		OutSegmentStartNodes.FindOrAdd( ConflictRecord.TargetListB ).Add( ConflictRecord.Conflict.SegmentStartNodeB.Get() );
+	}
+}
+
+bool FBVPPathConflictDetector::RefineConflict( const FBVPVehiclePathSegmentVisualization* SegmentA, const FBVPVehiclePathSegmentVisualization* SegmentB, double MaxDistance, double MinCrossingAngleCosine, FBVPPathConflict& OutConflict )
+{
+	const FBVPHermiteSegment HermiteSegmentA = SegmentA->GetHermiteSegment();
+	const FBVPHermiteSegment HermiteSegmentB = SegmentB->GetHermiteSegment();
+
+	double AlphaA = 0.0, AlphaB = 0.0;
+	HermiteSegmentA.FindClosestAlphas( HermiteSegmentB, AlphaA, AlphaB );
+
+	const FVector LocationA = HermiteSegmentA.EvaluatePosition( AlphaA );
+	const FVector LocationB = HermiteSegmentB.EvaluatePosition( AlphaB );
+	const double Distance = FVector::Distance( LocationA, LocationB );
+	if ( Distance > MaxDistance )
+	{
+		return false;
+	}
+
+	// Segments running at a shallow angle to each other overlap rather than cross
+	const FVector DirectionA = HermiteSegmentA.EvaluateDerivative( AlphaA ).GetSafeNormal();
+	const FVector DirectionB = HermiteSegmentB.EvaluateDerivative( AlphaB ).GetSafeNormal();
+	const double DirectionDot = FVector::DotProduct( DirectionA, DirectionB );
+
+	if ( FMath::Abs( DirectionDot ) < MinCrossingAngleCosine )
+	{
+		OutConflict.ConflictType = EBVPPathConflictType::Crossing;
+	}
+	else
+	{
+		OutConflict.ConflictType = DirectionDot < 0.0 ? EBVPPathConflictType::HeadOnOverlap : EBVPPathConflictType::SharedOverlap;
+	}
+	OutConflict.SegmentStartNodeA = SegmentA->GetStartPathNode();
+	OutConflict.SegmentStartNodeB = SegmentB->GetStartPathNode();
+	OutConflict.Location = ( LocationA + LocationB ) * 0.5;
+	OutConflict.Distance = Distance;
+	return true;
+}
@@ -0,0 +1,265 @@
+﻿// Copyright Nikita Zolotukhin. All Rights Reserved.
+
+#include "BVPPathEditHistory.h"
+#include "WheeledVehicles/FGTargetPoint.h"
+
+void FBVPPathEditRecord::SetLocations( const FVector& InOldLocation, const FVector& InNewLocation )
+{
+	OldLocation = FVector3f( InOldLocation );
+	const FVector Delta = InNewLocation - FVector( OldLocation );
+
+	// Long moves lose the low bits of the delta, which only matters when redoing them
+	LocationDeltaShift = 0;
+	while ( LocationDeltaShift < 24 && Delta.GetAbsMax() / static_cast<double>( 1 << LocationDeltaShift ) > MAX_int16 )
+	{
+		LocationDeltaShift++;
+	}
+	const double DeltaScale = 1 << LocationDeltaShift;
+	for ( int32 Axis = 0; Axis < 3; Axis++ )
+	{
+		LocationDelta[Axis] = static_cast<int16>( FMath::Clamp<int64>( FMath::RoundToInt64( Delta[Axis] / DeltaScale ), MIN_int16, MAX_int16 ) );
+	}
+}
+
+void FBVPPathEditRecord::SetRotations( const FRotator& InOldRotation, const FRotator& InNewRotation )
+{
+	const double OldAxes[3] { InOldRotation.Pitch, InOldRotation.Yaw, InOldRotation.Roll };
+	const double NewAxes[3] { InNewRotation.Pitch, InNewRotation.Yaw, InNewRotation.Roll };
+	for ( int32 Axis = 0; Axis < 3; Axis++ )
+	{
+		OldRotation[Axis] = FRotator::CompressAxisToShort( OldAxes[Axis] );
+		RotationDelta[Axis] = static_cast<int16>( FRotator::CompressAxisToShort( NewAxes[Axis] ) - OldRotation[Axis] );
+	}
+}
+
+void FBVPPathEditRecord::SetTargetSpeeds( int32 InOldTargetSpeed, int32 InNewTargetSpeed )
+{
+	// Target speeds are clamped to the maximum target speed when applied, which is far below the 16 bit range
+	OldTargetSpeed = static_cast<uint16>( FMath::Clamp<int32>( InOldTargetSpeed, 0, MAX_uint16 ) );
+	NewTargetSpeed = static_cast<uint16>( FMath::Clamp<int32>( InNewTargetSpeed, 0, MAX_uint16 ) );
+}
+
+FVector FBVPPathEditRecord::GetLocation( bool bOld ) const
+{
+	const FVector Location( OldLocation );
+	return bOld ? Location : Location + FVector( LocationDelta[0], LocationDelta[1], LocationDelta[2] ) * static_cast<double>( 1 << LocationDeltaShift );
+}
+
+FRotator FBVPPathEditRecord::GetRotation( bool bOld ) const
+{
+	uint16 Axes[3];
+	for ( int32 Axis = 0; Axis < 3; Axis++ )
+	{
+		Axes[Axis] = bOld ? OldRotation[Axis] : static_cast<uint16>( OldRotation[Axis] + RotationDelta[Axis] );
+	}
+	return FRotator( FRotator::DecompressAxisFromShort( Axes[0] ), FRotator::DecompressAxisFromShort( Axes[1] ), FRotator::DecompressAxisFromShort( Axes[2] ) );
+}
+
+int32 FBVPPathEditRecord::GetTargetSpeed( bool bOld ) const
+{
+	return bOld ? OldTargetSpeed : NewTargetSpeed;
+}
+
+FBVPPathEditHistory::FBVPPathEditHistory( int32 MaxBytes ) : Capacity( FMath::Max( MaxBytes / GetBytesPerEdit(), 1 ) )
+{
+}
+
+int32 FBVPPathEditHistory::GetBytesPerEdit()
+{
+	// Handles are compacted once there are more than two per edit, and each handle has an entry in the handle array and one in the map.
+	// The map entry is approximated by the pair along with the hash chain and bucket indices
+	constexpr int32 BytesPerHandle = sizeof( TWeakObjectPtr<AFGTargetPoint> ) + sizeof( TPair<TObjectKey<AFGTargetPoint>, int32> ) + 2 * sizeof( FSetElementId );
+	return sizeof( FBVPPathEditRecord ) + 2 * BytesPerHandle;
+}
+
+void FBVPPathEditHistory::RecordMove( AFGTargetPoint* PathNode, const FTransform& OldTransform, const FTransform& NewTransform, double Time, double CoalesceTime )
+{
+	const int32 PathNodeHandle = FindOrAddHandle( PathNode );
+
+	// Only the last edit can be coalesced, and only if nothing has been undone since it has been recorded
+	if ( NumUndoEdits > 0 && NumUndoEdits == NumEdits && Time - LastMoveTime <= CoalesceTime )
+	{
+		FBVPPathEditRecord& LastEdit = GetEdit( NumUndoEdits - 1 );
+		if ( LastEdit.EditType == EBVPPathEditType::Move && LastEdit.PathNodeHandle == PathNodeHandle )
+		{
+			LastEdit.SetLocations( LastEdit.GetLocation( true ), NewTransform.GetLocation() );
+			LastEdit.SetRotations( LastEdit.GetRotation( true ), NewTransform.Rotator() );
+			LastMoveTime = Time;
+			return;
+		}
+	}
+
+	FBVPPathEditRecord Edit;
+	Edit.EditType = EBVPPathEditType::Move;
+	Edit.PathNodeHandle = PathNodeHandle;
+	Edit.SetLocations( OldTransform.GetLocation(), NewTransform.GetLocation() );
+	Edit.SetRotations( OldTransform.Rotator(), NewTransform.Rotator() );
+	PushEdit( Edit );
+	LastMoveTime = Time;
+}
+
+void FBVPPathEditHistory::RecordTargetSpeed( AFGTargetPoint* PathNode, int32 OldTargetSpeed, int32 NewTargetSpeed )
+{
+	FBVPPathEditRecord Edit;
+	Edit.EditType = EBVPPathEditType::SetTargetSpeed;
+	Edit.PathNodeHandle = FindOrAddHandle( PathNode );
+	Edit.SetTargetSpeeds( OldTargetSpeed, NewTargetSpeed );
+	PushEdit( Edit );
+}
+
+void FBVPPathEditHistory::RecordCreate( AFGTargetPoint* PathNode, AFGTargetPoint* PrevPathNode )
+{
+	FBVPPathEditRecord Edit;
+	Edit.EditType = EBVPPathEditType::Create;
+	Edit.PathNodeHandle = FindOrAddHandle( PathNode );
+	Edit.PrevPathNodeHandle = FindOrAddHandle( PrevPathNode );
+	// Created and removed nodes have the same state before and after the edit, so either side of the edit restores it
+	Edit.SetLocations( PathNode->GetActorLocation(), PathNode->GetActorLocation() );
+	Edit.SetRotations( PathNode->GetActorRotation(), PathNode->GetActorRotation() );
+	Edit.SetTargetSpeeds( PathNode->GetTargetSpeed(), PathNode->GetTargetSpeed() );
+	PushEdit( Edit );
+}
+
+void FBVPPathEditHistory::RecordRemove( AFGTargetPoint* PathNode, AFGTargetPoint* PrevPathNode )
+{
+	FBVPPathEditRecord Edit;
+	Edit.EditType = EBVPPathEditType::Remove;
+	Edit.PathNodeHandle = FindOrAddHandle( PathNode );
+	Edit.PrevPathNodeHandle = FindOrAddHandle( PrevPathNode );
+	Edit.SetLocations( PathNode->GetActorLocation(), PathNode->GetActorLocation() );
+	Edit.SetRotations( PathNode->GetActorRotation(), PathNode->GetActorRotation() );
+	Edit.SetTargetSpeeds( PathNode->GetTargetSpeed(), PathNode->GetTargetSpeed() );
+	PushEdit( Edit );
+}
+
+const FBVPPathEditRecord* FBVPPathEditHistory::PeekUndo() const
+{
+	return NumUndoEdits > 0 ? &GetEdit( NumUndoEdits - 1 ) : nullptr;
+}
+
+const FBVPPathEditRecord* FBVPPathEditHistory::PeekRedo() const
+{
+	return NumUndoEdits < NumEdits ? &GetEdit( NumUndoEdits ) : nullptr;
+}
+
+void FBVPPathEditHistory::CommitUndo()
+{
+	fgcheck( NumUndoEdits > 0 );
+	NumUndoEdits--;
+	// Moves made after the undo should never be merged into the edit that has been undone
+	LastMoveTime = TNumericLimits<double>::Lowest();
+}
+
+void FBVPPathEditHistory::CommitRedo()
+{
+	fgcheck( NumUndoEdits < NumEdits );
+	NumUndoEdits++;
+	LastMoveTime = TNumericLimits<double>::Lowest();
+}
+
+AFGTargetPoint* FBVPPathEditHistory::ResolveHandle( int32 Handle ) const
+{
+	return PathNodeHandles.IsValidIndex( Handle ) ? PathNodeHandles[Handle].Get() : nullptr;
+}
+
+void FBVPPathEditHistory::RebindHandle( int32 Handle, AFGTargetPoint* PathNode )
+{
+	fgcheck( PathNodeHandles.IsValidIndex( Handle ) );
+	PathNodeHandles[Handle] = PathNode;
+	HandlesByPathNode.Add( PathNode, Handle );
+}
+
+int32 FBVPPathEditHistory::FindOrAddHandle( AFGTargetPoint* PathNode )
+{
+	if ( !PathNode )
+	{
+		return INDEX_NONE;
+	}
+	if ( const int32* ExistingHandle = HandlesByPathNode.Find( PathNode ) )
+	{
+		return *ExistingHandle;
+	}
+	const int32 NewHandle = PathNodeHandles.Add( PathNode );
+	HandlesByPathNode.Add( PathNode, NewHandle );
+	return NewHandle;
+}
+
+void FBVPPathEditHistory::PushEdit( const FBVPPathEditRecord& Edit )
+{
+	// New edit replaces everything that could have been redone
+	NumEdits = NumUndoEdits;
+
+	// Drop the oldest edit once the ring buffer is full
+	if ( NumEdits == Capacity )
+	{
+		FirstEditIndex = ( FirstEditIndex + 1 ) % Capacity;
+		NumEdits--;
+		NumUndoEdits--;
+	}
+
+	// The buffer grows until it reaches its capacity, and wraps around after that
+	const int32 EditIndex = ( FirstEditIndex + NumEdits ) % Capacity;
+	if ( EditIndex == Edits.Num() )
+	{
+		Edits.Add( Edit );
+	}
+	else
+	{
+		Edits[EditIndex] = Edit;
+	}
+	NumEdits++;
+	NumUndoEdits++;
+
+	// Every edit references at most two handles, so anything above that is held by the edits that have been dropped
+	if ( PathNodeHandles.Num() > Capacity * 2 )
+	{
+		CompactHandles();
+	}
+}
+
+FBVPPathEditRecord& FBVPPathEditHistory::GetEdit( int32 Index )
+{
+	return Edits[( FirstEditIndex + Index ) % Capacity];
+}
+
+const FBVPPathEditRecord& FBVPPathEditHistory::GetEdit( int32 Index ) const
+{
+	return Edits[( FirstEditIndex + Index ) % Capacity];
+}
+
+void FBVPPathEditHistory::CompactHandles()
+{
+	TArray<int32> NewHandles;
+	NewHandles.Init( INDEX_NONE, PathNodeHandles.Num() );
+
+	TArray<TWeakObjectPtr<AFGTargetPoint>> NewPathNodeHandles;
+	const auto RemapHandle = [&]( int32& Handle )
+	{
+		if ( Handle == INDEX_NONE )
+		{
+			return;
+		}
+		if ( NewHandles[Handle] == INDEX_NONE )
+		{
+			NewHandles[Handle] = NewPathNodeHandles.Add( PathNodeHandles[Handle] );
+		}
+		Handle = NewHandles[Handle];
+	};
+
+	for ( int32 Index = 0; Index < NumEdits; Index++ )
+	{
+		FBVPPathEditRecord& Edit = GetEdit( Index );
+		RemapHandle( Edit.PathNodeHandle );
+		RemapHandle( Edit.PrevPathNodeHandle );
+	}
+	PathNodeHandles = MoveTemp( NewPathNodeHandles );
+
+	HandlesByPathNode.Reset();
+	for ( int32 Handle = 0; Handle < PathNodeHandles.Num(); Handle++ )
+	{
+		if ( AFGTargetPoint* PathNode = PathNodeHandles[Handle].Get() )
+		{
+			HandlesByPathNode.Add( PathNode, Handle );
+		}
+	}
+}
@@ -0,0 +1,235 @@
+﻿// Copyright Nikita Zolotukhin. All Rights Reserved.
+
+#include "BVPPathExport.h"
+#include "BVPSubsystem.h"
+#include "WheeledVehicles/FGTargetPoint.h"
+#include "WheeledVehicles/FGTargetPointLinkedList.h"
+
+void FBVPPathArchive::ExportPath( const AFGDrivingTargetList* TargetList, FBVPExportedPath& OutPath )
+{
+	TArray<AFGTargetPoint*> PathNodes;
+	UBVPSubsystem::GetTargetListPathNodes( TargetList, PathNodes );
+
+	OutPath.PathNodes.Reset( PathNodes.Num() );
+	for ( const AFGTargetPoint* PathNode : PathNodes )
+	{
+		FBVPExportedPathNode& ExportedPathNode = OutPath.PathNodes.AddDefaulted_GetRef();
+		ExportedPathNode.Location = PathNode->GetActorLocation();
+		ExportedPathNode.Rotation = PathNode->GetActorRotation();
+		ExportedPathNode.TargetSpeed = PathNode->GetTargetSpeed();
+	}
+}
+
+void FBVPPathArchive::Encode( const TArray<FBVPExportedPath>& Paths, TArray<uint8>& OutData )
+{
+	OutData.Reset();
+	for ( int32 ByteIndex = 0; ByteIndex < 4; ByteIndex++ )
+	{
+		OutData.Add( ( Magic >> ( ByteIndex * 8 ) ) & 0xFF );
+	}
+	OutData.Add( static_cast<uint8>( EVersion::Latest ) );
+	WriteVarUInt( OutData, Paths.Num() );
+
+	for ( const FBVPExportedPath& Path : Paths )
+	{
+		WriteVarUInt( OutData, Path.PathNodes.Num() );
+
+		// Deltas are taken between the quantized values so that the rounding errors do not accumulate along the path
+		FInt64Vector PrevLocation( 0, 0, 0 );
+		uint16 PrevYaw = 0, PrevPitch = 0, PrevRoll = 0;
+		int32 PrevTargetSpeed = 0;
+
+		for ( const FBVPExportedPathNode& PathNode : Path.PathNodes )
+		{
+			const FInt64Vector Location( FMath::RoundToInt64( PathNode.Location.X / LocationQuantum ), FMath::RoundToInt64( PathNode.Location.Y / LocationQuantum ), FMath::RoundToInt64( PathNode.Location.Z / LocationQuantum ) );
+			const uint16 Yaw = FRotator::CompressAxisToShort( PathNode.Rotation.Yaw );
+			const uint16 Pitch = FRotator::CompressAxisToShort( PathNode.Rotation.Pitch );
+			const uint16 Roll = FRotator::CompressAxisToShort( PathNode.Rotation.Roll );
+
+			uint8 NodeFlags = static_cast<uint8>( ENodeFlags::None );
+			if ( Pitch != PrevPitch || Roll != PrevRoll )
+			{
+				NodeFlags |= static_cast<uint8>( ENodeFlags::HasPitchAndRoll );
+			}
+			if ( PathNode.TargetSpeed != PrevTargetSpeed )
+			{
+				NodeFlags |= static_cast<uint8>( ENodeFlags::HasTargetSpeed );
+			}
+			OutData.Add( NodeFlags );
+
+			WriteVarInt( OutData, Location.X - PrevLocation.X );
+			WriteVarInt( OutData, Location.Y - PrevLocation.Y );
+			WriteVarInt( OutData, Location.Z - PrevLocation.Z );
+			// Wrapping the delta to 16 bits keeps the turns across the 180 degree boundary small
+			WriteVarInt( OutData, static_cast<int16>( Yaw - PrevYaw ) );
+
+			if ( NodeFlags & static_cast<uint8>( ENodeFlags::HasPitchAndRoll ) )
+			{
+				WriteVarInt( OutData, static_cast<int16>( Pitch - PrevPitch ) );
+				WriteVarInt( OutData, static_cast<int16>( Roll - PrevRoll ) );
+			}
+			if ( NodeFlags & static_cast<uint8>( ENodeFlags::HasTargetSpeed ) )
+			{
+				WriteVarInt( OutData, PathNode.TargetSpeed - PrevTargetSpeed );
+			}
+
+			PrevLocation = Location;
+			PrevYaw = Yaw;
+			PrevPitch = Pitch;
+			PrevRoll = Roll;
+			PrevTargetSpeed = PathNode.TargetSpeed;
+		}
+	}
+}
+
+bool FBVPPathArchive::Decode( const TArray<uint8>& Data, TArray<FBVPExportedPath>& OutPaths )
+{
+	OutPaths.Reset();
+
+	// Magic followed by the version
+	if ( Data.Num() < 5 )
+	{
+		return false;
+	}
+	uint32 DataMagic = 0;
+	for ( int32 ByteIndex = 0; ByteIndex < 4; ByteIndex++ )
+	{
+		DataMagic |= static_cast<uint32>( Data[ByteIndex] ) << ( ByteIndex * 8 );
+	}
+	const uint8 Version = Data[4];
+	if ( DataMagic != Magic || Version < static_cast<uint8>( EVersion::Initial ) || Version > static_cast<uint8>( EVersion::Latest ) )
+	{
+		return false;
+	}
+	int32 Offset = 5;
+
+	// Values are read from untrusted data, so they are range checked before any arithmetic on them instead of using FMath::Abs, which overflows on the smallest value
+	const auto IsWithinRange = []( int64 Value, int64 Limit ) { return Value >= -Limit && Value <= Limit; };
+
+	// Every path takes at least one byte and every node at least 5 bytes, which bounds the counts before we allocate anything for them
+	uint64 NumPaths = 0;
+	if ( !ReadVarUInt( Data, Offset, NumPaths ) || NumPaths > static_cast<uint64>( Data.Num() - Offset ) )
+	{
+		return false;
+	}
+	OutPaths.Reserve( NumPaths );
+
+	for ( uint64 PathIndex = 0; PathIndex < NumPaths; PathIndex++ )
+	{
+		uint64 NumPathNodes = 0;
+		if ( !ReadVarUInt( Data, Offset, NumPathNodes ) || NumPathNodes > static_cast<uint64>( Data.Num() - Offset ) / 5 )
+		{
+			return false;
+		}
+		FBVPExportedPath& Path = OutPaths.AddDefaulted_GetRef();
+		Path.PathNodes.Reserve( NumPathNodes );
+
+		FInt64Vector Location( 0, 0, 0 );
+		uint16 Yaw = 0, Pitch = 0, Roll = 0;
+		int64 TargetSpeed = 0;
+
+		for ( uint64 NodeIndex = 0; NodeIndex < NumPathNodes; NodeIndex++ )
+		{
+			if ( Offset >= Data.Num() )
+			{
+				return false;
+			}
+			const uint8 NodeFlags = Data[Offset++];
+
+			int64 DeltaX = 0, DeltaY = 0, DeltaZ = 0, DeltaYaw = 0;
+			if ( !ReadVarInt( Data, Offset, DeltaX ) || !ReadVarInt( Data, Offset, DeltaY ) || !ReadVarInt( Data, Offset, DeltaZ ) || !ReadVarInt( Data, Offset, DeltaYaw ) )
+			{
+				return false;
+			}
+			// Both the delta and the accumulated location are bounded by the world, so the sum can never overflow
+			constexpr int64 MaxDelta = 2 * MaxQuantizedCoordinate;
+			if ( !IsWithinRange( DeltaX, MaxDelta ) || !IsWithinRange( DeltaY, MaxDelta ) || !IsWithinRange( DeltaZ, MaxDelta ) )
+			{
+				return false;
+			}
+			Location += FInt64Vector( DeltaX, DeltaY, DeltaZ );
+			if ( !IsWithinRange( Location.X, MaxQuantizedCoordinate ) || !IsWithinRange( Location.Y, MaxQuantizedCoordinate ) || !IsWithinRange( Location.Z, MaxQuantizedCoordinate ) )
+			{
+				return false;
+			}
+			Yaw += static_cast<uint16>( DeltaYaw );
+
+			if ( NodeFlags & static_cast<uint8>( ENodeFlags::HasPitchAndRoll ) )
+			{
+				int64 DeltaPitch = 0, DeltaRoll = 0;
+				if ( !ReadVarInt( Data, Offset, DeltaPitch ) || !ReadVarInt( Data, Offset, DeltaRoll ) )
+				{
+					return false;
+				}
+				Pitch += static_cast<uint16>( DeltaPitch );
+				Roll += static_cast<uint16>( DeltaRoll );
+			}
+			if ( NodeFlags & static_cast<uint8>( ENodeFlags::HasTargetSpeed ) )
+			{
+				int64 DeltaTargetSpeed = 0;
+				if ( !ReadVarInt( Data, Offset, DeltaTargetSpeed ) || !IsWithinRange( DeltaTargetSpeed, 2 * static_cast<int64>( MAX_int32 ) ) )
+				{
+					return false;
+				}
+				TargetSpeed += DeltaTargetSpeed;
+				if ( TargetSpeed < MIN_int32 || TargetSpeed > MAX_int32 )
+				{
+					return false;
+				}
+			}
+
+			FBVPExportedPathNode& PathNode = Path.PathNodes.AddDefaulted_GetRef();
+			PathNode.Location = FVector( Location.X, Location.Y, Location.Z ) * LocationQuantum;
+			PathNode.Rotation = FRotator( FRotator::DecompressAxisFromShort( Pitch ), FRotator::DecompressAxisFromShort( Yaw ), FRotator::DecompressAxisFromShort( Roll ) );
+			PathNode.TargetSpeed = static_cast<int32>( TargetSpeed );
+		}
+	}
+	return Offset == Data.Num();
+}
+
+void FBVPPathArchive::WriteVarUInt( TArray<uint8>& Data, uint64 Value )
+{
+	while ( Value >= 0x80 )
+	{
+		Data.Add( static_cast<uint8>( Value & 0x7F ) | 0x80 );
+		Value >>= 7;
+	}
+	Data.Add( static_cast<uint8>( Value ) );
+}
+
+void FBVPPathArchive::WriteVarInt( TArray<uint8>& Data, int64 Value )
+{
+	// Zigzag encoding maps small negative values to small positive ones, so that they take as few bytes as the positive ones
+	WriteVarUInt( Data, ( static_cast<uint64>( Value ) << 1 ) ^ static_cast<uint64>( Value >> 63 ) );
+}
+
+bool FBVPPathArchive::ReadVarUInt( const TArray<uint8>& Data, int32& Offset, uint64& OutValue )
+{
+	OutValue = 0;
+	for ( int32 Shift = 0; Shift < 64; Shift += 7 )
+	{
+		if ( Offset >= Data.Num() )
+		{
+			return false;
+		}
+		const uint8 Byte = Data[Offset++];
+		OutValue |= static_cast<uint64>( Byte & 0x7F ) << Shift;
+
+		if ( ( Byte & 0x80 ) == 0 )
+		{
+			return true;
+		}
+	}
+	return false;
+}
+
+bool FBVPPathArchive::ReadVarInt( const TArray<uint8>& Data, int32& Offset, int64& OutValue )
+{
+	uint64 EncodedValue = 0;
+	if ( !ReadVarUInt( Data, Offset, EncodedValue ) )
+	{
+		return false;
+	}
+	OutValue = static_cast<int64>( EncodedValue >> 1 ) ^ -static_cast<int64>( EncodedValue & 1 );
+	return true;
+}
@@ -0,0 +1,314 @@
+﻿// Copyright Nikita Zolotukhin. All Rights Reserved.
+
+#include "BVPPathNodeSpatialIndex.h"
+#include "WheeledVehicles/FGTargetPoint.h"
+#include "WheeledVehicles/FGTargetPointLinkedList.h"
+
+FBVPPathNodeSpatialIndex::FBVPPathNodeSpatialIndex( double InCellSize ) : CellSize( FMath::Max( InCellSize, 1.0 ) )
+{
+}
+
+void FBVPPathNodeSpatialIndex::SetCellSize( double NewCellSize )
+{
+	NewCellSize = FMath::Max( NewCellSize, 1.0 );
+	if ( NewCellSize == CellSize )
+	{
+		return;
+	}
+	CellSize = NewCellSize;
+
+	// Re-bucket all the nodes at their last known locations
+	Cells.Reset();
+	for ( TPair<TObjectKey<AFGTargetPoint>, FIndexedPathNode>& Pair : IndexedPathNodes )
+	{
+		Pair.Value.Cell = GetCellForLocation( Pair.Value.Location );
+		Cells.FindOrAdd( Pair.Value.Cell ).Add( Pair.Key );
+	}
+}
+
+void FBVPPathNodeSpatialIndex::UpdatePathNode( AFGTargetPoint* PathNode )
+{
+	if ( !PathNode || !PathNode->GetOwningList() )
+	{
+		return;
+	}
+	const TObjectKey<AFGTargetPoint> PathNodeKey( PathNode );
+	const TObjectKey<AFGDrivingTargetList> TargetListKey( PathNode->GetOwningList() );
+	const FVector NewLocation = PathNode->GetActorLocation();
+	const FIntVector NewCell = GetCellForLocation( NewLocation );
+
+	if ( FIndexedPathNode* IndexedPathNode = IndexedPathNodes.Find( PathNodeKey ) )
+	{
+		if ( IndexedPathNode->Cell != NewCell )
+		{
+			RemoveNodeFromCell( PathNodeKey, IndexedPathNode->Cell );
+			Cells.FindOrAdd( NewCell ).Add( PathNodeKey );
+			IndexedPathNode->Cell = NewCell;
+		}
+		IndexedPathNode->Location = NewLocation;
+
+		if ( IndexedPathNode->TargetList == TargetListKey )
+		{
+			return;
+		}
+
+		// Node has been moved to another target list
+		if ( FIndexedTargetList* OldTargetList = IndexedTargetLists.Find( IndexedPathNode->TargetList ) )
+		{
+			OldTargetList->PathNodes.RemoveSingleSwap( PathNodeKey );
+		}
+		IndexedPathNode->TargetList = TargetListKey;
+	}
+	else
+	{
+		FIndexedPathNode& NewPathNode = IndexedPathNodes.Add( PathNodeKey );
+		NewPathNode.PathNode = PathNode;
+		NewPathNode.TargetList = TargetListKey;
+		NewPathNode.Location = NewLocation;
+		NewPathNode.Cell = NewCell;
+		Cells.FindOrAdd( NewCell ).Add( PathNodeKey );
+	}
+
+	FIndexedTargetList& IndexedTargetList = IndexedTargetLists.FindOrAdd( TargetListKey );
+	IndexedTargetList.TargetList = PathNode->GetOwningList();
+	IndexedTargetList.PathNodes.Add( PathNodeKey );
+}
+
+void FBVPPathNodeSpatialIndex::RemovePathNode( const AFGTargetPoint* PathNode )
+{
+	const TObjectKey<AFGTargetPoint> PathNodeKey( PathNode );
+
+	FIndexedPathNode IndexedPathNode;
+	if ( IndexedPathNodes.RemoveAndCopyValue( PathNodeKey, IndexedPathNode ) )
+	{
+		RemoveNodeFromCell( PathNodeKey, IndexedPathNode.Cell );
+
+		if ( FIndexedTargetList* IndexedTargetList = IndexedTargetLists.Find( IndexedPathNode.TargetList ) )
+		{
+			IndexedTargetList->PathNodes.RemoveSingleSwap( PathNodeKey );
+		}
+	}
+}
+
+void FBVPPathNodeSpatialIndex::SyncTargetList( AFGDrivingTargetList* TargetList, int32 GeometryGeneration )
+{
+	fgcheck( TargetList );
+	const TObjectKey<AFGDrivingTargetList> TargetListKey( TargetList );
+
+	if ( const FIndexedTargetList* ExistingTargetList = IndexedTargetLists.Find( TargetListKey ) )
+	{
+		if ( ExistingTargetList->GeometryGeneration == GeometryGeneration )
+		{
+			return;
+		}
+	}
+
+	// Update all nodes currently in the list, remembering which of them we have seen
+	TSet<TObjectKey<AFGTargetPoint>> CurrentPathNodes;
+	for ( AFGTargetPoint* PathNode = TargetList->GetFirstTarget(); PathNode; PathNode = PathNode->GetNext() )
+	{
+		if ( PathNode->GetOwningList() == TargetList )
+		{
+			UpdatePathNode( PathNode );
+			CurrentPathNodes.Add( PathNode );
+		}
+	}
+
+	FIndexedTargetList& IndexedTargetList = IndexedTargetLists.FindOrAdd( TargetListKey );
+	IndexedTargetList.TargetList = TargetList;
+	IndexedTargetList.GeometryGeneration = GeometryGeneration;
+
+	// Drop the nodes that have been removed from the list
+	for ( int32 i = IndexedTargetList.PathNodes.Num() - 1; i >= 0; i-- )
+	{
+		const TObjectKey<AFGTargetPoint> PathNodeKey = IndexedTargetList.PathNodes[i];
+		if ( !CurrentPathNodes.Contains( PathNodeKey ) )
+		{
+			FIndexedPathNode IndexedPathNode;
+			if ( IndexedPathNodes.RemoveAndCopyValue( PathNodeKey, IndexedPathNode ) )
+			{
+				RemoveNodeFromCell( PathNodeKey, IndexedPathNode.Cell );
+			}
+			IndexedTargetList.PathNodes.RemoveAtSwap( i );
+		}
+	}
+}
+
+void FBVPPathNodeSpatialIndex::RemoveStaleTargetLists()
+{
+	for ( auto It = IndexedTargetLists.CreateIterator(); It; ++It )
+	{
+		if ( !It.Value().TargetList.IsValid() )
+		{
+			for ( const TObjectKey<AFGTargetPoint>& PathNodeKey : It.Value().PathNodes )
+			{
+				FIndexedPathNode IndexedPathNode;
+				if ( IndexedPathNodes.RemoveAndCopyValue( PathNodeKey, IndexedPathNode ) )
+				{
+					RemoveNodeFromCell( PathNodeKey, IndexedPathNode.Cell );
+				}
+			}
+			It.RemoveCurrent();
+		}
+	}
+}
+
+template<typename TCallback>
+void FBVPPathNodeSpatialIndex::ForEachPathNodeInBox( const FBox& Box, TCallback&& Callback ) const
+{
+	if ( !Box.IsValid )
+	{
+		return;
+	}
+	const auto VisitCell = [&]( const TArray<TObjectKey<AFGTargetPoint>>& CellPathNodes )
+	{
+		for ( const TObjectKey<AFGTargetPoint>& PathNodeKey : CellPathNodes )
+		{
+			const FIndexedPathNode& IndexedPathNode = IndexedPathNodes.FindChecked( PathNodeKey );
+			if ( IndexedPathNode.PathNode.IsValid() )
+			{
+				Callback( IndexedPathNode );
+			}
+		}
+	};
+
+	const FIntVector MinCell = GetCellForLocation( Box.Min );
+	const FIntVector MaxCell = GetCellForLocation( Box.Max );
+	const int64 NumCellsInBox = (int64) ( MaxCell.X - MinCell.X + 1 ) * ( MaxCell.Y - MinCell.Y + 1 ) * ( MaxCell.Z - MinCell.Z + 1 );
+
+	// Large boxes are cheaper to resolve by checking every populated cell instead
+	if ( NumCellsInBox > Cells.Num() )
+	{
+		for ( const TPair<FIntVector, TArray<TObjectKey<AFGTargetPoint>>>& Pair : Cells )
+		{
+			const FIntVector& Cell = Pair.Key;
+			if ( Cell.X >= MinCell.X && Cell.X <= MaxCell.X && Cell.Y >= MinCell.Y && Cell.Y <= MaxCell.Y && Cell.Z >= MinCell.Z && Cell.Z <= MaxCell.Z )
+			{
+				VisitCell( Pair.Value );
+			}
+		}
+		return;
+	}
+
+	for ( int32 X = MinCell.X; X <= MaxCell.X; X++ )
+	{
+		for ( int32 Y = MinCell.Y; Y <= MaxCell.Y; Y++ )
+		{
+			for ( int32 Z = MinCell.Z; Z <= MaxCell.Z; Z++ )
+			{
+				if ( const TArray<TObjectKey<AFGTargetPoint>>* CellPathNodes = Cells.Find( FIntVector( X, Y, Z ) ) )
+				{
+					VisitCell( *CellPathNodes );
+				}
+			}
+		}
+	}
+}
+
+AFGTargetPoint* FBVPPathNodeSpatialIndex::FindNearestPathNode( const FVector& Location, double MaxDistance ) const
+{
+	AFGTargetPoint* NearestPathNode = nullptr;
+	double NearestDistanceSquared = FMath::Square( MaxDistance );
+
+	const auto VisitCell = [&]( const TArray<TObjectKey<AFGTargetPoint>>& CellPathNodes )
+	{
+		for ( const TObjectKey<AFGTargetPoint>& PathNodeKey : CellPathNodes )
+		{
+			const FIndexedPathNode& IndexedPathNode = IndexedPathNodes.FindChecked( PathNodeKey );
+			const double DistanceSquared = FVector::DistSquared( IndexedPathNode.Location, Location );
+
+			if ( DistanceSquared <= NearestDistanceSquared && IndexedPathNode.PathNode.IsValid() )
+			{
+				NearestPathNode = IndexedPathNode.PathNode.Get();
+				NearestDistanceSquared = DistanceSquared;
+			}
+		}
+	};
+
+	// Visit the cells in expanding shells around the cell containing the location. Nodes outside of the visited shells are at least (Ring - 1) cells away
+	const FIntVector CenterCell = GetCellForLocation( Location );
+	const int32 MaxRing = (int32) FMath::Min( FMath::CeilToDouble( MaxDistance / CellSize ), (double) MAX_int16 );
+
+	for ( int32 Ring = 0; Ring <= MaxRing; Ring++ )
+	{
+		if ( NearestPathNode && FMath::Square( ( Ring - 1 ) * CellSize ) >= NearestDistanceSquared )
+		{
+			break;
+		}
+
+		// Shell has more cells than there are populated cells in total, so it is cheaper to just check all of them
+		const int64 ShellSideLength = 2 * Ring + 1;
+		if ( ShellSideLength * ShellSideLength * ShellSideLength > Cells.Num() )
+		{
+			for ( const TPair<FIntVector, TArray<TObjectKey<AFGTargetPoint>>>& Pair : Cells )
+			{
+				VisitCell( Pair.Value );
+			}
+			break;
+		}
+
+		for ( int32 X = -Ring; X <= Ring; X++ )
+		{
+			for ( int32 Y = -Ring; Y <= Ring; Y++ )
+			{
+				// Only the outer faces of the cube belong to the shell
+				const bool bOnShellSide = FMath::Abs( X ) == Ring || FMath::Abs( Y ) == Ring;
+				const int32 StepZ = bOnShellSide ? 1 : FMath::Max( 2 * Ring, 1 );
+
+				for ( int32 Z = -Ring; Z <= Ring; Z += StepZ )
+				{
+					if ( const TArray<TObjectKey<AFGTargetPoint>>* CellPathNodes = Cells.Find( CenterCell + FIntVector( X, Y, Z ) ) )
+					{
+						VisitCell( *CellPathNodes );
+					}
+				}
+			}
+		}
+	}
+	return NearestPathNode;
+}
+
+void FBVPPathNodeSpatialIndex::FindPathNodesInRadius( const FVector& Location, double Radius, TArray<AFGTargetPoint*>& OutPathNodes ) const
+{
+	const double RadiusSquared = FMath::Square( Radius );
+	ForEachPathNodeInBox( FBox( Location - FVector( Radius ), Location + FVector( Radius ) ), [&]( const FIndexedPathNode& IndexedPathNode )
+	{
+		if ( FVector::DistSquared( IndexedPathNode.Location, Location ) <= RadiusSquared )
+		{
+			OutPathNodes.Add( IndexedPathNode.PathNode.Get() );
+		}
+	} );
+}
+
+void FBVPPathNodeSpatialIndex::FindPathNodesInBox( const FBox& Box, TArray<AFGTargetPoint*>& OutPathNodes ) const
+{
+	ForEachPathNodeInBox( Box, [&]( const FIndexedPathNode& IndexedPathNode )
+	{
+		if ( Box.IsInsideOrOn( IndexedPathNode.Location ) )
+		{
+			OutPathNodes.Add( IndexedPathNode.PathNode.Get() );
+		}
+	} );
+}
+
+FIntVector FBVPPathNodeSpatialIndex::GetCellForLocation( const FVector& Location ) const
+{
+	// Clamp to avoid overflowing the cell coordinates for degenerate locations
+	const auto ToCellCoordinate = [&]( double Coordinate )
+	{
+		return (int32) FMath::Clamp( FMath::FloorToDouble( Coordinate / CellSize ), (double) MIN_int32 / 2, (double) MAX_int32 / 2 );
+	};
+	return FIntVector( ToCellCoordinate( Location.X ), ToCellCoordinate( Location.Y ), ToCellCoordinate( Location.Z ) );
+}
+
+void FBVPPathNodeSpatialIndex::RemoveNodeFromCell( const TObjectKey<AFGTargetPoint>& PathNodeKey, const FIntVector& Cell )
+{
+	if ( TArray<TObjectKey<AFGTargetPoint>>* CellPathNodes = Cells.Find( Cell ) )
+	{
+		CellPathNodes->RemoveSingleSwap( PathNodeKey );
+		if ( CellPathNodes->IsEmpty() )
+		{
+			Cells.Remove( Cell );
+		}
+	}
+}
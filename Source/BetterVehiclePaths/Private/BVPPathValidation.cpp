@@ -0,0 +1,188 @@
+﻿// Copyright Nikita Zolotukhin. All Rights Reserved.
+
+#include "BVPPathValidation.h"
+#include "BVPSettings.h"
+#include "Math/VectorRegister.h"
+#include "WheeledVehicles/FGTargetPoint.h"
+#include "WheeledVehicles/FGTargetPointLinkedList.h"
+
+FBVPPathValidationLimits FBVPPathValidationLimits::FromSettings()
+{
+	const UBVPSettings* BVPSettings = UBVPSettings::Get();
+
+	FBVPPathValidationLimits Limits;
+	Limits.MinDistanceBetweenPathNodes = BVPSettings->MinDistanceBetweenPathNodes;
+	Limits.MaxDistanceBetweenPathNodes = BVPSettings->MaxDistanceBetweenPathNodes;
+	Limits.MinTargetSpeed = 0;
+	Limits.MaxTargetSpeed = BVPSettings->MaxTargetSpeed;
+	return Limits;
+}
+
+void FBVPPackedPathNodes::Pack( AFGDrivingTargetList* TargetList, TArray<FBVPPathViolation>& OutViolations )
+{
+	const auto AddBrokenLink = [&]( AFGTargetPoint* PathNode, AFGTargetPoint* OtherPathNode )
+	{
+		FBVPPathViolation& Violation = OutViolations.AddDefaulted_GetRef();
+		Violation.ViolationType = EBVPPathViolationType::BrokenLink;
+		Violation.TargetList = TargetList;
+		Violation.PathNode = PathNode;
+		Violation.OtherPathNode = OtherPathNode;
+	};
+
+	const int32 ExpectedNumPathNodes = TargetList->HasData() ? TargetList->GetTargetCount() : 0;
+	PathNodes.Reset( ExpectedNumPathNodes );
+	LocationsX.Reset( ExpectedNumPathNodes );
+	LocationsY.Reset( ExpectedNumPathNodes );
+	LocationsZ.Reset( ExpectedNumPathNodes );
+	TargetSpeeds.Reset( ExpectedNumPathNodes );
+
+	// A node that is visited twice means that the list loops back onto itself, so stop there instead of walking forever
+	TSet<const AFGTargetPoint*> VisitedPathNodes;
+	VisitedPathNodes.Reserve( ExpectedNumPathNodes );
+
+	AFGTargetPoint* PrevPathNode = nullptr;
+	for ( AFGTargetPoint* PathNode = TargetList->GetFirstTarget(); PathNode; PathNode = PathNode->GetNext() )
+	{
+		bool bAlreadyVisited = false;
+		VisitedPathNodes.Add( PathNode, &bAlreadyVisited );
+		if ( bAlreadyVisited )
+		{
+			AddBrokenLink( PrevPathNode, PathNode );
+			break;
+		}
+		if ( PathNode->GetOwningList() != TargetList )
+		{
+			AddBrokenLink( PathNode, nullptr );
+		}
+
+		const FVector Location = PathNode->GetActorLocation();
+		PathNodes.Add( PathNode );
+		LocationsX.Add( Location.X );
+		LocationsY.Add( Location.Y );
+		LocationsZ.Add( Location.Z );
+		TargetSpeeds.Add( PathNode->GetTargetSpeed() );
+		PrevPathNode = PathNode;
+	}
+
+	// The walk should end at the last node of the list after visiting the number of nodes the list thinks it has
+	if ( PrevPathNode != TargetList->GetLastTarget() || ( TargetList->HasData() && PathNodes.Num() != ExpectedNumPathNodes ) )
+	{
+		AddBrokenLink( PrevPathNode, TargetList->GetLastTarget() );
+	}
+}
+
+bool FBVPPathValidator::ValidatePath( AFGDrivingTargetList* TargetList, const FBVPPathValidationLimits& Limits, TArray<FBVPPathViolation>& OutViolations )
+{
+	fgcheck( TargetList );
+	const int32 NumViolationsBefore = OutViolations.Num();
+
+	FBVPPackedPathNodes PackedPathNodes;
+	PackedPathNodes.Pack( TargetList, OutViolations );
+	ValidatePackedPathNodes( TargetList, PackedPathNodes, Limits, OutViolations );
+
+	for ( int32 i = NumViolationsBefore; i < OutViolations.Num(); i++ )
+	{
+		if ( OutViolations[i].Severity == EBVPPathViolationSeverity::Error )
+		{
+			return false;
+		}
+	}
+	return true;
+}
+
+void FBVPPathValidator::ValidatePackedPathNodes( AFGDrivingTargetList* TargetList, const FBVPPackedPathNodes& PackedPathNodes, const FBVPPathValidationLimits& Limits, TArray<FBVPPathViolation>& OutViolations )
+{
+	const int32 NumPathNodes = PackedPathNodes.PathNodes.Num();
+	if ( NumPathNodes < 2 )
+	{
+		return;
+	}
+
+	const auto AddViolation = [&]( EBVPPathViolationType ViolationType, int32 NodeIndex, int32 OtherNodeIndex, float Value )
+	{
+		FBVPPathViolation& Violation = OutViolations.AddDefaulted_GetRef();
+		Violation.ViolationType = ViolationType;
+		Violation.Severity = ViolationType == EBVPPathViolationType::NodesTooClose ? EBVPPathViolationSeverity::Warning : EBVPPathViolationSeverity::Error;
+		Violation.TargetList = TargetList;
+		Violation.PathNode = PackedPathNodes.PathNodes[NodeIndex];
+		Violation.OtherPathNode = OtherNodeIndex != INDEX_NONE ? PackedPathNodes.PathNodes[OtherNodeIndex] : nullptr;
+		Violation.Value = Value;
+	};
+
+	// Pad the locations up to the whole number of batches plus one, so that the batch of next locations can always be loaded.
+	// The path is a loop, so the padding repeats the nodes from the start, and the node after the last one is the first one
+	const int32 NumPaddedLocations = Align( NumPathNodes, 4 ) + 4;
+	TArray<double> PaddedLocations[3];
+	const TArray<double>* SourceLocations[3] { &PackedPathNodes.LocationsX, &PackedPathNodes.LocationsY, &PackedPathNodes.LocationsZ };
+	for ( int32 Component = 0; Component < 3; Component++ )
+	{
+		PaddedLocations[Component].SetNumUninitialized( NumPaddedLocations );
+		for ( int32 i = 0; i < NumPaddedLocations; i++ )
+		{
+			PaddedLocations[Component][i] = ( *SourceLocations[Component] )[i % NumPathNodes];
+		}
+	}
+
+	const VectorRegister4Double MinDistanceSquared = VectorSetFloat1( FMath::Square( Limits.MinDistanceBetweenPathNodes ) );
+	const VectorRegister4Double MaxDistanceSquared = VectorSetFloat1( FMath::Square( Limits.MaxDistanceBetweenPathNodes ) );
+
+	// Squared distances to the next node for 4 nodes at a time. Scalar code only runs for the lanes that have actually violated a limit
+	for ( int32 BatchStart = 0; BatchStart < NumPathNodes; BatchStart += 4 )
+	{
+		VectorRegister4Double DistanceSquared = VectorZeroDouble();
+		for ( int32 Component = 0; Component < 3; Component++ )
+		{
+			const VectorRegister4Double Locations = VectorLoad( &PaddedLocations[Component][BatchStart] );
+			const VectorRegister4Double NextLocations = VectorLoad( &PaddedLocations[Component][BatchStart + 1] );
+			const VectorRegister4Double Delta = VectorSubtract( NextLocations, Locations );
+			DistanceSquared = VectorMultiplyAdd( Delta, Delta, DistanceSquared );
+		}
+
+		const int32 BatchMask = ( 1 << FMath::Min( 4, NumPathNodes - BatchStart ) ) - 1;
+		const int32 TooFarMask = VectorMaskBits( VectorCompareGT( DistanceSquared, MaxDistanceSquared ) ) & BatchMask;
+		const int32 TooCloseMask = VectorMaskBits( VectorCompareLT( DistanceSquared, MinDistanceSquared ) ) & BatchMask;
+
+		if ( ( TooFarMask | TooCloseMask ) != 0 )
+		{
+			double BatchDistanceSquared[4];
+			VectorStore( DistanceSquared, BatchDistanceSquared );
+
+			for ( int32 Lane = 0; Lane < 4; Lane++ )
+			{
+				const int32 NodeIndex = BatchStart + Lane;
+				if ( TooFarMask & ( 1 << Lane ) )
+				{
+					AddViolation( EBVPPathViolationType::NodesTooFar, NodeIndex, ( NodeIndex + 1 ) % NumPathNodes, FMath::Sqrt( BatchDistanceSquared[Lane] ) );
+				}
+				else if ( TooCloseMask & ( 1 << Lane ) )
+				{
+					AddViolation( EBVPPathViolationType::NodesTooClose, NodeIndex, ( NodeIndex + 1 ) % NumPathNodes, FMath::Sqrt( BatchDistanceSquared[Lane] ) );
+				}
+			}
+		}
+	}
+
+	// Duplicates are found by hashing the locations rounded to whole units. Adjacent duplicates are reported too, as an error on top of the too close warning,
+	// since they leave a segment with no length
+	TMap<FIntVector, int32> PathNodesByLocation;
+	PathNodesByLocation.Reserve( NumPathNodes );
+	for ( int32 NodeIndex = 0; NodeIndex < NumPathNodes; NodeIndex++ )
+	{
+		const FIntVector RoundedLocation( FMath::RoundToInt( PackedPathNodes.LocationsX[NodeIndex] ), FMath::RoundToInt( PackedPathNodes.LocationsY[NodeIndex] ), FMath::RoundToInt( PackedPathNodes.LocationsZ[NodeIndex] ) );
+		if ( const int32* OtherNodeIndex = PathNodesByLocation.Find( RoundedLocation ) )
+		{
+			AddViolation( EBVPPathViolationType::DuplicateNode, NodeIndex, *OtherNodeIndex, 0.0f );
+			continue;
+		}
+		PathNodesByLocation.Add( RoundedLocation, NodeIndex );
+	}
+
+	for ( int32 NodeIndex = 0; NodeIndex < NumPathNodes; NodeIndex++ )
+	{
+		const int32 TargetSpeed = PackedPathNodes.TargetSpeeds[NodeIndex];
+		if ( TargetSpeed < Limits.MinTargetSpeed || TargetSpeed > Limits.MaxTargetSpeed )
+		{
+			AddViolation( EBVPPathViolationType::TargetSpeedOutOfRange, NodeIndex, INDEX_NONE, TargetSpeed );
+		}
+	}
+}
@@ -7,3 +7,13 @@ ABVPPathVisualizationActor::ABVPPathVisualizationActor()
 	RootComponent = CreateDefaultSubobject<USceneComponent>( TEXT("Root") );
 	RootComponent->SetMobility( EComponentMobility::Movable );
 }
+
+void ABVPPathVisualizationActor::DestroyVisualizationComponent( UPrimitiveComponent* Component )
+{
+	if ( !IsValid( Component ) || Component->IsBeingDestroyed() )
+	{
+		return;
+	}
+	Component->DestroyComponent();
+	NumVisualizationComponents--;
+}
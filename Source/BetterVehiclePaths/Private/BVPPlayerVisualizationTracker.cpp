@@ -6,11 +6,14 @@
 #include "BVPVehiclePathSegmentVisualization.h"
 #include "BVPVehiclePathVisualization.h"
 #include "FGCharacterPlayer.h"
+#include "Camera/PlayerCameraManager.h"
+#include "Engine/World.h"
+#include "Async/ParallelFor.h"
 
 FBVPPlayerVisualizationTracker::FBVPPlayerVisualizationTracker( UBVPSubsystem* InSubsystem, APlayerController* InPlayer ) : OwnerSubsystem( InSubsystem ), OwnerPlayer( InPlayer )
 {
 	fgcheck( OwnerSubsystem );
-	fgcheck( OwnerPlayer );
+	fgcheck( InPlayer );
 }
 
 void FBVPPlayerVisualizationTracker::SetVisualizationBit( FName VisualizationId, EBVPPathVisualizationType VisualizationBit, bool bVisualizationEnabled )
@@ -42,7 +45,7 @@ bool FBVPPlayerVisualizationTracker::GetVisualizationBit( FName VisualizationId,
 
 bool FBVPPlayerVisualizationTracker::IsVisualizationTrackerValid() const
 {
-	return OwnerSubsystem && OwnerPlayer && OwnerPlayer->IsLocalController();
+	return OwnerSubsystem && OwnerPlayer.IsValid() && OwnerPlayer->IsLocalController();
 }
 
 bool FBVPPlayerVisualizationTracker::IsVisualizationTrackerEmpty() const
@@ -52,33 +55,26 @@ bool FBVPPlayerVisualizationTracker::IsVisualizationTrackerEmpty() const
 
 void FBVPPlayerVisualizationTracker::ClearSegmentVisualization( const FBVPVehiclePathSegmentVisualization* SegmentVisualization )
 {
-	VisualizationSegmentToVisualizationBitMap.Remove( SegmentVisualization );
+	// Slot will be reused by another segment, which has to start with the default state
+	if ( TrackedSegmentStates.IsValidIndex( SegmentVisualization->GetStateSlotIndex() ) )
+	{
+		TrackedSegmentStates[SegmentVisualization->GetStateSlotIndex()] = FBVPTrackedSegmentState();
+	}
 }
 
 void FBVPPlayerVisualizationTracker::DestroyVisualizationTracker()
 {
 	if ( OwnerSubsystem )
 	{
-		const TMap<FBVPVehiclePathSegmentVisualization*, EBVPPathVisualizationType> EmptyVisualizationBits;
+		const TArray<EBVPPathVisualizationType> EmptyVisualizationBits;
 
 		TArray<FBVPVehiclePathSegmentVisualization*> AllPathVisualizationSegments;
-		CollectAllVisualizationPaths( AllPathVisualizationSegments );
+		OwnerSubsystem->CollectAllVisualizationSegments( AllPathVisualizationSegments );
 		
 		ApplyVisualizationBits( AllPathVisualizationSegments, EmptyVisualizationBits );
 	}
 }
 
-void FBVPPlayerVisualizationTracker::CollectAllVisualizationPaths( TArray<FBVPVehiclePathSegmentVisualization*>& OutAllVisualizations )
-{
-	OutAllVisualizations.Reserve( LastVisualizationSegmentArraySize );
-	
-	for ( const FBVPVehiclePathVisualization* Visualization : OwnerSubsystem->GetAllVisualizedPaths() )
-	{
-		OutAllVisualizations.Append( Visualization->GetVisualizationSegments() );
-	}
-	LastVisualizationSegmentArraySize = OutAllVisualizations.Num();
-}
-
 EBVPPathVisualizationType FBVPPlayerVisualizationTracker::GetCombinedVisualizationFlags() const
 {
 	EBVPPathVisualizationType CombinedWantedVisualizationBits = EBVPPathVisualizationType::None;
@@ -89,59 +85,189 @@ EBVPPathVisualizationType FBVPPlayerVisualizationTracker::GetCombinedVisualizati
 	return CombinedWantedVisualizationBits;
 }
 
-void FBVPPlayerVisualizationTracker::UpdateVisualizationTracker()
+bool FBVPPlayerVisualizationTracker::BuildRelevanceObserver( const TArray<FBVPVehiclePathSegmentVisualization*>& AllVisualizations, FBVPRelevanceObserver& OutObserver )
 {
 	fgcheck( OwnerSubsystem );
-	const EBVPPathVisualizationType CombinedWantedVisualizationBits = GetCombinedVisualizationFlags();
+	if ( !IsVisualizationTrackerValid() )
+	{
+		return false;
+	}
+	const UBVPSettings* BVPSettings = UBVPSettings::Get();
+
+	OutObserver.Tracker = this;
+	OutObserver.WantedVisualizationBits = GetCombinedVisualizationFlags();
+	UpdateSegmentStateSlots();
+
+	FRotator ObserverRotation;
+	OwnerPlayer->GetPlayerViewPoint( OutObserver.ObserverLocation, ObserverRotation );
 
-	TArray<FBVPVehiclePathSegmentVisualization*> AllPathVisualizationSegments;
-	CollectAllVisualizationPaths( AllPathVisualizationSegments );
+	// Horizontal FOV is the widest one for landscape viewports, so use it for the view cone
+	const float FieldOfView = OwnerPlayer->PlayerCameraManager ? OwnerPlayer->PlayerCameraManager->GetFOVAngle() : 90.0f;
+	OutObserver.ViewDirection = ObserverRotation.Vector();
+	OutObserver.ViewConeHalfAngle = FMath::DegreesToRadians( FMath::Min( FieldOfView * 0.5f + BVPSettings->ViewFrustumRelevanceMargin, 180.0f ) );
+
+	// Occlusion traces can only be done on the game thread, so do them before the evaluation
+	if ( BVPSettings->bEnableTerrainOcclusionRelevance )
+	{
+		const float RelevanceHysteresis = FMath::Max( BVPSettings->PathVisualizationRelevanceHysteresis, 0.0f );
+		float MaxVisualizationDistance = 0.0f;
+
+		for ( const EBVPPathVisualizationType VisualizationType : AllVisualizationTypes )
+		{
+			if ( EnumHasAnyFlags( OutObserver.WantedVisualizationBits, VisualizationType ) )
+			{
+				const float* VisualizationDistance = BVPSettings->MaxPathVisualizationDistance.Find( VisualizationType );
+				MaxVisualizationDistance = FMath::Max( MaxVisualizationDistance, ( VisualizationDistance ? *VisualizationDistance : UE_BIG_NUMBER ) + RelevanceHysteresis );
+			}
+		}
+		UpdateSegmentOcclusion( AllVisualizations, OutObserver.ObserverLocation, MaxVisualizationDistance );
+	}
+
+	// Evaluation reads the states in place, the array is not modified until the results are applied
+	OutObserver.SegmentStates = &TrackedSegmentStates;
+	return true;
+}
+
+void FBVPPlayerVisualizationTracker::EvaluateRelevance( const TArray<FBVPVehiclePathSegmentVisualization*>& AllVisualizations, const TArray<FBVPSegmentRelevanceData>& SegmentData,
+	TArray<FBVPRelevanceObserver>& Observers, TArray<double>& OutClosestObserverDistance )
+{
+	fgcheck( AllVisualizations.Num() == SegmentData.Num() );
+	for ( const FBVPRelevanceObserver& Observer : Observers )
+	{
+		fgcheck( Observer.SegmentStates );
+	}
+	const int32 NumSegments = SegmentData.Num();
 
 	// Collect visualization distances for all supported visualization types
 	const UBVPSettings* BVPSettings = UBVPSettings::Get();
 	float VisualizationTypeViewDistances[UE_ARRAY_COUNT( AllVisualizationTypes )];
+	float VisualizationTypeOffscreenDistances[UE_ARRAY_COUNT( AllVisualizationTypes )];
+	const float RelevanceHysteresis = FMath::Max( BVPSettings->PathVisualizationRelevanceHysteresis, 0.0f );
+	const bool bEnableViewFrustumRelevance = BVPSettings->bEnableViewFrustumRelevance;
+	const bool bEnableTerrainOcclusionRelevance = BVPSettings->bEnableTerrainOcclusionRelevance;
 
 	for ( int32 i = 0; i < UE_ARRAY_COUNT( AllVisualizationTypes ); i++ )
 	{
 		const EBVPPathVisualizationType VisualizationType = AllVisualizationTypes[i];
 		VisualizationTypeViewDistances[i] = BVPSettings->MaxPathVisualizationDistance.Contains( VisualizationType ) ?
 			BVPSettings->MaxPathVisualizationDistance.FindChecked( VisualizationType ) : UE_BIG_NUMBER;
+		VisualizationTypeOffscreenDistances[i] = BVPSettings->OffscreenPathVisualizationDistance.Contains( VisualizationType ) ?
+			BVPSettings->OffscreenPathVisualizationDistance.FindChecked( VisualizationType ) : VisualizationTypeViewDistances[i];
 	}
-	
-	// Generate visualizations for each spline segment
-	TMap<FBVPVehiclePathSegmentVisualization*, EBVPPathVisualizationType> NewPerSegmentVisualizationBits;
 
-	if ( IsVisualizationTrackerValid() )
+	for ( FBVPRelevanceObserver& Observer : Observers )
 	{
-		FVector ObserverLocation;
-		FRotator ObserverRotation;
-		OwnerPlayer->GetPlayerViewPoint( ObserverLocation, ObserverRotation );
-		
-		for ( FBVPVehiclePathSegmentVisualization* VisualizationSegment : AllPathVisualizationSegments )
+		Observer.DesiredVisualizationBits.SetNumZeroed( NumSegments );
+	}
+	OutClosestObserverDistance.SetNumUninitialized( NumSegments );
+
+	// Each batch writes to its own range of the output arrays, and only reads the tracker state, so batches do not need any synchronization
+	constexpr int32 SegmentsPerBatch = 256;
+	const int32 NumBatches = FMath::DivideAndRoundUp( NumSegments, SegmentsPerBatch );
+
+	ParallelFor( NumBatches, [&]( int32 BatchIndex )
+	{
+		const int32 FirstSegmentIndex = BatchIndex * SegmentsPerBatch;
+		const int32 LastSegmentIndex = FMath::Min( FirstSegmentIndex + SegmentsPerBatch, NumSegments );
+
+		for ( int32 SegmentIndex = FirstSegmentIndex; SegmentIndex < LastSegmentIndex; SegmentIndex++ )
 		{
-			for ( int32 i = 0; i < UE_ARRAY_COUNT( AllVisualizationTypes ); i++ )
+			const FBVPSegmentRelevanceData& Segment = SegmentData[SegmentIndex];
+			double ClosestObserverDistance = UE_BIG_NUMBER;
+
+			for ( FBVPRelevanceObserver& Observer : Observers )
 			{
-				const EBVPPathVisualizationType VisualizationType = AllVisualizationTypes[i];
-				const float VisualizationDistance = VisualizationTypeViewDistances[i];
-				
-				if ( EnumHasAnyFlags( CombinedWantedVisualizationBits, VisualizationType ) && VisualizationSegment->IsSegmentRelevantForObserver( ObserverLocation, VisualizationDistance ) )
+				const FBVPTrackedSegmentState& SegmentState = ( *Observer.SegmentStates )[Segment.StateSlotIndex];
+
+				// Segments behind the player or behind the terrain use the off-screen distances, which are usually much smaller
+				bool bSegmentOnScreen = !SegmentState.bOccluded || !bEnableTerrainOcclusionRelevance;
+				if ( bSegmentOnScreen && bEnableViewFrustumRelevance )
 				{
-					NewPerSegmentVisualizationBits.FindOrAdd( VisualizationSegment ) |= VisualizationType;
+					bSegmentOnScreen = Segment.IsInViewCone( Observer.ObserverLocation, Observer.ViewDirection, Observer.ViewConeHalfAngle );
+				}
+
+				EBVPPathVisualizationType DesiredBits = EBVPPathVisualizationType::None;
+				for ( int32 i = 0; i < UE_ARRAY_COUNT( AllVisualizationTypes ); i++ )
+				{
+					const EBVPPathVisualizationType VisualizationType = AllVisualizationTypes[i];
+
+					// Segments that are already visualized only stop being relevant once they leave the exit radius
+					const bool bCurrentlyRelevant = EnumHasAnyFlags( SegmentState.VisualizationBits, VisualizationType );
+					const float BaseVisualizationDistance = bSegmentOnScreen ? VisualizationTypeViewDistances[i] : VisualizationTypeOffscreenDistances[i];
+					const float VisualizationDistance = BaseVisualizationDistance + ( bCurrentlyRelevant ? RelevanceHysteresis : 0.0f );
+
+					if ( EnumHasAnyFlags( Observer.WantedVisualizationBits, VisualizationType ) && Segment.IsRelevantForObserver( Observer.ObserverLocation, VisualizationDistance ) )
+					{
+						DesiredBits |= VisualizationType;
+					}
+				}
+				Observer.DesiredVisualizationBits[SegmentIndex] = DesiredBits;
+
+				// Keep track of how close we are so the segment can pick the LOD to render at
+				if ( EnumHasAnyFlags( DesiredBits, EBVPPathVisualizationType::SegmentVisualization ) )
+				{
+					ClosestObserverDistance = FMath::Min( ClosestObserverDistance, FMath::Sqrt( Segment.Bounds.ComputeSquaredDistanceToPoint( Observer.ObserverLocation ) ) );
 				}
 			}
+			OutClosestObserverDistance[SegmentIndex] = ClosestObserverDistance;
+		}
+	}, NumBatches <= 1 ? EParallelForFlags::ForceSingleThread : EParallelForFlags::None );
+}
+
+void FBVPPlayerVisualizationTracker::ApplyRelevanceObserver( const TArray<FBVPVehiclePathSegmentVisualization*>& AllVisualizations, const FBVPRelevanceObserver& Observer )
+{
+	fgcheck( Observer.Tracker == this );
+	ApplyVisualizationBits( AllVisualizations, Observer.DesiredVisualizationBits );
+}
+
+void FBVPPlayerVisualizationTracker::UpdateSegmentOcclusion( const TArray<FBVPVehiclePathSegmentVisualization*>& AllVisualizations, const FVector& ObserverLocation, double MaxRelevanceDistance )
+{
+	const UBVPSettings* BVPSettings = UBVPSettings::Get();
+	if ( AllVisualizations.IsEmpty() || BVPSettings->MaxOcclusionTracesPerFrame <= 0 )
+	{
+		return;
+	}
+	const UWorld* World = OwnerSubsystem->GetWorld();
+
+	FCollisionQueryParams CollisionQueryParams( SCENE_QUERY_STAT( BVPSegmentOcclusion ), false, OwnerPlayer->GetPawn() );
+	const FCollisionObjectQueryParams ObjectQueryParams( ECC_WorldStatic );
+
+	// Only re-test a limited number of segments per frame, segments that are too far away to be relevant are not tested at all
+	int32 NumTracesRemaining = BVPSettings->MaxOcclusionTracesPerFrame;
+	for ( int32 NumSegmentsVisited = 0; NumSegmentsVisited < AllVisualizations.Num() && NumTracesRemaining > 0; NumSegmentsVisited++ )
+	{
+		NextOcclusionTestSegmentIndex = ( NextOcclusionTestSegmentIndex + 1 ) % AllVisualizations.Num();
+		const FBVPVehiclePathSegmentVisualization* VisualizationSegment = AllVisualizations[NextOcclusionTestSegmentIndex];
+
+		if ( VisualizationSegment->IsSegmentRelevantForObserver( ObserverLocation, MaxRelevanceDistance ) )
+		{
+			// Trace towards the top of the segment bounds, which is a coarse but cheap approximation of the segment being hidden by the terrain
+			const FBox& SegmentBounds = VisualizationSegment->GetSegmentBounds();
+			const FVector TraceTarget( SegmentBounds.GetCenter().X, SegmentBounds.GetCenter().Y, SegmentBounds.Max.Z );
+
+			TrackedSegmentStates[VisualizationSegment->GetStateSlotIndex()].bOccluded = World->LineTraceTestByObjectType( ObserverLocation, TraceTarget, ObjectQueryParams, CollisionQueryParams );
+			NumTracesRemaining--;
 		}
 	}
+}
 
-	// Apply visualizations to the resulting segments
-	ApplyVisualizationBits( AllPathVisualizationSegments, NewPerSegmentVisualizationBits );
+void FBVPPlayerVisualizationTracker::UpdateSegmentStateSlots()
+{
+	const int32 NumSegmentStateSlots = OwnerSubsystem->GetNumSegmentStateSlots();
+	if ( TrackedSegmentStates.Num() < NumSegmentStateSlots )
+	{
+		TrackedSegmentStates.SetNum( NumSegmentStateSlots );
+	}
 }
 
-void FBVPPlayerVisualizationTracker::ApplyVisualizationBits( const TArray<FBVPVehiclePathSegmentVisualization*>& AllVisualizations, const TMap<FBVPVehiclePathSegmentVisualization*, EBVPPathVisualizationType>& NewVisualizationBits )
+void FBVPPlayerVisualizationTracker::ApplyVisualizationBits( const TArray<FBVPVehiclePathSegmentVisualization*>& AllVisualizations, const TArray<EBVPPathVisualizationType>& NewVisualizationBits )
 {
-	for ( FBVPVehiclePathSegmentVisualization* Visualization : AllVisualizations )
+	UpdateSegmentStateSlots();
+	for ( int32 SegmentIndex = 0; SegmentIndex < AllVisualizations.Num(); SegmentIndex++ )
 	{
-		EBVPPathVisualizationType& CurrentVisualization = VisualizationSegmentToVisualizationBitMap.FindOrAdd( Visualization );
-		const EBVPPathVisualizationType DesiredVisualization = NewVisualizationBits.Contains( Visualization ) ? NewVisualizationBits.FindChecked( Visualization ) : EBVPPathVisualizationType::None;
+		FBVPVehiclePathSegmentVisualization* Visualization = AllVisualizations[SegmentIndex];
+		EBVPPathVisualizationType& CurrentVisualization = TrackedSegmentStates[Visualization->GetStateSlotIndex()].VisualizationBits;
+		const EBVPPathVisualizationType DesiredVisualization = NewVisualizationBits.IsValidIndex( SegmentIndex ) ? NewVisualizationBits[SegmentIndex] : EBVPPathVisualizationType::None;
 
 		if ( CurrentVisualization != DesiredVisualization )
 		{
@@ -172,8 +298,25 @@ void FBVPPlayerVisualizationTracker::SetVisualizationTypeEnabledForSegment( FBVP
 	}
 }
 
-void FBVPPlayerVisualizationTracker::AddReferencedObjects( FReferenceCollector& ReferenceCollector )
+bool FBVPSegmentRelevanceData::IsRelevantForObserver( const FVector& ObserverLocation, double RelevanceDistance ) const
+{
+	const double RelevanceDistanceSquared = FMath::Square( RelevanceDistance );
+	return FVector::DistSquared( ArriveLocation, ObserverLocation ) <= RelevanceDistanceSquared ||
+		FVector::DistSquared( LeaveLocation, ObserverLocation ) <= RelevanceDistanceSquared;
+}
+
+bool FBVPSegmentRelevanceData::IsInViewCone( const FVector& ObserverLocation, const FVector& ViewDirection, double ViewConeHalfAngle ) const
 {
-	ReferenceCollector.AddReferencedObject( OwnerSubsystem );
-	ReferenceCollector.AddReferencedObject( OwnerPlayer );
+	const FVector DirectionToSegment = BoundsCenter - ObserverLocation;
+	const double DistanceToSegment = DirectionToSegment.Size();
+
+	// Observer is inside of the bounding sphere of the segment, which makes it always visible
+	if ( DistanceToSegment <= BoundsRadius )
+	{
+		return true;
+	}
+	const double AngleToSegment = FMath::Acos( FMath::Clamp( FVector::DotProduct( DirectionToSegment / DistanceToSegment, ViewDirection ), -1.0, 1.0 ) );
+	const double SegmentAngularRadius = FMath::Asin( BoundsRadius / DistanceToSegment );
+
+	return AngleToSegment - SegmentAngularRadius <= ViewConeHalfAngle;
 }
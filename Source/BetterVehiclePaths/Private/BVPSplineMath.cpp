@@ -0,0 +1,267 @@
+﻿// Copyright Nikita Zolotukhin. All Rights Reserved.
+
+#include "BVPSplineMath.h"
+#include "BetterVehiclePaths.h"
+#include "Components/SplineComponent.h"
+#include "HAL/IConsoleManager.h"
+#include "Math/VectorRegister.h"
+
+FBVPHermiteSegment::FBVPHermiteSegment( const FVector& InStartLocation, const FVector& InStartTangent, const FVector& InEndLocation, const FVector& InEndTangent ) :
+	StartLocation( InStartLocation ), StartTangent( InStartTangent ), EndLocation( InEndLocation ), EndTangent( InEndTangent )
+{
+}
+
+FVector FBVPHermiteSegment::EvaluatePosition( double Alpha ) const
+{
+	return FMath::CubicInterp( StartLocation, StartTangent, EndLocation, EndTangent, Alpha );
+}
+
+FVector FBVPHermiteSegment::EvaluateDerivative( double Alpha ) const
+{
+	return FMath::CubicInterpDerivative( StartLocation, StartTangent, EndLocation, EndTangent, Alpha );
+}
+
+FVector FBVPHermiteSegment::EvaluateSecondDerivative( double Alpha ) const
+{
+	return FMath::CubicInterpSecondDerivative( StartLocation, StartTangent, EndLocation, EndTangent, Alpha );
+}
+
+void FBVPHermiteSegment::EvaluateBatch( TConstArrayView<double> Alphas, TArrayView<FVector> OutPositions, TArrayView<FVector> OutDerivatives ) const
+{
+	fgcheck( OutPositions.Num() >= Alphas.Num() );
+	const bool bWantsDerivatives = !OutDerivatives.IsEmpty();
+	fgcheck( !bWantsDerivatives || OutDerivatives.Num() >= Alphas.Num() );
+
+	// Control points are splatted once, each register then holds the same component for 4 different alphas
+	const VectorRegister4Double ControlPoints[3][4] {
+		{ VectorSetFloat1( StartLocation.X ), VectorSetFloat1( StartTangent.X ), VectorSetFloat1( EndLocation.X ), VectorSetFloat1( EndTangent.X ) },
+		{ VectorSetFloat1( StartLocation.Y ), VectorSetFloat1( StartTangent.Y ), VectorSetFloat1( EndLocation.Y ), VectorSetFloat1( EndTangent.Y ) },
+		{ VectorSetFloat1( StartLocation.Z ), VectorSetFloat1( StartTangent.Z ), VectorSetFloat1( EndLocation.Z ), VectorSetFloat1( EndTangent.Z ) },
+	};
+	const VectorRegister4Double One = VectorSetFloat1( 1.0 );
+	const VectorRegister4Double Two = VectorSetFloat1( 2.0 );
+	const VectorRegister4Double Three = VectorSetFloat1( 3.0 );
+	const VectorRegister4Double Four = VectorSetFloat1( 4.0 );
+	const VectorRegister4Double Six = VectorSetFloat1( 6.0 );
+
+	for ( int32 BatchStart = 0; BatchStart < Alphas.Num(); BatchStart += 4 )
+	{
+		const int32 BatchSize = FMath::Min( 4, Alphas.Num() - BatchStart );
+
+		// Pad the last batch with the last alpha so that the math stays valid
+		double BatchAlphas[4];
+		for ( int32 i = 0; i < 4; i++ )
+		{
+			BatchAlphas[i] = Alphas[BatchStart + FMath::Min( i, BatchSize - 1 )];
+		}
+		const VectorRegister4Double T = VectorLoad( BatchAlphas );
+		const VectorRegister4Double T2 = VectorMultiply( T, T );
+		const VectorRegister4Double T3 = VectorMultiply( T2, T );
+
+		// Hermite basis functions: h00 = 2t^3 - 3t^2 + 1, h10 = t^3 - 2t^2 + t, h01 = 3t^2 - 2t^3, h11 = t^3 - t^2
+		const VectorRegister4Double H01 = VectorSubtract( VectorMultiply( Three, T2 ), VectorMultiply( Two, T3 ) );
+		const VectorRegister4Double PositionBasis[4] {
+			VectorSubtract( One, H01 ),
+			VectorAdd( VectorSubtract( T3, VectorMultiply( Two, T2 ) ), T ),
+			H01,
+			VectorSubtract( T3, T2 )
+		};
+
+		// Derivatives of the basis functions: 6t^2 - 6t, 3t^2 - 4t + 1, 6t - 6t^2, 3t^2 - 2t
+		const VectorRegister4Double D01 = VectorSubtract( VectorMultiply( Six, T ), VectorMultiply( Six, T2 ) );
+		const VectorRegister4Double DerivativeBasis[4] {
+			VectorNegate( D01 ),
+			VectorAdd( VectorSubtract( VectorMultiply( Three, T2 ), VectorMultiply( Four, T ) ), One ),
+			D01,
+			VectorSubtract( VectorMultiply( Three, T2 ), VectorMultiply( Two, T ) )
+		};
+
+		double Positions[3][4];
+		double Derivatives[3][4];
+		for ( int32 Component = 0; Component < 3; Component++ )
+		{
+			const VectorRegister4Double* Points = ControlPoints[Component];
+
+			VectorRegister4Double Position = VectorMultiply( PositionBasis[0], Points[0] );
+			Position = VectorMultiplyAdd( PositionBasis[1], Points[1], Position );
+			Position = VectorMultiplyAdd( PositionBasis[2], Points[2], Position );
+			Position = VectorMultiplyAdd( PositionBasis[3], Points[3], Position );
+			VectorStore( Position, Positions[Component] );
+
+			if ( bWantsDerivatives )
+			{
+				VectorRegister4Double Derivative = VectorMultiply( DerivativeBasis[0], Points[0] );
+				Derivative = VectorMultiplyAdd( DerivativeBasis[1], Points[1], Derivative );
+				Derivative = VectorMultiplyAdd( DerivativeBasis[2], Points[2], Derivative );
+				Derivative = VectorMultiplyAdd( DerivativeBasis[3], Points[3], Derivative );
+				VectorStore( Derivative, Derivatives[Component] );
+			}
+		}
+
+		for ( int32 i = 0; i < BatchSize; i++ )
+		{
+			OutPositions[BatchStart + i] = FVector( Positions[0][i], Positions[1][i], Positions[2][i] );
+			if ( bWantsDerivatives )
+			{
+				OutDerivatives[BatchStart + i] = FVector( Derivatives[0][i], Derivatives[1][i], Derivatives[2][i] );
+			}
+		}
+	}
+}
+
+void FBVPHermiteSegment::EvaluateUniform( int32 NumIntervals, TArray<FVector>& OutPositions, TArray<FVector>* OutDerivatives ) const
+{
+	NumIntervals = FMath::Max( NumIntervals, 1 );
+
+	TArray<double, TInlineAllocator<64>> Alphas;
+	Alphas.SetNumUninitialized( NumIntervals + 1 );
+	for ( int32 i = 0; i <= NumIntervals; i++ )
+	{
+		Alphas[i] = (double) i / NumIntervals;
+	}
+
+	OutPositions.SetNumUninitialized( Alphas.Num() );
+	if ( OutDerivatives )
+	{
+		OutDerivatives->SetNumUninitialized( Alphas.Num() );
+	}
+	EvaluateBatch( Alphas, OutPositions, OutDerivatives ? TArrayView<FVector>( *OutDerivatives ) : TArrayView<FVector>() );
+}
+
+double FBVPHermiteSegment::ComputeArcLength( int32 NumIntervals ) const
+{
+	TArray<FVector> Positions;
+	EvaluateUniform( NumIntervals, Positions );
+
+	double ArcLength = 0.0;
+	for ( int32 i = 1; i < Positions.Num(); i++ )
+	{
+		ArcLength += FVector::Distance( Positions[i - 1], Positions[i] );
+	}
+	return ArcLength;
+}
+
+double FBVPHermiteSegment::FindClosestAlpha( const FVector& Location, int32 NumCoarseIntervals ) const
+{
+	TArray<FVector> Positions;
+	EvaluateUniform( NumCoarseIntervals, Positions );
+
+	int32 ClosestSampleIndex = 0;
+	double ClosestDistanceSquared = UE_BIG_NUMBER;
+	for ( int32 i = 0; i < Positions.Num(); i++ )
+	{
+		const double DistanceSquared = FVector::DistSquared( Positions[i], Location );
+		if ( DistanceSquared < ClosestDistanceSquared )
+		{
+			ClosestDistanceSquared = DistanceSquared;
+			ClosestSampleIndex = i;
+		}
+	}
+
+	// Refine with newton iterations on the derivative of the squared distance, staying within the interval around the closest sample
+	const double IntervalSize = 1.0 / ( Positions.Num() - 1 );
+	const double MinAlpha = FMath::Max( ( ClosestSampleIndex - 1 ) * IntervalSize, 0.0 );
+	const double MaxAlpha = FMath::Min( ( ClosestSampleIndex + 1 ) * IntervalSize, 1.0 );
+	double Alpha = ClosestSampleIndex * IntervalSize;
+
+	constexpr int32 NumNewtonIterations = 3;
+	for ( int32 Iteration = 0; Iteration < NumNewtonIterations; Iteration++ )
+	{
+		const FVector Offset = EvaluatePosition( Alpha ) - Location;
+		const FVector Derivative = EvaluateDerivative( Alpha );
+
+		const double Numerator = FVector::DotProduct( Offset, Derivative );
+		const double Denominator = FVector::DotProduct( Derivative, Derivative ) + FVector::DotProduct( Offset, EvaluateSecondDerivative( Alpha ) );
+		if ( FMath::IsNearlyZero( Denominator ) )
+		{
+			break;
+		}
+		Alpha = FMath::Clamp( Alpha - Numerator / Denominator, MinAlpha, MaxAlpha );
+	}
+	return Alpha;
+}
+
+void FBVPHermiteSegment::FindClosestAlphas( const FBVPHermiteSegment& OtherSegment, double& OutAlpha, double& OutOtherAlpha, int32 NumCoarseIntervals ) const
+{
+	TArray<FVector> Positions, OtherPositions;
+	EvaluateUniform( NumCoarseIntervals, Positions );
+	OtherSegment.EvaluateUniform( NumCoarseIntervals, OtherPositions );
+
+	int32 ClosestSampleIndex = 0, ClosestOtherSampleIndex = 0;
+	double ClosestDistanceSquared = UE_BIG_NUMBER;
+	for ( int32 i = 0; i < Positions.Num(); i++ )
+	{
+		for ( int32 j = 0; j < OtherPositions.Num(); j++ )
+		{
+			const double DistanceSquared = FVector::DistSquared( Positions[i], OtherPositions[j] );
+			if ( DistanceSquared < ClosestDistanceSquared )
+			{
+				ClosestDistanceSquared = DistanceSquared;
+				ClosestSampleIndex = i;
+				ClosestOtherSampleIndex = j;
+			}
+		}
+	}
+	OutAlpha = (double) ClosestSampleIndex / NumCoarseIntervals;
+	OutOtherAlpha = (double) ClosestOtherSampleIndex / NumCoarseIntervals;
+
+	// Alternate between projecting one point onto the other segment. Converges quickly since the coarse pair is already close to the closest one
+	constexpr int32 NumRefinementIterations = 2;
+	for ( int32 Iteration = 0; Iteration < NumRefinementIterations; Iteration++ )
+	{
+		OutOtherAlpha = OtherSegment.FindClosestAlpha( EvaluatePosition( OutAlpha ), NumCoarseIntervals );
+		OutAlpha = FindClosestAlpha( OtherSegment.EvaluatePosition( OutOtherAlpha ), NumCoarseIntervals );
+	}
+}
+
+#if !UE_BUILD_SHIPPING
+
+static FAutoConsoleCommand BenchmarkSplineKernelCommand(
+	TEXT("BVP.BenchmarkSplineKernel"),
+	TEXT("Compares the batched hermite evaluation against sampling the spline component. Usage: BVP.BenchmarkSplineKernel [NumSamples]"),
+	FConsoleCommandWithArgsDelegate::CreateLambda( []( const TArray<FString>& Args )
+	{
+		const int32 NumSamples = Args.IsEmpty() ? 1000000 : FMath::Max( FCString::Atoi( *Args[0] ), 4 );
+		const FBVPHermiteSegment Segment( FVector( 0.0, 0.0, 0.0 ), FVector( 3000.0, 500.0, 0.0 ), FVector( 2500.0, 1500.0, 200.0 ), FVector( 1000.0, 3000.0, 100.0 ) );
+
+		TArray<double> Alphas;
+		Alphas.SetNumUninitialized( NumSamples );
+		for ( int32 i = 0; i < NumSamples; i++ )
+		{
+			Alphas[i] = (double) i / ( NumSamples - 1 );
+		}
+		TArray<FVector> Positions, Derivatives;
+		Positions.SetNumUninitialized( NumSamples );
+		Derivatives.SetNumUninitialized( NumSamples );
+
+		// Spline with the same single segment as the kernel evaluates, keyed from 0 to 1 so that the input keys match the alphas
+		USplineComponent* SplineComponent = NewObject<USplineComponent>( GetTransientPackage(), NAME_None, RF_Transient );
+		SplineComponent->ClearSplinePoints( false );
+		SplineComponent->AddPoints( {
+			FSplinePoint( 0.0f, Segment.StartLocation, Segment.StartTangent, Segment.StartTangent ),
+			FSplinePoint( 1.0f, Segment.EndLocation, Segment.EndTangent, Segment.EndTangent )
+		}, true );
+
+		const double ScalarStartTime = FPlatformTime::Seconds();
+		for ( int32 i = 0; i < NumSamples; i++ )
+		{
+			Positions[i] = SplineComponent->GetLocationAtSplineInputKey( Alphas[i], ESplineCoordinateSpace::Local );
+			Derivatives[i] = SplineComponent->GetTangentAtSplineInputKey( Alphas[i], ESplineCoordinateSpace::Local );
+		}
+		const double ScalarTime = FPlatformTime::Seconds() - ScalarStartTime;
+		const FVector ScalarChecksum = Positions.Last() + Derivatives[NumSamples / 2];
+
+		const double BatchStartTime = FPlatformTime::Seconds();
+		Segment.EvaluateBatch( Alphas, Positions, Derivatives );
+		const double BatchTime = FPlatformTime::Seconds() - BatchStartTime;
+		const FVector BatchChecksum = Positions.Last() + Derivatives[NumSamples / 2];
+
+		SplineComponent->MarkAsGarbage();
+
+		UE_LOG( LogBetterVehiclePaths, Display, TEXT("BVP spline kernel: %d samples, spline component %.3f ms, batched %.3f ms, speedup %.2fx, results match: %s"),
+			NumSamples, ScalarTime * 1000.0, BatchTime * 1000.0, ScalarTime / FMath::Max( BatchTime, UE_SMALL_NUMBER ),
+			ScalarChecksum.Equals( BatchChecksum, 0.01 ) ? TEXT("yes") : TEXT("no") );
+	} )
+);
+
+#endif
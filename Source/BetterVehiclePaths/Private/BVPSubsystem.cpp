@@ -1,9 +1,12 @@
 ﻿// Copyright Nikita Zolotukhin. All Rights Reserved.
 
 #include "BVPSubsystem.h"
+#include "BetterVehiclePaths.h"
+#include "BVPPathValidation.h"
 #include "BVPPathVisualizationActor.h"
 #include "BVPPlayerVisualizationTracker.h"
 #include "BVPSettings.h"
+#include "BVPVehiclePathSegmentVisualization.h"
 #include "BVPVehiclePathVisualization.h"
 #include "EnhancedInputComponent.h"
 #include "FGCharacterPlayer.h"
@@ -17,11 +20,29 @@
 #include "Net/UnrealNetwork.h"
 #include "WheeledVehicles/FGWheeledVehicle.h"
 #include "EngineUtils.h"
+#include "Components/LineBatchComponent.h"
+#include "Engine/LocalPlayer.h"
+#include "Engine/NetConnection.h"
+#include "Engine/ActorChannel.h"
+#include "SceneView.h"
+#include "Algo/Count.h"
+#include "Math/MirrorMatrix.h"
+#include "Materials/MaterialInstanceDynamic.h"
+#include "Misc/App.h"
+#include "Misc/Base64.h"
+#include "Misc/FileHelper.h"
+#include "HAL/IConsoleManager.h"
 
 #define LOCTEXT_NAMESPACE "BetterVehiclePaths"
 
 class AFGDrivingTargetList;
 DECLARE_CYCLE_STAT( TEXT( "Better Vehicles Subsystem" ), STAT_BVPSubsystem, STATGROUP_Game );
+DECLARE_DWORD_COUNTER_STAT( TEXT( "Better Vehicles Visualization Actors" ), STAT_BVPVisualizationActors, STATGROUP_Game );
+DECLARE_DWORD_COUNTER_STAT( TEXT( "Better Vehicles Visualization Components" ), STAT_BVPVisualizationComponents, STATGROUP_Game );
+DECLARE_DWORD_COUNTER_STAT( TEXT( "Better Vehicles Hibernated Components" ), STAT_BVPHibernatedComponents, STATGROUP_Game );
+DECLARE_DWORD_COUNTER_STAT( TEXT( "Better Vehicles Server Edits" ), STAT_BVPServerEdits, STATGROUP_Game );
+DECLARE_DWORD_COUNTER_STAT( TEXT( "Better Vehicles Rejected Server Edits" ), STAT_BVPRejectedServerEdits, STATGROUP_Game );
+DECLARE_FLOAT_COUNTER_STAT( TEXT( "Better Vehicles Last Garbage Collection (ms)" ), STAT_BVPLastGarbageCollectTime, STATGROUP_Game );
 
 UBVPSubsystem::UBVPSubsystem()
 {
@@ -34,12 +55,14 @@ UBVPSubsystem::~UBVPSubsystem()
 		delete PathVisualization;
 	}
 	VisualizedPaths.Empty();
+	VisualizedPathsByTargetList.Empty();
 
 	for ( const FBVPPlayerVisualizationTracker* VisualizationTracker : VisualizationTrackers )
 	{
 		delete VisualizationTracker;
 	}
 	VisualizationTrackers.Empty();
+	HibernatedSegments.Empty();
 }
 
 bool UBVPSubsystem::DoesSupportWorldType( const EWorldType::Type WorldType ) const
@@ -58,6 +81,56 @@ void UBVPSubsystem::Initialize( FSubsystemCollectionBase& Collection )
 	PathEditorWidget = BVPSettings->PathEditorWidget.LoadSynchronous();
 	PathNodeClass = BVPSettings->PathNodeClass.LoadSynchronous();
 	PathEditorSelectedMaterial = BVPSettings->PathEditorSelectedMaterial.LoadSynchronous();
+	PathNodeIndex.SetCellSize( BVPSettings->PathNodeSpatialIndexCellSize );
+
+	PreGarbageCollectDelegateHandle = FCoreUObjectDelegates::GetPreGarbageCollectDelegate().AddUObject( this, &UBVPSubsystem::OnPreGarbageCollect );
+	PostGarbageCollectDelegateHandle = FCoreUObjectDelegates::GetPostGarbageCollect().AddUObject( this, &UBVPSubsystem::OnPostGarbageCollect );
+}
+
+void UBVPSubsystem::Deinitialize()
+{
+	FCoreUObjectDelegates::GetPreGarbageCollectDelegate().Remove( PreGarbageCollectDelegateHandle );
+	FCoreUObjectDelegates::GetPostGarbageCollect().Remove( PostGarbageCollectDelegateHandle );
+
+	Super::Deinitialize();
+}
+
+void UBVPSubsystem::OnPreGarbageCollect()
+{
+	GarbageCollectStartTime = FPlatformTime::Seconds();
+}
+
+void UBVPSubsystem::OnPostGarbageCollect()
+{
+	// Material instances no component was using anymore have just been collected
+	for ( auto It = PathVisualizationMaterialInstances.CreateIterator(); It; ++It )
+	{
+		if ( !It->Value.IsValid() )
+		{
+			It.RemoveCurrent();
+		}
+	}
+
+	if ( GarbageCollectStartTime == 0.0 )
+	{
+		return;
+	}
+
+	// GC time is global, so compare it with the visualization load at the time to see how much of it the visualization components account for
+	const double GarbageCollectTime = FPlatformTime::Seconds() - GarbageCollectStartTime;
+	GarbageCollectStartTime = 0.0;
+	SET_FLOAT_STAT( STAT_BVPLastGarbageCollectTime, GarbageCollectTime * 1000.0 );
+
+	int32 NumVisualizationActors = 0;
+	int32 NumVisualizationComponents = 0;
+	for ( const FBVPVehiclePathVisualization* PathVisualization : VisualizedPaths )
+	{
+		const int32 NumPathComponents = PathVisualization->GetNumVisualizationComponents();
+		NumVisualizationActors += NumPathComponents != 0 ? 1 : 0;
+		NumVisualizationComponents += NumPathComponents;
+	}
+	UE_LOG( LogBetterVehiclePaths, Verbose, TEXT("Garbage collection took %.2f ms with %d visualization components alive across %d actors and %d hibernated components"),
+		GarbageCollectTime * 1000.0, NumVisualizationComponents, NumVisualizationActors, NumHibernatedComponents );
 }
 
 void UBVPSubsystem::OnWorldBeginPlay( UWorld& InWorld )
@@ -68,6 +141,7 @@ void UBVPSubsystem::OnWorldBeginPlay( UWorld& InWorld )
 	{
 		GameMode->RegisterRemoteCallObjectClass( UBVPRemoteCallObject::StaticClass() );
 	}
+	bPendingLoadValidation = !InWorld.IsNetMode( NM_Client );
 }
 
 void UBVPSubsystem::Tick( float DeltaTime )
@@ -75,7 +149,13 @@ void UBVPSubsystem::Tick( float DeltaTime )
 	Super::Tick( DeltaTime );
 	
 	TickActiveVisualizations();
+	TickHibernatedSegments();
 	TickVisualizationTrackers();
+	TickNetworkOverview();
+	TickProblemDetector();
+	TickLoadValidation();
+	TickPathImports();
+	TickEditStressTest();
 }
 
 TStatId UBVPSubsystem::GetStatId() const
@@ -119,7 +199,7 @@ bool UBVPSubsystem::TraceForSplineSegment( APlayerController* PlayerController,
 		{
 			if ( USplineComponent* SplineComponent = PathVisualizationActor->OwnerTargetList->GetPath() )
 			{
-				OutHitResult.ProgressAlongSpline = SplineComponent->FindInputKeyClosestToWorldLocation( HitResult.ImpactPoint );
+				OutHitResult.ProgressAlongSpline = FindInputKeyClosestToHitLocation( PathVisualizationActor->OwnerTargetList, SplineComponent, HitResult.ImpactPoint );
 				OutHitResult.SplineComponent = SplineComponent;
 
 				const int32 SplinePointAtInput = SplineComponent->SplineCurves.Position.GetPointIndexForInputValue( OutHitResult.ProgressAlongSpline );
@@ -131,6 +211,22 @@ bool UBVPSubsystem::TraceForSplineSegment( APlayerController* PlayerController,
 	return false;
 }
 
+float UBVPSubsystem::FindInputKeyClosestToHitLocation( const AFGDrivingTargetList* TargetPointList, const USplineComponent* SplineComponent, const FVector& HitLocation ) const
+{
+	// Hits against our colliders can only happen within the collision thickness of the segment, so only the segments around the hit need to be refined
+	const double SearchRadius = UBVPSettings::Get()->PathVisualizationCollisionThickness * 2.0;
+
+	if ( const FBVPVehiclePathVisualization* PathVisualization = FindPathVisualization( TargetPointList ) )
+	{
+		double ClosestAlpha = 0.0;
+		if ( const FBVPVehiclePathSegmentVisualization* ClosestSegment = PathVisualization->FindSegmentClosestToLocation( HitLocation, SearchRadius, ClosestAlpha ) )
+		{
+			return ClosestSegment->GetSplineInputKeyAtAlpha( ClosestAlpha );
+		}
+	}
+	return SplineComponent->FindInputKeyClosestToWorldLocation( HitLocation );
+}
+
 bool UBVPSubsystem::TraceForSolidSurface( APlayerController* PlayerController, const FVector2D& ScreenPosition, FHitResult& OutHitResul )
 {
 	// Attempt to obtain the hit from the screen space first
@@ -213,6 +309,10 @@ bool UBVPSubsystem::CreateNewPathNode( AFGPlayerController* PlayerController, co
 	const FVector WorldDirectionAtHit = HitResult.SplineComponent->GetDirectionAtSplineInputKey( HitResult.ProgressAlongSpline, ESplineCoordinateSpace::World );
 
 	const int32 ClosestPointAtProgress = HitResult.SplineComponent->SplineCurves.Position.GetPointIndexForInputValue( HitResult.ProgressAlongSpline );
+	if ( !HitResult.SplineComponent->SplineCurves.Position.Points.IsValidIndex( ClosestPointAtProgress + 1 ) )
+	{
+		return false;
+	}
 	const float SegmentProgressStart = HitResult.SplineComponent->SplineCurves.Position.Points[ ClosestPointAtProgress ].InVal;
 	const float SegmentProgressEnd = HitResult.SplineComponent->SplineCurves.Position.Points[ ClosestPointAtProgress + 1 ].InVal;
 	
@@ -242,36 +342,42 @@ bool UBVPSubsystem::CreateNewPathNode( AFGPlayerController* PlayerController, co
 
 	if ( AFGTargetPoint* NewTargetPoint = CreatePawnPathNodeInternal( HitResult.PointAfter, WorldLocationAtHit, WorldDirectionAtHit.Rotation(), TargetSpeedAtPoint ) )
 	{
+		if ( FBVPPathEditHistory* EditHistory = FindPathEditHistoryForRecording( PlayerController ) )
+		{
+			EditHistory->RecordCreate( NewTargetPoint, HitResult.PointAfter );
+		}
 		OnNewPathNodeCreated.Broadcast( NewTargetPoint, PlayerController );
 		return true;
 	}
 	return false;
 }
 
-AFGTargetPoint* UBVPSubsystem::CreatePawnPathNodeInternal( AFGTargetPoint* AfterPoint, const FVector& NewLocation, const FRotator& NewRotation, int32 TargetSpeed ) const
+AFGTargetPoint* UBVPSubsystem::CreatePawnPathNodeInternal( AFGTargetPoint* AfterPoint, const FVector& NewLocation, const FRotator& NewRotation, int32 TargetSpeed )
+{
+	const AFGTargetPoint* NextPoint = FindNextTargetPoint( AfterPoint );
+	fgcheck( NextPoint );
+	
+	const int32 MaxSpeed = FMath::Max( AfterPoint->GetTargetSpeed(), NextPoint->GetTargetSpeed() );
+	AFGTargetPoint* NewTargetPoint = SpawnPathNodeInternal( AfterPoint, FTransform( NewRotation, NewLocation ), FMath::Clamp( TargetSpeed, 0, MaxSpeed ) );
+
+	RebuildTargetListPath( AfterPoint->GetOwningList() );
+	return NewTargetPoint;
+}
+
+AFGTargetPoint* UBVPSubsystem::SpawnPathNodeInternal( AFGTargetPoint* AfterPoint, const FTransform& Transform, int32 TargetSpeed )
 {
 	AFGDrivingTargetList* OwnerTargetList = AfterPoint->GetOwningList();
 	fgcheck( OwnerTargetList );
 	
-	const FTransform Transform( NewRotation, NewLocation );
 	AFGTargetPoint* NewTargetPoint = GetWorld()->SpawnActorDeferred<AFGTargetPoint>( PathNodeClass, Transform, OwnerTargetList, nullptr );
 	fgcheck( NewTargetPoint );
-
-	const AFGTargetPoint* NextPoint = FindNextTargetPoint( AfterPoint );
-	fgcheck( NextPoint );
-	
-	const int32 MaxSpeed = FMath::Max( AfterPoint->GetTargetSpeed(), NextPoint->GetTargetSpeed() );
-	NewTargetPoint->SetTargetSpeed( FMath::Clamp( TargetSpeed, 0, MaxSpeed ) );
+	NewTargetPoint->SetTargetSpeed( TargetSpeed );
 	
+	// The target count is recalculated once by RebuildTargetListPath after the whole batch has been spawned
 	OwnerTargetList->InsertItem( NewTargetPoint, AfterPoint );
-	OwnerTargetList->CalculateTargetCount();
 	
 	NewTargetPoint->FinishSpawning( Transform, false );
-	
-	if ( OwnerTargetList->HasData() && OwnerTargetList->IsComplete() )
-	{
-		OwnerTargetList->CreatePath();
-	}
+	PathNodeIndex.UpdatePathNode( NewTargetPoint );
 	return NewTargetPoint;
 }
 
@@ -295,13 +401,14 @@ bool UBVPSubsystem::RemovePathNode( AFGPlayerController* PlayerController, AFGTa
 
 	if ( AFGDrivingTargetList* OwnerTargetList = TargetPoint->GetOwningList() )
 	{
-		OwnerTargetList->RemoveItem( TargetPoint );
-		OwnerTargetList->CalculateTargetCount();
-		
-		if ( OwnerTargetList->HasData() && OwnerTargetList->IsComplete() )
+		if ( FBVPPathEditHistory* EditHistory = FindPathEditHistoryForRecording( PlayerController ) )
 		{
-			OwnerTargetList->CreatePath();
+			EditHistory->RecordRemove( TargetPoint, FindPrevTargetPoint( TargetPoint ) );
 		}
+		PathNodeIndex.RemovePathNode( TargetPoint );
+		OwnerTargetList->RemoveItem( TargetPoint );
+
+		RebuildTargetListPath( OwnerTargetList );
 		return true;
 	}
 	return false;
@@ -322,7 +429,13 @@ bool UBVPSubsystem::SetPathNodeTargetSpeed( AFGPlayerController* PlayerControlle
 
 	if ( TargetPoint && TargetPoint->GetOwningList() )
 	{
-		TargetPoint->SetTargetSpeed( FMath::Clamp( NewTargetSpeed, 0, 200 ) );
+		const int32 OldTargetSpeed = TargetPoint->GetTargetSpeed();
+		TargetPoint->SetTargetSpeed( FMath::Clamp( NewTargetSpeed, 0, UBVPSettings::Get()->MaxTargetSpeed ) );
+
+		if ( FBVPPathEditHistory* EditHistory = FindPathEditHistoryForRecording( PlayerController ) )
+		{
+			EditHistory->RecordTargetSpeed( TargetPoint, OldTargetSpeed, TargetPoint->GetTargetSpeed() );
+		}
 		return true;
 	}
 	return false;
@@ -336,8 +449,15 @@ bool UBVPSubsystem::MovePathNode( AFGPlayerController* PlayerController, AFGTarg
 		return false;
 	}
 	
+	const FTransform OldTransform = TargetPoint->GetActorTransform();
 	TargetPoint->SetActorLocationAndRotation( NewLocation, NewRotation );
 	TargetPoint->FlushNetDormancy();
+	PathNodeIndex.UpdatePathNode( TargetPoint );
+
+	if ( FBVPPathEditHistory* EditHistory = FindPathEditHistoryForRecording( PlayerController ) )
+	{
+		EditHistory->RecordMove( TargetPoint, OldTransform, TargetPoint->GetActorTransform(), GetWorld()->GetTimeSeconds(), UBVPSettings::Get()->PathEditCoalesceTime );
+	}
 
 	// Rebuild the path on the owner target list now
 	if ( AFGDrivingTargetList* OwnerTargetList = TargetPoint->GetOwningList() )
@@ -394,230 +514,2933 @@ bool UBVPSubsystem::CheckCanRemovePathNode( const AFGTargetPoint* TargetPoint, F
 	return true;
 }
 
-AFGTargetPoint* UBVPSubsystem::FindPrevTargetPoint( const AFGTargetPoint* TargetPoint )
+void UBVPSubsystem::FindPathNodesInScreenRect( APlayerController* PlayerController, const FVector2D& RectStart, const FVector2D& RectEnd, TArray<AFGTargetPoint*>& OutPathNodes ) const
 {
-	fgcheck( TargetPoint );
-
-	const AFGDrivingTargetList* TargetList = TargetPoint->GetOwningList();
-	fgcheck( TargetList );
+	OutPathNodes.Reset();
 
-	// Previous point of the first target is the last point ;)
-	if ( TargetPoint == TargetList->GetFirstTarget() )
+	const ULocalPlayer* LocalPlayer = PlayerController ? PlayerController->GetLocalPlayer() : nullptr;
+	if ( !LocalPlayer || !LocalPlayer->ViewportClient )
 	{
-		return TargetList->GetLastTarget();
+		return;
+	}
+	FSceneViewProjectionData ProjectionData;
+	if ( !LocalPlayer->GetProjectionData( LocalPlayer->ViewportClient->Viewport, ProjectionData ) )
+	{
+		return;
 	}
+	const FVector2D RectMin( FMath::Min( RectStart.X, RectEnd.X ), FMath::Min( RectStart.Y, RectEnd.Y ) );
+	const FVector2D RectMax( FMath::Max( RectStart.X, RectEnd.X ), FMath::Max( RectStart.Y, RectEnd.Y ) );
 
-	// Otherwise walk the linked list
-	AFGTargetPoint* CurrentTargetPoint = TargetList->GetFirstTarget();
-	while ( CurrentTargetPoint != nullptr )
+	// Selection frustum is the pyramid between the view origin and the deprojected rectangle corners at the trace distance, so these points bound it
+	const float SelectionDistance = GetTraceDistanceForPlayer( PlayerController );
+	const FVector2D RectCorners[] { RectMin, FVector2D( RectMax.X, RectMin.Y ), RectMax, FVector2D( RectMin.X, RectMax.Y ) };
+
+	FBox SelectionBounds( ForceInit );
+	SelectionBounds += ProjectionData.ViewOrigin;
+	for ( const FVector2D& RectCorner : RectCorners )
 	{
-		if ( CurrentTargetPoint->GetNext() == TargetPoint )
+		FVector CornerWorldPosition, CornerWorldDirection;
+		if ( !UGameplayStatics::DeprojectScreenToWorld( PlayerController, RectCorner, CornerWorldPosition, CornerWorldDirection ) )
 		{
-			return CurrentTargetPoint;
+			return;
 		}
-		CurrentTargetPoint = CurrentTargetPoint->GetNext();
+		SelectionBounds += CornerWorldPosition + CornerWorldDirection * SelectionDistance;
 	}
-	return nullptr;
-}
 
-AFGTargetPoint* UBVPSubsystem::FindNextTargetPoint( const AFGTargetPoint* TargetPoint )
-{
-	fgcheck( TargetPoint );
+	TArray<AFGTargetPoint*> CandidatePathNodes;
+	PathNodeIndex.FindPathNodesInBox( SelectionBounds, CandidatePathNodes );
 
-	const AFGDrivingTargetList* TargetList = TargetPoint->GetOwningList();
-	fgcheck( TargetList );
+	// Project all the candidates to the screen with the same view projection matrix instead of going through the player controller for each of them
+	const FMatrix ViewProjectionMatrix = ProjectionData.ComputeViewProjectionMatrix();
+	const FIntRect ViewRect = ProjectionData.GetConstrainedViewRect();
 
-	// Next point of the last target is the first point ;)
-	if ( TargetPoint == TargetList->GetLastTarget() )
+	for ( AFGTargetPoint* CandidatePathNode : CandidatePathNodes )
 	{
-		return TargetList->GetFirstTarget();
+		const FVector4 ClipPosition = ViewProjectionMatrix.TransformFVector4( FVector4( CandidatePathNode->GetActorLocation(), 1.0 ) );
+		if ( ClipPosition.W <= 0.0 )
+		{
+			continue;
+		}
+		const double InvW = 1.0 / ClipPosition.W;
+		const FVector2D ScreenPosition(
+			ViewRect.Min.X + ( 0.5 + ClipPosition.X * InvW * 0.5 ) * ViewRect.Width(),
+			ViewRect.Min.Y + ( 0.5 - ClipPosition.Y * InvW * 0.5 ) * ViewRect.Height() );
+
+		if ( ScreenPosition.X >= RectMin.X && ScreenPosition.X <= RectMax.X && ScreenPosition.Y >= RectMin.Y && ScreenPosition.Y <= RectMax.Y &&
+			FVector::Distance( CandidatePathNode->GetActorLocation(), ProjectionData.ViewOrigin ) <= SelectionDistance )
+		{
+			OutPathNodes.Add( CandidatePathNode );
+		}
 	}
-	return TargetPoint->GetNext();
 }
 
-bool UBVPSubsystem::CheckDistanceBetweenTwoPoints( const FVector& LocationA, const FVector& LocationB )
+bool UBVPSubsystem::TranslatePathNodes( AFGPlayerController* PlayerController, const TArray<AFGTargetPoint*>& PathNodes, const FVector& Offset, FText& OutErrorMessage )
 {
-	const UBVPSettings* BVPSettings = UBVPSettings::Get();
-	return FVector::Distance( LocationA, LocationB ) <= BVPSettings->MaxDistanceBetweenPathNodes;
-}
+	TArray<FTransform> NewTransforms;
+	NewTransforms.Reserve( PathNodes.Num() );
 
-void UBVPSubsystem::SetVisualizationRequesterState( APlayerController* Requester, FName VisualizationId, EBVPPathVisualizationType VisualizationType, bool bVisualizationEnabled )
-{
-	if ( FBVPPlayerVisualizationTracker* VisualizationTracker = FindVisualizationTrackerForPlayer( Requester, true ) )
+	for ( const AFGTargetPoint* PathNode : PathNodes )
 	{
-		VisualizationTracker->SetVisualizationBit( VisualizationId, VisualizationType, bVisualizationEnabled );
+		if ( !PathNode )
+		{
+			return false;
+		}
+		NewTransforms.Emplace( PathNode->GetActorQuat(), PathNode->GetActorLocation() + Offset );
 	}
+	return ApplyPathNodeTransformsInternal( PlayerController, PathNodes, NewTransforms, true, OutErrorMessage );
 }
 
-bool UBVPSubsystem::GetVisualizationRequesterState( APlayerController* Requester, FName VisualizationId, EBVPPathVisualizationType VisualizationType )
+bool UBVPSubsystem::RotatePathNodes( AFGPlayerController* PlayerController, const TArray<AFGTargetPoint*>& PathNodes, const FVector& Pivot, const FRotator& Rotation, FText& OutErrorMessage )
 {
-	if (const FBVPPlayerVisualizationTracker* VisualizationTracker = FindVisualizationTrackerForPlayer( Requester, false ) )
+	const FQuat RotationQuat = Rotation.Quaternion();
+
+	TArray<FTransform> NewTransforms;
+	NewTransforms.Reserve( PathNodes.Num() );
+
+	for ( const AFGTargetPoint* PathNode : PathNodes )
 	{
-		return VisualizationTracker->GetVisualizationBit( VisualizationId, VisualizationType );
+		if ( !PathNode )
+		{
+			return false;
+		}
+		NewTransforms.Emplace( RotationQuat * PathNode->GetActorQuat(), Pivot + RotationQuat.RotateVector( PathNode->GetActorLocation() - Pivot ) );
 	}
-	return false;
+	return ApplyPathNodeTransformsInternal( PlayerController, PathNodes, NewTransforms, true, OutErrorMessage );
 }
 
-void UBVPSubsystem::BindPlayerActions( AFGCharacterPlayer* CharacterPlayer, UEnhancedInputComponent* InputComponent )
+bool UBVPSubsystem::ApplyPathNodeTransformsInternal( AFGPlayerController* PlayerController, const TArray<AFGTargetPoint*>& PathNodes, const TArray<FTransform>& NewTransforms, bool bRigidTransform, FText& OutErrorMessage )
 {
-	const UBVPSettings* BVPSettings = UBVPSettings::Get();
-	InputComponent->BindAction( BVPSettings->InputActionVisualizePaths.LoadSynchronous(), ETriggerEvent::Triggered, this, &UBVPSubsystem::Input_ToggleVisualizePaths, CharacterPlayer );
-	InputComponent->BindAction( BVPSettings->InputActionOpenPathEditor.LoadSynchronous(), ETriggerEvent::Triggered, this, &UBVPSubsystem::Input_OpenPathEditor, CharacterPlayer );
-}
+	if ( PathNodes.IsEmpty() || !CheckCanApplyPathNodeTransforms( PathNodes, NewTransforms, bRigidTransform, OutErrorMessage ) )
+	{
+		return false;
+	}
 
-FBVPPlayerVisualizationTracker* UBVPSubsystem::FindVisualizationTrackerForPlayer( APlayerController* PlayerController, bool bCreateIfNotFound )
-{
-	for ( FBVPPlayerVisualizationTracker* VisualizationTracker : VisualizationTrackers )
+	// Clients predict the edit locally, the server will roll the nodes back if it rejects it
+	SetPathNodeTransformsInternal( PathNodes, NewTransforms );
+
+	if ( PlayerController && GetWorld()->IsNetMode( NM_Client ) )
 	{
-		if ( VisualizationTracker->IsVisualizationTrackerValid() && VisualizationTracker->GetOwner() == PlayerController )
+		if ( UBVPRemoteCallObject* RemoteCallObject = PlayerController->GetRemoteCallObjectOfClass<UBVPRemoteCallObject>() )
 		{
-			return VisualizationTracker;
+			RemoteCallObject->Server_ApplyPathNodeTransforms( PathNodes, NewTransforms, bRigidTransform );
 		}
 	}
+	return true;
+}
 
-	if ( bCreateIfNotFound && PlayerController )
+bool UBVPSubsystem::TranslatePath( AFGPlayerController* PlayerController, AFGDrivingTargetList* TargetPointList, const FVector& Offset, FText& OutErrorMessage )
+{
+	if ( !TargetPointList )
 	{
-		FBVPPlayerVisualizationTracker* NewPlayerTracker = new FBVPPlayerVisualizationTracker( this, PlayerController );
-		VisualizationTrackers.Add( NewPlayerTracker );
-
-		return NewPlayerTracker;
+		OutErrorMessage = LOCTEXT("TransformPath_InvalidPath", "No valid Path to move.");
+		return false;
 	}
-	return nullptr;
+	return TranslatePathRange( PlayerController, TargetPointList->GetFirstTarget(), TargetPointList->GetLastTarget(), Offset, OutErrorMessage );
 }
 
-void UBVPSubsystem::Input_ToggleVisualizePaths( const FInputActionValue& ActionValue, AFGCharacterPlayer* CharacterPlayer )
+bool UBVPSubsystem::RotatePath( AFGPlayerController* PlayerController, AFGDrivingTargetList* TargetPointList, const FVector& Pivot, const FRotator& Rotation, FText& OutErrorMessage )
 {
-	if ( ActionValue.IsNonZero() )
+	if ( !TargetPointList )
 	{
-		if ( APlayerController* PlayerController = CharacterPlayer->GetController<APlayerController>() )
-		{
-			const FName VisualizationIdKeyBind( TEXT("BVP_InputToggleVisualizePaths") );
-			constexpr EBVPPathVisualizationType VisualizationType = EBVPPathVisualizationType::SegmentVisualization;
-			
-			const bool bCurrentState = GetVisualizationRequesterState( PlayerController, VisualizationIdKeyBind, VisualizationType );
-			SetVisualizationRequesterState( PlayerController, VisualizationIdKeyBind, VisualizationType, !bCurrentState );	
-		}
+		OutErrorMessage = LOCTEXT("TransformPath_InvalidPath", "No valid Path to move.");
+		return false;
 	}
+	return RotatePathRange( PlayerController, TargetPointList->GetFirstTarget(), TargetPointList->GetLastTarget(), Pivot, Rotation, OutErrorMessage );
 }
 
-void UBVPSubsystem::Input_OpenPathEditor( const FInputActionValue& ActionValue, AFGCharacterPlayer* CharacterPlayer )
+bool UBVPSubsystem::MirrorPath( AFGPlayerController* PlayerController, AFGDrivingTargetList* TargetPointList, const FVector& PlaneOrigin, const FVector& PlaneNormal, FText& OutErrorMessage )
 {
-	if ( ActionValue.IsNonZero() )
+	if ( !TargetPointList )
 	{
-		if ( const AFGPlayerController* PlayerController = CharacterPlayer->GetFGPlayerController() )
-		{
-			if ( AFGHUD* HUD = PlayerController->GetHUD<AFGHUD>() )
-			{
-				HUD->OpenInteractUI( PathEditorWidget, this );
-			}
-		}
+		OutErrorMessage = LOCTEXT("TransformPath_InvalidPath", "No valid Path to move.");
+		return false;
 	}
+	return MirrorPathRange( PlayerController, TargetPointList->GetFirstTarget(), TargetPointList->GetLastTarget(), PlaneOrigin, PlaneNormal, OutErrorMessage );
 }
 
-void UBVPSubsystem::TickActiveVisualizations()
+bool UBVPSubsystem::TranslatePathRange( AFGPlayerController* PlayerController, AFGTargetPoint* FirstPathNode, AFGTargetPoint* LastPathNode, const FVector& Offset, FText& OutErrorMessage )
 {
-	const AFGVehicleSubsystem* VehicleSubsystem = AFGVehicleSubsystem::Get( this );
-	if ( !VehicleSubsystem )
+	return TransformPathRangeInternal( PlayerController, FirstPathNode, LastPathNode, FTranslationMatrix( Offset ), OutErrorMessage );
+}
+
+bool UBVPSubsystem::RotatePathRange( AFGPlayerController* PlayerController, AFGTargetPoint* FirstPathNode, AFGTargetPoint* LastPathNode, const FVector& Pivot, const FRotator& Rotation, FText& OutErrorMessage )
+{
+	const FMatrix Transform = FTranslationMatrix( -Pivot ) * FRotationMatrix( Rotation ) * FTranslationMatrix( Pivot );
+	return TransformPathRangeInternal( PlayerController, FirstPathNode, LastPathNode, Transform, OutErrorMessage );
+}
+
+bool UBVPSubsystem::MirrorPathRange( AFGPlayerController* PlayerController, AFGTargetPoint* FirstPathNode, AFGTargetPoint* LastPathNode, const FVector& PlaneOrigin, const FVector& PlaneNormal, FText& OutErrorMessage )
+{
+	if ( PlaneNormal.IsNearlyZero() )
 	{
-		return;
+		OutErrorMessage = LOCTEXT("MirrorPathRange_InvalidPlane", "Cannot mirror the Path Nodes as the mirror plane has no valid normal.");
+		return false;
 	}
+	return TransformPathRangeInternal( PlayerController, FirstPathNode, LastPathNode, FMirrorMatrix( FPlane( PlaneOrigin, PlaneNormal.GetSafeNormal() ) ), OutErrorMessage );
+}
 
-	// Cleanup stale visualization paths before we do anything
-	for ( int32 i = VisualizedPaths.Num() - 1; i >= 0; i-- )
+bool UBVPSubsystem::GetPathNodeRange( AFGTargetPoint* FirstPathNode, AFGTargetPoint* LastPathNode, TArray<AFGTargetPoint*>& OutPathNodes )
+{
+	OutPathNodes.Reset();
+	const AFGDrivingTargetList* TargetPointList = FirstPathNode && LastPathNode ? FirstPathNode->GetOwningList() : nullptr;
+	if ( !TargetPointList || LastPathNode->GetOwningList() != TargetPointList )
 	{
-		FBVPVehiclePathVisualization* PathVisualization = VisualizedPaths[i];
-		fgcheck( PathVisualization );
+		return false;
+	}
 
-		if ( !PathVisualization->IsVisualizationValid() )
+	// The walk is bounded by the number of nodes in the list, in case the last node cannot be reached
+	const int32 NumPathNodes = TargetPointList->GetTargetCount();
+	for ( AFGTargetPoint* PathNode = FirstPathNode; PathNode && OutPathNodes.Num() < NumPathNodes; PathNode = FindNextTargetPoint( PathNode ) )
+	{
+		OutPathNodes.Add( PathNode );
+		if ( PathNode == LastPathNode )
 		{
-			PathVisualization->DestroyVisualization();
-			delete PathVisualization;
-			VisualizedPaths.RemoveAt( i );
+			return true;
 		}
 	}
-	
-	// Update path visualizations based on target lists
-	TMap<AFGDrivingTargetList*, FBVPVehiclePathVisualization*> ExistingVisualizationPaths;
-	for ( FBVPVehiclePathVisualization* VehiclePathVisualization : VisualizedPaths )
+	OutPathNodes.Reset();
+	return false;
+}
+
+bool UBVPSubsystem::TransformPathRangeInternal( AFGPlayerController* PlayerController, AFGTargetPoint* FirstPathNode, AFGTargetPoint* LastPathNode, const FMatrix& Transform, FText& OutErrorMessage )
+{
+	// The transform can come from a client, so it has to be finite and affine, as the projective part is silently dropped when transforming positions
+	if ( Transform.ContainsNaN() || !FMath::IsNearlyZero( Transform.M[0][3] ) || !FMath::IsNearlyZero( Transform.M[1][3] ) || !FMath::IsNearlyZero( Transform.M[2][3] ) ||
+		!FMath::IsNearlyEqual( Transform.M[3][3], 1.0 ) )
 	{
-		ExistingVisualizationPaths.Add( VehiclePathVisualization->GetTargetList(), VehiclePathVisualization );
+		OutErrorMessage = LOCTEXT("TransformPathRange_InvalidTransform", "Cannot move the Path Nodes as the transform is not valid.");
+		return false;
 	}
 
-	// Clients do not populate mTargetLists, so we need to use TActorIterator instead.
-	TArray<AFGDrivingTargetList*> AllTargetLists;
-	if ( !GetWorld()->IsNetMode( NM_Client ) )
+	// Only the boundaries of the range are checked, which is only valid if the transform keeps the distances between the nodes intact
+	const FVector AxisX = Transform.GetScaledAxis( EAxis::X );
+	const FVector AxisY = Transform.GetScaledAxis( EAxis::Y );
+	const FVector AxisZ = Transform.GetScaledAxis( EAxis::Z );
+	if ( !FMath::IsNearlyEqual( AxisX.SizeSquared(), 1.0, UE_KINDA_SMALL_NUMBER ) || !FMath::IsNearlyEqual( AxisY.SizeSquared(), 1.0, UE_KINDA_SMALL_NUMBER ) || !FMath::IsNearlyEqual( AxisZ.SizeSquared(), 1.0, UE_KINDA_SMALL_NUMBER ) ||
+		!FMath::IsNearlyZero( AxisX | AxisY, UE_KINDA_SMALL_NUMBER ) || !FMath::IsNearlyZero( AxisY | AxisZ, UE_KINDA_SMALL_NUMBER ) || !FMath::IsNearlyZero( AxisZ | AxisX, UE_KINDA_SMALL_NUMBER ) )
 	{
-		AllTargetLists.Append( VehicleSubsystem->mTargetLists );
+		OutErrorMessage = LOCTEXT("TransformPathRange_NotRigid", "Cannot move the Path Nodes as the transform would change the distances between them.");
+		return false;
 	}
-	else
+
+	TArray<AFGTargetPoint*> PathNodes;
+	if ( !GetPathNodeRange( FirstPathNode, LastPathNode, PathNodes ) )
 	{
-		for ( TActorIterator<AFGDrivingTargetList> It( GetWorld() ); It; ++It )
+		OutErrorMessage = LOCTEXT("TransformPathRange_InvalidRange", "Cannot move the Path Nodes as the first and the last Path Node are not on the same Path.");
+		return false;
+	}
+
+	TArray<FTransform> NewTransforms;
+	NewTransforms.Reserve( PathNodes.Num() );
+	for ( const AFGTargetPoint* PathNode : PathNodes )
+	{
+		// Rotation is rebuilt from the transformed axes, so that mirrored nodes keep facing along the path instead of ending up with a negative scale
+		const FVector NewForward = Transform.TransformVector( PathNode->GetActorForwardVector() );
+		const FVector NewUp = Transform.TransformVector( PathNode->GetActorUpVector() );
+		NewTransforms.Emplace( FRotationMatrix::MakeFromXZ( NewForward, NewUp ).ToQuat(), Transform.TransformPosition( PathNode->GetActorLocation() ) );
+
+		// The translation is not limited by the rigidity check, so every moved node has to stay inside of the world, including when the whole path is moved
+		if ( !IsLocationInWorldBounds( NewTransforms.Last().GetLocation() ) )
 		{
-			AFGDrivingTargetList* DrivingTargetList = *It;
-			if ( DrivingTargetList && !DrivingTargetList->IsTemporary() && DrivingTargetList->HasData() )
-			{
-				AllTargetLists.Add( DrivingTargetList );
-			}
+			OutErrorMessage = LOCTEXT("TransformPathRange_OutOfWorld", "Cannot move the Path Nodes as they would end up outside of the world.");
+			return false;
 		}
 	}
 
-	// If we are the client, we need to manually ensure that each target point has a valid cache owner list
-	if ( GetWorld()->IsNetMode( NM_Client ) )
+	// When the range covers the entire path there are no unmoved neighbours to check
+	if ( PathNodes.Num() < FirstPathNode->GetOwningList()->GetTargetCount() )
 	{
-		for ( AFGDrivingTargetList* DrivingTargetList : AllTargetLists )
+		const AFGTargetPoint* PrevPathNode = FindPrevTargetPoint( FirstPathNode );
+		const AFGTargetPoint* NextPathNode = FindNextTargetPoint( LastPathNode );
+		if ( !PrevPathNode || !NextPathNode || !CheckDistanceBetweenTwoPoints( NewTransforms[0].GetLocation(), PrevPathNode->GetActorLocation() ) ||
+			!CheckDistanceBetweenTwoPoints( NewTransforms.Last().GetLocation(), NextPathNode->GetActorLocation() ) )
 		{
-			for( AFGTargetPoint* Target = DrivingTargetList->GetFirstTarget(); Target; Target = Target->GetNext() )
-			{
-				Target->SetOwningList( DrivingTargetList );
-				Target->SetVisibility( DrivingTargetList->IsPathVisible() );
-			}
+			OutErrorMessage = LOCTEXT("TransformPathRange_TooFar", "Cannot move the Path Nodes as the ends of the range would be Too Far from their adjacent Path Nodes.");
+			return false;
 		}
 	}
 
-	// Update each target list have in the world
-	for ( AFGDrivingTargetList* DrivingTargetList : AllTargetLists )
+	// Clients predict the edit locally, the server will roll the nodes back if it rejects it
+	SetPathNodeTransformsInternal( PathNodes, NewTransforms );
+
+	if ( PlayerController && GetWorld()->IsNetMode( NM_Client ) )
 	{
-		FBVPVehiclePathVisualization*& ExistingVisualization = ExistingVisualizationPaths.FindOrAdd( DrivingTargetList );
-		if ( !ExistingVisualization )
+		if ( UBVPRemoteCallObject* RemoteCallObject = PlayerController->GetRemoteCallObjectOfClass<UBVPRemoteCallObject>() )
 		{
-			ExistingVisualization = new FBVPVehiclePathVisualization( this, DrivingTargetList );
-			VisualizedPaths.Add( ExistingVisualization );
+			RemoteCallObject->Server_TransformPathRange( FirstPathNode, LastPathNode, Transform );
 		}
-
-		fgcheck( ExistingVisualization->IsVisualizationValid() );
-		ExistingVisualization->UpdateVisualization();
 	}
+	return true;
 }
 
-void UBVPSubsystem::TickVisualizationTrackers()
+void UBVPSubsystem::SetPathNodeTransformsInternal( const TArray<AFGTargetPoint*>& PathNodes, const TArray<FTransform>& NewTransforms )
 {
-	// Cleanup stale or empty visualization trackers, as they use up performance
-	for ( int32 i = VisualizationTrackers.Num() - 1; i >= 0; i-- )
-	{
-		FBVPPlayerVisualizationTracker* VisualizationTracker = VisualizationTrackers[i];
-		fgcheck( VisualizationTracker );
+	fgcheck( PathNodes.Num() == NewTransforms.Num() );
 
-		if ( !VisualizationTracker->IsVisualizationTrackerValid() || VisualizationTracker->IsVisualizationTrackerEmpty() )
+	TSet<AFGDrivingTargetList*> AffectedTargetLists;
+	for ( int32 i = 0; i < PathNodes.Num(); i++ )
+	{
+		AFGTargetPoint* PathNode = PathNodes[i];
+		if ( PathNode )
 		{
-			VisualizationTracker->DestroyVisualizationTracker();
-			delete VisualizationTracker;
-			VisualizationTrackers.RemoveAt( i );
+			PathNode->SetActorLocationAndRotation( NewTransforms[i].GetLocation(), NewTransforms[i].GetRotation() );
+			PathNode->FlushNetDormancy();
+			PathNodeIndex.UpdatePathNode( PathNode );
+
+			if ( AFGDrivingTargetList* OwnerTargetList = PathNode->GetOwningList() )
+			{
+				AffectedTargetLists.Add( OwnerTargetList );
+			}
 		}
 	}
-	
-	// Update visualization trackers
-	for ( FBVPPlayerVisualizationTracker* VisualizationTracker : VisualizationTrackers )
-	{
-		fgcheck( VisualizationTracker );
-		fgcheck( VisualizationTracker->IsVisualizationTrackerValid() );
 
-		VisualizationTracker->UpdateVisualizationTracker();
+	for ( AFGDrivingTargetList* TargetList : AffectedTargetLists )
+	{
+		RebuildTargetListPath( TargetList );
 	}
+	ValidateEditedPaths( AffectedTargetLists );
 }
 
-void UBVPRemoteCallObject::GetLifetimeReplicatedProps( TArray<FLifetimeProperty>& OutLifetimeProps ) const
+bool UBVPSubsystem::RemovePathNodes( AFGPlayerController* PlayerController, const TArray<AFGTargetPoint*>& PathNodes, FText& OutErrorMessage )
 {
-	Super::GetLifetimeReplicatedProps( OutLifetimeProps );
+	if ( PathNodes.IsEmpty() || !CheckCanRemovePathNodes( PathNodes, OutErrorMessage ) )
+	{
+		return false;
+	}
+
+	// We cannot remove target points on the client, so ask the server to do so
+	if ( PlayerController && GetWorld()->IsNetMode( NM_Client ) )
+	{
+		if ( UBVPRemoteCallObject* RemoteCallObject = PlayerController->GetRemoteCallObjectOfClass<UBVPRemoteCallObject>() )
+		{
+			RemoteCallObject->Server_RemovePathNodes( PathNodes );
+			return true;
+		}
+		return false;
+	}
+
+	RemovePathNodesInternal( PathNodes );
+	return true;
+}
+
+void UBVPSubsystem::RemovePathNodesInternal( const TArray<AFGTargetPoint*>& PathNodes )
+{
+	TSet<AFGDrivingTargetList*> AffectedTargetLists;
+	for ( AFGTargetPoint* PathNode : TSet<AFGTargetPoint*>( PathNodes ) )
+	{
+		AFGDrivingTargetList* OwnerTargetList = PathNode->GetOwningList();
+		fgcheck( OwnerTargetList );
+
+		PathNodeIndex.RemovePathNode( PathNode );
+		OwnerTargetList->RemoveItem( PathNode );
+		AffectedTargetLists.Add( OwnerTargetList );
+	}
+
+	for ( AFGDrivingTargetList* TargetList : AffectedTargetLists )
+	{
+		RebuildTargetListPath( TargetList );
+	}
+	ValidateEditedPaths( AffectedTargetLists );
+}
+
+bool UBVPSubsystem::SimplifyPath( AFGPlayerController* PlayerController, AFGDrivingTargetList* TargetPointList, float Tolerance, int32 SpeedChangeThreshold, int32& OutNumRemovedNodes, FText& OutErrorMessage )
+{
+	OutNumRemovedNodes = 0;
+	if ( !TargetPointList || !TargetPointList->GetPath() )
+	{
+		OutErrorMessage = LOCTEXT("SimplifyPath_NoPath", "Cannot simplify the Path as it has not been built yet.");
+		return false;
+	}
+
+	// Clients have the same data, so they can tell how many nodes the server is going to remove
+	TArray<AFGTargetPoint*> RemovedPathNodes;
+	FindPathNodesToSimplify( TargetPointList, Tolerance, SpeedChangeThreshold, RemovedPathNodes );
+	OutNumRemovedNodes = RemovedPathNodes.Num();
+
+	if ( RemovedPathNodes.IsEmpty() )
+	{
+		return true;
+	}
+
+	if ( PlayerController && GetWorld()->IsNetMode( NM_Client ) )
+	{
+		if ( UBVPRemoteCallObject* RemoteCallObject = PlayerController->GetRemoteCallObjectOfClass<UBVPRemoteCallObject>() )
+		{
+			RemoteCallObject->Server_SimplifyPath( TargetPointList, Tolerance, SpeedChangeThreshold );
+			return true;
+		}
+		return false;
+	}
+
+	RemovePathNodesInternal( RemovedPathNodes );
+	return true;
+}
+
+bool UBVPSubsystem::ResamplePath( AFGPlayerController* PlayerController, AFGDrivingTargetList* TargetPointList, float Spacing, int32& OutNumPathNodes, FText& OutErrorMessage )
+{
+	OutNumPathNodes = 0;
+
+	TArray<FTransform> NewTransforms;
+	TArray<int32> NewTargetSpeeds;
+	if ( !TargetPointList || !ComputeResampledPathNodes( TargetPointList, Spacing, NewTransforms, NewTargetSpeeds ) )
+	{
+		OutErrorMessage = LOCTEXT("ResamplePath_NoPath", "Cannot resample the Path as it has not been built yet, is too short, or curves too tightly to keep the nodes far enough apart.");
+		return false;
+	}
+	OutNumPathNodes = NewTransforms.Num();
+
+	if ( PlayerController && GetWorld()->IsNetMode( NM_Client ) )
+	{
+		if ( UBVPRemoteCallObject* RemoteCallObject = PlayerController->GetRemoteCallObjectOfClass<UBVPRemoteCallObject>() )
+		{
+			RemoteCallObject->Server_ResamplePath( TargetPointList, Spacing );
+			return true;
+		}
+		return false;
+	}
+
+	ResamplePathInternal( TargetPointList, NewTransforms, NewTargetSpeeds );
+	return true;
+}
+
+void UBVPSubsystem::ResamplePathInternal( AFGDrivingTargetList* TargetPointList, const TArray<FTransform>& NewTransforms, const TArray<int32>& NewTargetSpeeds )
+{
+	TArray<AFGTargetPoint*> PathNodes;
+	GetTargetListPathNodes( TargetPointList, PathNodes );
+
+	// Reuse the existing nodes in their current order, and only spawn or remove the difference
+	const int32 NumReusedPathNodes = FMath::Min( PathNodes.Num(), NewTransforms.Num() );
+	for ( int32 i = 0; i < NumReusedPathNodes; i++ )
+	{
+		AFGTargetPoint* PathNode = PathNodes[i];
+		PathNode->SetActorLocationAndRotation( NewTransforms[i].GetLocation(), NewTransforms[i].GetRotation() );
+		PathNode->SetTargetSpeed( NewTargetSpeeds[i] );
+		PathNode->FlushNetDormancy();
+		PathNodeIndex.UpdatePathNode( PathNode );
+	}
+
+	AFGTargetPoint* LastPathNode = PathNodes[NumReusedPathNodes - 1];
+	for ( int32 i = NumReusedPathNodes; i < NewTransforms.Num(); i++ )
+	{
+		LastPathNode = SpawnPathNodeInternal( LastPathNode, NewTransforms[i], NewTargetSpeeds[i] );
+	}
+
+	for ( int32 i = NumReusedPathNodes; i < PathNodes.Num(); i++ )
+	{
+		PathNodeIndex.RemovePathNode( PathNodes[i] );
+		TargetPointList->RemoveItem( PathNodes[i] );
+	}
+	RebuildTargetListPath( TargetPointList );
+	ValidateEditedPaths( { TargetPointList } );
+}
+
+bool UBVPSubsystem::ComputeResampledPathNodes( const AFGDrivingTargetList* TargetPointList, float Spacing, TArray<FTransform>& OutTransforms, TArray<int32>& OutTargetSpeeds )
+{
+	fgcheck( TargetPointList );
+
+	TArray<AFGTargetPoint*> PathNodes;
+	GetTargetListPathNodes( TargetPointList, PathNodes );
+
+	TArray<FBVPHermiteSegment> PathSegments;
+	GetPathHermiteSegments( TargetPointList, PathSegments );
+
+	if ( PathNodes.Num() < 2 || PathSegments.Num() != PathNodes.Num() )
+	{
+		return false;
+	}
+
+	// Build the arc length table of the whole loop. Sample N of segment S is at S * NumSamplesPerSegment + N
+	constexpr int32 NumSamplesPerSegment = 16;
+	TArray<double> CumulativeLengths;
+	CumulativeLengths.Reserve( PathSegments.Num() * NumSamplesPerSegment + 1 );
+	CumulativeLengths.Add( 0.0 );
+
+	TArray<FVector> SegmentSamples;
+	for ( const FBVPHermiteSegment& PathSegment : PathSegments )
+	{
+		PathSegment.EvaluateUniform( NumSamplesPerSegment, SegmentSamples );
+		for ( int32 i = 1; i < SegmentSamples.Num(); i++ )
+		{
+			CumulativeLengths.Add( CumulativeLengths.Last() + FVector::Distance( SegmentSamples[i - 1], SegmentSamples[i] ) );
+		}
+	}
+
+	// Divide the loop evenly, rounding the node count up so that the spacing does not exceed the requested one,
+	// but never use more nodes than fit at the minimum distance, as the spacing would then fall below it
+	const UBVPSettings* BVPSettings = UBVPSettings::Get();
+	const double TotalLength = CumulativeLengths.Last();
+	const double MinSpacing = FMath::Max( (double) BVPSettings->MinDistanceBetweenPathNodes, 1.0 );
+	const double ClampedSpacing = FMath::Clamp( (double) Spacing, MinSpacing, FMath::Max( (double) BVPSettings->MaxDistanceBetweenPathNodes, MinSpacing ) );
+	const int32 MaxNumNewPathNodes = FMath::FloorToInt( TotalLength / MinSpacing );
+	if ( MaxNumNewPathNodes < 3 )
+	{
+		return false;
+	}
+	const int32 MinNumNewPathNodes = FMath::Max( FMath::CeilToInt( TotalLength / FMath::Max( (double) BVPSettings->MaxDistanceBetweenPathNodes, MinSpacing ) ), 3 );
+	if ( MinNumNewPathNodes > MaxNumNewPathNodes )
+	{
+		return false;
+	}
+
+	// Arc length spacing is above the minimum, but the chords between the nodes are shorter on tight curves. Use fewer nodes until all chords pass
+	constexpr int32 MaxSpacingAttempts = 8;
+	const int32 InitialNumNewPathNodes = FMath::Clamp( FMath::CeilToInt( TotalLength / ClampedSpacing ), MinNumNewPathNodes, MaxNumNewPathNodes );
+	for ( int32 NumNewPathNodes = InitialNumNewPathNodes; NumNewPathNodes >= MinNumNewPathNodes && NumNewPathNodes > InitialNumNewPathNodes - MaxSpacingAttempts; NumNewPathNodes-- )
+	{
+		SampleResampledPathNodes( PathNodes, PathSegments, CumulativeLengths, NumSamplesPerSegment, NumNewPathNodes, OutTransforms, OutTargetSpeeds );
+
+		bool bAllChordsValid = true;
+		for ( int32 i = 0; i < OutTransforms.Num() && bAllChordsValid; i++ )
+		{
+			const FVector Location = OutTransforms[i].GetLocation();
+			const FVector NextLocation = OutTransforms[( i + 1 ) % OutTransforms.Num()].GetLocation();
+			bAllChordsValid = FVector::Distance( Location, NextLocation ) >= MinSpacing && CheckDistanceBetweenTwoPoints( Location, NextLocation );
+		}
+		if ( bAllChordsValid )
+		{
+			return true;
+		}
+	}
+	OutTransforms.Reset();
+	OutTargetSpeeds.Reset();
+	return false;
+}
+
+void UBVPSubsystem::SampleResampledPathNodes( const TArray<AFGTargetPoint*>& PathNodes, const TArray<FBVPHermiteSegment>& PathSegments, const TArray<double>& CumulativeLengths,
+	int32 NumSamplesPerSegment, int32 NumNewPathNodes, TArray<FTransform>& OutTransforms, TArray<int32>& OutTargetSpeeds )
+{
+	const double NewSpacing = CumulativeLengths.Last() / NumNewPathNodes;
+
+	OutTransforms.Reset( NumNewPathNodes );
+	OutTargetSpeeds.Reset( NumNewPathNodes );
+
+	// Distances are monotonic, so the table can be walked once for all the new nodes
+	int32 CurrentSampleIndex = 0;
+	for ( int32 NewNodeIndex = 0; NewNodeIndex < NumNewPathNodes; NewNodeIndex++ )
+	{
+		const double Distance = NewNodeIndex * NewSpacing;
+		while ( CurrentSampleIndex + 1 < CumulativeLengths.Num() - 1 && CumulativeLengths[CurrentSampleIndex + 1] <= Distance )
+		{
+			CurrentSampleIndex++;
+		}
+		const double SampleLength = CumulativeLengths[CurrentSampleIndex + 1] - CumulativeLengths[CurrentSampleIndex];
+		const double SampleAlpha = SampleLength > UE_KINDA_SMALL_NUMBER ? ( Distance - CumulativeLengths[CurrentSampleIndex] ) / SampleLength : 0.0;
+
+		const int32 SegmentIndex = CurrentSampleIndex / NumSamplesPerSegment;
+		const double SegmentAlpha = ( CurrentSampleIndex % NumSamplesPerSegment + SampleAlpha ) / NumSamplesPerSegment;
+
+		const AFGTargetPoint* SegmentStartNode = PathNodes[SegmentIndex];
+		const AFGTargetPoint* SegmentEndNode = PathNodes[( SegmentIndex + 1 ) % PathNodes.Num()];
+
+		const FQuat NewRotation = FQuat::Slerp( SegmentStartNode->GetActorQuat(), SegmentEndNode->GetActorQuat(), SegmentAlpha );
+		OutTransforms.Emplace( NewRotation, PathSegments[SegmentIndex].EvaluatePosition( SegmentAlpha ) );
+		OutTargetSpeeds.Add( FMath::RoundToInt( FMath::Lerp( (double) SegmentStartNode->GetTargetSpeed(), (double) SegmentEndNode->GetTargetSpeed(), SegmentAlpha ) ) );
+	}
+}
+
+bool UBVPSubsystem::OptimizePathTargetSpeeds( AFGPlayerController* PlayerController, AFGDrivingTargetList* TargetPointList, TArray<int32>& OutTargetSpeeds, FText& OutErrorMessage )
+{
+	if ( !TargetPointList || !ComputeOptimizedTargetSpeeds( TargetPointList, OutTargetSpeeds ) )
+	{
+		OutErrorMessage = LOCTEXT("OptimizePathTargetSpeeds_NoPath", "Cannot optimize the Path speeds as the Path has not been built yet.");
+		return false;
+	}
+
+	// Clients get the same speeds for the preview, but the server recomputes them from its own data
+	if ( PlayerController && GetWorld()->IsNetMode( NM_Client ) )
+	{
+		if ( UBVPRemoteCallObject* RemoteCallObject = PlayerController->GetRemoteCallObjectOfClass<UBVPRemoteCallObject>() )
+		{
+			RemoteCallObject->Server_OptimizePathTargetSpeeds( TargetPointList );
+			return true;
+		}
+		return false;
+	}
+
+	int32 NodeIndex = 0;
+	for ( AFGTargetPoint* PathNode = TargetPointList->GetFirstTarget(); PathNode != nullptr && OutTargetSpeeds.IsValidIndex( NodeIndex ); PathNode = PathNode->GetNext() )
+	{
+		PathNode->SetTargetSpeed( OutTargetSpeeds[NodeIndex++] );
+	}
+	return true;
+}
+
+bool UBVPSubsystem::ReversePath( AFGPlayerController* PlayerController, AFGDrivingTargetList* TargetPointList, FText& OutErrorMessage )
+{
+	if ( !TargetPointList || !TargetPointList->HasData() || TargetPointList->GetTargetCount() < 2 )
+	{
+		OutErrorMessage = LOCTEXT("ReversePath_NoPath", "Cannot reverse the Path as it does not have enough Path Nodes.");
+		return false;
+	}
+
+	// Relinking the nodes is not predicted, since the links are replicated from the server anyway
+	if ( PlayerController && GetWorld()->IsNetMode( NM_Client ) )
+	{
+		if ( UBVPRemoteCallObject* RemoteCallObject = PlayerController->GetRemoteCallObjectOfClass<UBVPRemoteCallObject>() )
+		{
+			RemoteCallObject->Server_ReversePath( TargetPointList );
+			return true;
+		}
+		return false;
+	}
+
+	ReversePathInternal( TargetPointList );
+	return true;
+}
+
+bool UBVPSubsystem::SplitPathAtNode( AFGPlayerController* PlayerController, AFGTargetPoint* FirstPathNode, AFGTargetPoint* LastPathNode, FText& OutErrorMessage )
+{
+	TArray<AFGTargetPoint*> SplitPathNodes;
+	if ( !GetPathNodeRange( FirstPathNode, LastPathNode, SplitPathNodes ) )
+	{
+		return false;
+	}
+
+	// Both paths need at least two nodes to form a loop
+	const int32 NumRemainingPathNodes = FirstPathNode->GetOwningList()->GetTargetCount() - SplitPathNodes.Num();
+	if ( SplitPathNodes.Num() < 2 || NumRemainingPathNodes < 2 )
+	{
+		OutErrorMessage = LOCTEXT("SplitPath_TooShort", "Cannot split the Path as both Paths need to have at least 2 Path Nodes.");
+		return false;
+	}
+	// Vehicles keep the original list, so the ones heading into the split part would be left following nodes that are no longer on their path
+	if ( IsPathNodeRangeUsedByVehicles( FirstPathNode->GetOwningList(), SplitPathNodes ) )
+	{
+		OutErrorMessage = LOCTEXT("SplitPath_InUse", "Cannot split the Path as there are vehicles driving on the split part. Wait for them to leave it or split the other part of the Path.");
+		return false;
+	}
+
+	const AFGTargetPoint* PrevPathNode = FindPrevTargetPoint( FirstPathNode );
+	const AFGTargetPoint* NextPathNode = FindNextTargetPoint( LastPathNode );
+	if ( !PrevPathNode || !NextPathNode || !CheckDistanceBetweenTwoPoints( LastPathNode->GetActorLocation(), FirstPathNode->GetActorLocation() ) ||
+		!CheckDistanceBetweenTwoPoints( PrevPathNode->GetActorLocation(), NextPathNode->GetActorLocation() ) )
+	{
+		OutErrorMessage = LOCTEXT("SplitPath_TooFar", "Cannot split the Path as the Path Nodes at the cut would be Too Far from each other.");
+		return false;
+	}
+
+	if ( PlayerController && GetWorld()->IsNetMode( NM_Client ) )
+	{
+		if ( UBVPRemoteCallObject* RemoteCallObject = PlayerController->GetRemoteCallObjectOfClass<UBVPRemoteCallObject>() )
+		{
+			RemoteCallObject->Server_SplitPathAtNode( FirstPathNode, LastPathNode );
+			return true;
+		}
+		return false;
+	}
+
+	SplitPathInternal( SplitPathNodes );
+	return true;
+}
+
+bool UBVPSubsystem::MergePaths( AFGPlayerController* PlayerController, AFGTargetPoint* AfterPathNode, AFGTargetPoint* FirstMergedPathNode, FText& OutErrorMessage )
+{
+	const AFGDrivingTargetList* TargetPointList = AfterPathNode ? AfterPathNode->GetOwningList() : nullptr;
+	const AFGDrivingTargetList* MergedTargetPointList = FirstMergedPathNode ? FirstMergedPathNode->GetOwningList() : nullptr;
+	if ( !TargetPointList || !MergedTargetPointList )
+	{
+		return false;
+	}
+	if ( TargetPointList == MergedTargetPointList )
+	{
+		OutErrorMessage = LOCTEXT("MergePaths_SamePath", "Cannot merge the Path with itself.");
+		return false;
+	}
+	// Merged path is destroyed, so the vehicles driving it would be left without one
+	if ( IsTargetListUsedByVehicles( MergedTargetPointList ) )
+	{
+		OutErrorMessage = LOCTEXT("MergePaths_InUse", "Cannot merge the Paths as there are vehicles using the merged Path. Assign them to another Path first.");
+		return false;
+	}
+
+	// The merged path is walked all the way around, ending at the node right before the first merged one
+	TArray<AFGTargetPoint*> MergedPathNodes;
+	if ( !GetPathNodeRange( FirstMergedPathNode, FindPrevTargetPoint( FirstMergedPathNode ), MergedPathNodes ) )
+	{
+		return false;
+	}
+
+	const AFGTargetPoint* NextPathNode = FindNextTargetPoint( AfterPathNode );
+	if ( !NextPathNode || !CheckDistanceBetweenTwoPoints( AfterPathNode->GetActorLocation(), FirstMergedPathNode->GetActorLocation() ) ||
+		!CheckDistanceBetweenTwoPoints( MergedPathNodes.Last()->GetActorLocation(), NextPathNode->GetActorLocation() ) )
+	{
+		OutErrorMessage = LOCTEXT("MergePaths_TooFar", "Cannot merge the Paths as the Path Nodes at the seams would be Too Far from each other.");
+		return false;
+	}
+
+	if ( PlayerController && GetWorld()->IsNetMode( NM_Client ) )
+	{
+		if ( UBVPRemoteCallObject* RemoteCallObject = PlayerController->GetRemoteCallObjectOfClass<UBVPRemoteCallObject>() )
+		{
+			RemoteCallObject->Server_MergePaths( AfterPathNode, FirstMergedPathNode );
+			return true;
+		}
+		return false;
+	}
+
+	MergePathsInternal( AfterPathNode, MergedPathNodes );
+	return true;
+}
+
+void UBVPSubsystem::SplitPathInternal( const TArray<AFGTargetPoint*>& SplitPathNodes )
+{
+	AFGDrivingTargetList* TargetPointList = SplitPathNodes[0]->GetOwningList();
+	fgcheck( TargetPointList );
+
+	// The split nodes are a contiguous part of the loop, so the nodes left behind keep their order and close the loop at the cut
+	const TSet<AFGTargetPoint*> SplitPathNodeSet( SplitPathNodes );
+	TArray<AFGTargetPoint*> RemainingPathNodes;
+	GetTargetListPathNodes( TargetPointList, RemainingPathNodes );
+	RemainingPathNodes.RemoveAll( [&]( const AFGTargetPoint* PathNode ) { return SplitPathNodeSet.Contains( PathNode ); } );
+
+	AFGDrivingTargetList* NewTargetPointList = SpawnTargetListInternal();
+	LinkPathNodesInternal( TargetPointList, RemainingPathNodes );
+	LinkPathNodesInternal( NewTargetPointList, SplitPathNodes );
+
+	// Visualization of the existing path is patched on its next update, keeping the segments of the nodes that are left in it
+	RebuildTargetListPath( TargetPointList );
+	MarkTargetListComplete( NewTargetPointList );
+	RebuildTargetListPath( NewTargetPointList );
+	RegisterTargetListInternal( NewTargetPointList );
+	ValidateEditedPaths( { TargetPointList, NewTargetPointList } );
+}
+
+void UBVPSubsystem::MergePathsInternal( AFGTargetPoint* AfterPathNode, const TArray<AFGTargetPoint*>& MergedPathNodes )
+{
+	AFGDrivingTargetList* TargetPointList = AfterPathNode->GetOwningList();
+	AFGDrivingTargetList* MergedTargetPointList = MergedPathNodes[0]->GetOwningList();
+	fgcheck( TargetPointList && MergedTargetPointList );
+
+	TArray<AFGTargetPoint*> PathNodes;
+	GetTargetListPathNodes( TargetPointList, PathNodes );
+	PathNodes.Insert( MergedPathNodes, PathNodes.Find( AfterPathNode ) + 1 );
+	LinkPathNodesInternal( TargetPointList, PathNodes );
+
+	// Detach the nodes from the merged list before destroying it, so that they are not destroyed together with it
+	MergedTargetPointList->mFirst = nullptr;
+	MergedTargetPointList->mLast = nullptr;
+	if ( AFGVehicleSubsystem* VehicleSubsystem = AFGVehicleSubsystem::Get( GetWorld() ) )
+	{
+		VehicleSubsystem->mTargetLists.Remove( MergedTargetPointList );
+	}
+	MergedTargetPointList->Destroy();
+
+	// Visualization of the path keeps the segments of its own nodes, and the merged path visualization is dropped as stale
+	RebuildTargetListPath( TargetPointList );
+	ValidateEditedPaths( { TargetPointList } );
+}
+
+bool UBVPSubsystem::IsTargetListUsedByVehicles( const AFGDrivingTargetList* TargetPointList ) const
+{
+	for ( TActorIterator<AFGWheeledVehicle> It( GetWorld() ); It; ++It )
+	{
+		if ( It->GetTargetList() == TargetPointList )
+		{
+			return true;
+		}
+	}
+	return false;
+}
+
+bool UBVPSubsystem::IsPathNodeRangeUsedByVehicles( const AFGDrivingTargetList* TargetPointList, const TArray<AFGTargetPoint*>& PathNodes ) const
+{
+	for ( TActorIterator<AFGWheeledVehicle> It( GetWorld() ); It; ++It )
+	{
+		if ( It->GetTargetList() == TargetPointList && PathNodes.Contains( It->GetCurrentTarget() ) )
+		{
+			return true;
+		}
+	}
+	return false;
+}
+
+AFGDrivingTargetList* UBVPSubsystem::SpawnTargetListInternal()
+{
+	FActorSpawnParameters SpawnParameters;
+	SpawnParameters.SpawnCollisionHandlingOverride = ESpawnActorCollisionHandlingMethod::AlwaysSpawn;
+	AFGDrivingTargetList* NewTargetList = GetWorld()->SpawnActor<AFGDrivingTargetList>( SpawnParameters );
+	fgcheck( NewTargetList );
+	return NewTargetList;
+}
+
+void UBVPSubsystem::RegisterTargetListInternal( AFGDrivingTargetList* TargetPointList )
+{
+	if ( AFGVehicleSubsystem* VehicleSubsystem = AFGVehicleSubsystem::Get( GetWorld() ) )
+	{
+		VehicleSubsystem->mTargetLists.AddUnique( TargetPointList );
+	}
+}
+
+void UBVPSubsystem::MarkTargetListComplete( AFGDrivingTargetList* TargetPointList )
+{
+	fgcheck( TargetPointList );
+	TargetPointList->mIsComplete = true;
+}
+
+void UBVPSubsystem::LinkPathNodesInternal( AFGDrivingTargetList* TargetPointList, const TArray<AFGTargetPoint*>& PathNodes )
+{
+	fgcheck( !PathNodes.IsEmpty() );
+
+	for ( int32 i = 0; i < PathNodes.Num(); i++ )
+	{
+		AFGTargetPoint* PathNode = PathNodes[i];
+		PathNode->SetNext( PathNodes.IsValidIndex( i + 1 ) ? PathNodes[i + 1] : nullptr );
+		if ( PathNode->GetOwningList() != TargetPointList )
+		{
+			PathNode->SetOwningList( TargetPointList );
+			PathNode->SetOwner( TargetPointList );
+			PathNodeIndex.UpdatePathNode( PathNode );
+		}
+		PathNode->FlushNetDormancy();
+	}
+	TargetPointList->mFirst = PathNodes[0];
+	TargetPointList->mLast = PathNodes.Last();
+	TargetPointList->FlushNetDormancy();
+}
+
+void UBVPSubsystem::ReversePathInternal( AFGDrivingTargetList* TargetPointList )
+{
+	TArray<AFGTargetPoint*> PathNodes;
+	GetTargetListPathNodes( TargetPointList, PathNodes );
+
+	const int32 NumPathNodes = PathNodes.Num();
+	if ( NumPathNodes < 2 )
+	{
+		return;
+	}
+
+	// Segment N starts at the node N, so once reversed the segment between two nodes starts at the node that used to end it.
+	// Every node takes the target speed of the node before it, so that the segments keep their speeds
+	TArray<int32> OldTargetSpeeds;
+	OldTargetSpeeds.Reserve( NumPathNodes );
+	for ( const AFGTargetPoint* PathNode : PathNodes )
+	{
+		OldTargetSpeeds.Add( PathNode->GetTargetSpeed() );
+	}
+
+	const FQuat TurnAroundRotation( FVector::UpVector, UE_PI );
+	for ( int32 i = 0; i < NumPathNodes; i++ )
+	{
+		AFGTargetPoint* PathNode = PathNodes[i];
+		PathNode->SetNext( i > 0 ? PathNodes[i - 1] : nullptr );
+		PathNode->SetTargetSpeed( OldTargetSpeeds[( i + NumPathNodes - 1 ) % NumPathNodes] );
+		// Turn the node around its own up axis, so that the nodes on slopes keep their pitch relative to the ground
+		PathNode->SetActorRotation( PathNode->GetActorQuat() * TurnAroundRotation );
+		PathNode->FlushNetDormancy();
+	}
+	TargetPointList->mFirst = PathNodes.Last();
+	TargetPointList->mLast = PathNodes[0];
+	TargetPointList->FlushNetDormancy();
+
+	RebuildTargetListPath( TargetPointList );
+	ValidateEditedPaths( { TargetPointList } );
+}
+
+bool UBVPSubsystem::ComputeOptimizedTargetSpeeds( const AFGDrivingTargetList* TargetPointList, TArray<int32>& OutTargetSpeeds )
+{
+	fgcheck( TargetPointList );
+	OutTargetSpeeds.Reset();
+
+	TArray<FBVPHermiteSegment> PathSegments;
+	GetPathHermiteSegments( TargetPointList, PathSegments );
+
+	const int32 NumPathNodes = TargetPointList->GetTargetCount();
+	if ( PathSegments.Num() < 2 || PathSegments.Num() != NumPathNodes )
+	{
+		return false;
+	}
+
+	const UBVPSettings* BVPSettings = UBVPSettings::Get();
+	const int32 NumSamplesPerSegment = FMath::Max( BVPSettings->SpeedOptimizerSamplesPerSegment, 2 );
+	const int32 NumSamples = PathSegments.Num() * NumSamplesPerSegment;
+
+	// World units are centimeters, speeds are computed in m/s and converted to km/h at the end
+	const double MaxSpeed = BVPSettings->MaxTargetSpeed / FBVPSpeedProfile::MetersPerSecondToKilometersPerHour;
+	const double MinSpeed = FMath::Min( BVPSettings->MinOptimizedTargetSpeed, BVPSettings->MaxTargetSpeed ) / FBVPSpeedProfile::MetersPerSecondToKilometersPerHour;
+	const double MaxLateralAcceleration = FMath::Max( BVPSettings->MaxLateralAcceleration, UE_KINDA_SMALL_NUMBER );
+
+	// Speed cap from the curvature, the grade and the distance to the next sample for each sample along the loop
+	FBVPSpeedProfile SpeedProfile;
+	SpeedProfile.SetNumSamples( NumSamples );
+
+	TArray<double> SampleAlphas;
+	SampleAlphas.SetNumUninitialized( NumSamplesPerSegment + 1 );
+	for ( int32 i = 0; i <= NumSamplesPerSegment; i++ )
+	{
+		SampleAlphas[i] = (double) i / NumSamplesPerSegment;
+	}
+
+	TArray<FVector> Positions, Derivatives;
+	Positions.SetNumUninitialized( NumSamplesPerSegment + 1 );
+	Derivatives.SetNumUninitialized( NumSamplesPerSegment + 1 );
+
+	for ( int32 SegmentIndex = 0; SegmentIndex < PathSegments.Num(); SegmentIndex++ )
+	{
+		const FBVPHermiteSegment& PathSegment = PathSegments[SegmentIndex];
+		PathSegment.EvaluateBatch( SampleAlphas, Positions, Derivatives );
+
+		for ( int32 i = 0; i < NumSamplesPerSegment; i++ )
+		{
+			const int32 SampleIndex = SegmentIndex * NumSamplesPerSegment + i;
+			const FVector& Derivative = Derivatives[i];
+			const double DerivativeSize = Derivative.Size();
+
+			// Curvature of a parametric curve is |P' x P''| / |P'|^3
+			double SpeedLimit = MaxSpeed;
+			if ( DerivativeSize > UE_KINDA_SMALL_NUMBER )
+			{
+				const double Curvature = FVector::CrossProduct( Derivative, PathSegment.EvaluateSecondDerivative( SampleAlphas[i] ) ).Size() / FMath::Pow( DerivativeSize, 3.0 );
+				const double CurvatureInMeters = Curvature / FBVPSpeedProfile::CentimetersToMeters;
+				if ( CurvatureInMeters > UE_KINDA_SMALL_NUMBER )
+				{
+					SpeedLimit = FMath::Min( SpeedLimit, FMath::Sqrt( MaxLateralAcceleration / CurvatureInMeters ) );
+				}
+			}
+			SpeedProfile.SampleSpeeds[SampleIndex] = FMath::Max( SpeedLimit, MinSpeed );
+			SpeedProfile.SampleGrades[SampleIndex] = DerivativeSize > UE_KINDA_SMALL_NUMBER ? Derivative.Z / DerivativeSize : 0.0;
+			SpeedProfile.SampleDistances[SampleIndex] = FVector::Distance( Positions[i], Positions[i + 1] ) * FBVPSpeedProfile::CentimetersToMeters;
+		}
+	}
+	SpeedProfile.ApplyAccelerationLimits( BVPSettings->MaxLongitudinalAcceleration, BVPSettings->MaxLongitudinalDeceleration );
+	const TArray<double>& SampleSpeeds = SpeedProfile.SampleSpeeds;
+
+	// Each node takes the lowest speed within the window around it, from the middle of the previous segment to the middle of the next one
+	OutTargetSpeeds.SetNumUninitialized( NumPathNodes );
+	const int32 HalfWindow = NumSamplesPerSegment / 2;
+
+	for ( int32 NodeIndex = 0; NodeIndex < NumPathNodes; NodeIndex++ )
+	{
+		double NodeSpeed = MaxSpeed;
+		for ( int32 Offset = -HalfWindow; Offset <= HalfWindow; Offset++ )
+		{
+			NodeSpeed = FMath::Min( NodeSpeed, SampleSpeeds[( NodeIndex * NumSamplesPerSegment + Offset + NumSamples ) % NumSamples] );
+		}
+		OutTargetSpeeds[NodeIndex] = FMath::Clamp( FMath::FloorToInt( NodeSpeed * FBVPSpeedProfile::MetersPerSecondToKilometersPerHour ), BVPSettings->MinOptimizedTargetSpeed, BVPSettings->MaxTargetSpeed );
+	}
+	return true;
+}
+
+bool UBVPSubsystem::ComputePathTravelTime( const AFGDrivingTargetList* TargetPointList, FBVPPathTravelTimeEstimate& OutEstimate )
+{
+	fgcheck( TargetPointList );
+	OutEstimate = FBVPPathTravelTimeEstimate();
+
+	TArray<AFGTargetPoint*> PathNodes;
+	GetTargetListPathNodes( TargetPointList, PathNodes );
+
+	TArray<FBVPHermiteSegment> PathSegments;
+	GetPathHermiteSegments( TargetPointList, PathSegments );
+
+	if ( PathNodes.Num() < 2 || PathSegments.Num() != PathNodes.Num() )
+	{
+		return false;
+	}
+
+	const UBVPSettings* BVPSettings = UBVPSettings::Get();
+	const int32 NumSamplesPerSegment = FMath::Max( BVPSettings->SpeedOptimizerSamplesPerSegment, 2 );
+
+	FBVPSpeedProfile SpeedProfile;
+	SpeedProfile.SetNumSamples( PathSegments.Num() * NumSamplesPerSegment );
+
+	TArray<double> SampleAlphas;
+	SampleAlphas.SetNumUninitialized( NumSamplesPerSegment + 1 );
+	for ( int32 i = 0; i <= NumSamplesPerSegment; i++ )
+	{
+		SampleAlphas[i] = (double) i / NumSamplesPerSegment;
+	}
+
+	TArray<FVector> Positions, Derivatives;
+	Positions.SetNumUninitialized( NumSamplesPerSegment + 1 );
+	Derivatives.SetNumUninitialized( NumSamplesPerSegment + 1 );
+
+	// The vehicle aims for the target speed interpolated between the nodes, the same way the path editor interpolates it
+	for ( int32 SegmentIndex = 0; SegmentIndex < PathSegments.Num(); SegmentIndex++ )
+	{
+		PathSegments[SegmentIndex].EvaluateBatch( SampleAlphas, Positions, Derivatives );
+
+		const double StartSpeed = PathNodes[SegmentIndex]->GetTargetSpeed() / FBVPSpeedProfile::MetersPerSecondToKilometersPerHour;
+		const double EndSpeed = PathNodes[( SegmentIndex + 1 ) % PathNodes.Num()]->GetTargetSpeed() / FBVPSpeedProfile::MetersPerSecondToKilometersPerHour;
+
+		for ( int32 i = 0; i < NumSamplesPerSegment; i++ )
+		{
+			const int32 SampleIndex = SegmentIndex * NumSamplesPerSegment + i;
+			const double DerivativeSize = Derivatives[i].Size();
+
+			SpeedProfile.SampleSpeeds[SampleIndex] = FMath::Max( FMath::Lerp( StartSpeed, EndSpeed, SampleAlphas[i] ), 0.0 );
+			SpeedProfile.SampleGrades[SampleIndex] = DerivativeSize > UE_KINDA_SMALL_NUMBER ? Derivatives[i].Z / DerivativeSize : 0.0;
+			SpeedProfile.SampleDistances[SampleIndex] = FVector::Distance( Positions[i], Positions[i + 1] ) * FBVPSpeedProfile::CentimetersToMeters;
+		}
+	}
+	SpeedProfile.ApplyAccelerationLimits( BVPSettings->MaxLongitudinalAcceleration, BVPSettings->MaxLongitudinalDeceleration );
+
+	OutEstimate.SegmentLengths.SetNumZeroed( PathSegments.Num() );
+	OutEstimate.SegmentTravelTimes.SetNumZeroed( PathSegments.Num() );
+
+	for ( int32 SegmentIndex = 0; SegmentIndex < PathSegments.Num(); SegmentIndex++ )
+	{
+		const int32 FirstSampleIndex = SegmentIndex * NumSamplesPerSegment;
+
+		double SegmentLength = 0.0;
+		for ( int32 i = 0; i < NumSamplesPerSegment; i++ )
+		{
+			SegmentLength += SpeedProfile.SampleDistances[FirstSampleIndex + i];
+		}
+		OutEstimate.SegmentLengths[SegmentIndex] = SegmentLength / FBVPSpeedProfile::CentimetersToMeters;
+		OutEstimate.SegmentTravelTimes[SegmentIndex] = SpeedProfile.ComputeTravelTime( FirstSampleIndex, FirstSampleIndex + NumSamplesPerSegment );
+
+		OutEstimate.PathLength += OutEstimate.SegmentLengths[SegmentIndex];
+		OutEstimate.LapTime += OutEstimate.SegmentTravelTimes[SegmentIndex];
+	}
+	return true;
+}
+
+FBVPVehiclePathVisualization* UBVPSubsystem::FindPathVisualization( const AFGDrivingTargetList* TargetPointList ) const
+{
+	FBVPVehiclePathVisualization* const* PathVisualization = VisualizedPathsByTargetList.Find( TargetPointList );
+	return PathVisualization ? *PathVisualization : nullptr;
+}
+
+void UBVPSubsystem::FindPathNodesToSimplify( const AFGDrivingTargetList* TargetPointList, float Tolerance, int32 SpeedChangeThreshold, TArray<AFGTargetPoint*>& OutRemovedPathNodes )
+{
+	fgcheck( TargetPointList );
+	OutRemovedPathNodes.Reset();
+
+	TArray<AFGTargetPoint*> PathNodes;
+	GetTargetListPathNodes( TargetPointList, PathNodes );
+
+	TArray<FBVPHermiteSegment> PathSegments;
+	GetPathHermiteSegments( TargetPointList, PathSegments );
+
+	// Path needs at least 3 nodes to stay a loop, and the spline has to be in sync with the nodes to be used as a reference
+	constexpr int32 MinPathNodes = 3;
+	const int32 NumPathNodes = PathNodes.Num();
+	if ( NumPathNodes <= MinPathNodes || PathSegments.Num() != NumPathNodes )
+	{
+		return;
+	}
+
+	// Sample the original spline densely. Node N is at the sample N * NumSamplesPerSegment, and the last sample closes the loop back at the first node
+	constexpr int32 NumSamplesPerSegment = 8;
+	TArray<FVector> SplineSamples;
+	SplineSamples.Reserve( NumPathNodes * NumSamplesPerSegment + 1 );
+
+	TArray<FVector> SegmentSamples;
+	for ( const FBVPHermiteSegment& PathSegment : PathSegments )
+	{
+		PathSegment.EvaluateUniform( NumSamplesPerSegment, SegmentSamples );
+		SplineSamples.Append( SegmentSamples.GetData(), NumSamplesPerSegment );
+	}
+	SplineSamples.Add( SplineSamples[0] );
+
+	const auto GetNodeSpeed = [&]( int32 NodeIndex ) { return PathNodes[NodeIndex % NumPathNodes]->GetTargetSpeed(); };
+	const float MaxDistanceBetweenPathNodes = UBVPSettings::Get()->MaxDistanceBetweenPathNodes;
+
+	// The first node is always kept as the head of the list, the node furthest away from it is used as the second anchor to split the loop into two spans
+	TArray<bool> KeepPathNode;
+	KeepPathNode.SetNumZeroed( NumPathNodes );
+	KeepPathNode[0] = true;
+
+	int32 SecondAnchorIndex = 1;
+	for ( int32 i = 2; i < NumPathNodes; i++ )
+	{
+		if ( FVector::DistSquared( SplineSamples[i * NumSamplesPerSegment], SplineSamples[0] ) > FVector::DistSquared( SplineSamples[SecondAnchorIndex * NumSamplesPerSegment], SplineSamples[0] ) )
+		{
+			SecondAnchorIndex = i;
+		}
+	}
+	KeepPathNode[SecondAnchorIndex] = true;
+
+	// Douglas-Peucker over the spans between the kept nodes. The end node index of the last span is NumPathNodes, which wraps back to the first node
+	TArray<TPair<int32, int32>> PendingSpans{ { 0, SecondAnchorIndex }, { SecondAnchorIndex, NumPathNodes } };
+	while ( !PendingSpans.IsEmpty() )
+	{
+		const TPair<int32, int32> Span = PendingSpans.Pop();
+		const int32 StartNode = Span.Key;
+		const int32 EndNode = Span.Value;
+
+		if ( EndNode - StartNode < 2 )
+		{
+			continue;
+		}
+		int32 SplitNode = INDEX_NONE;
+
+		// Nodes that change the speed relative to the start of the span by more than the threshold cannot be removed
+		for ( int32 NodeIndex = StartNode + 1; NodeIndex < EndNode; NodeIndex++ )
+		{
+			if ( FMath::Abs( GetNodeSpeed( NodeIndex ) - GetNodeSpeed( StartNode ) ) > SpeedChangeThreshold )
+			{
+				SplitNode = NodeIndex;
+				break;
+			}
+		}
+
+		// Otherwise split at the node closest to the sample that deviates the most from the chord, if it is beyond the tolerance
+		const FVector& ChordStart = SplineSamples[StartNode * NumSamplesPerSegment];
+		const FVector& ChordEnd = SplineSamples[EndNode * NumSamplesPerSegment];
+		if ( SplitNode == INDEX_NONE )
+		{
+			double MaxDeviation = 0.0;
+			int32 MaxDeviationSample = INDEX_NONE;
+			for ( int32 SampleIndex = StartNode * NumSamplesPerSegment + 1; SampleIndex < EndNode * NumSamplesPerSegment; SampleIndex++ )
+			{
+				const double Deviation = FMath::PointDistToSegment( SplineSamples[SampleIndex], ChordStart, ChordEnd );
+				if ( Deviation > MaxDeviation )
+				{
+					MaxDeviation = Deviation;
+					MaxDeviationSample = SampleIndex;
+				}
+			}
+			if ( MaxDeviation > Tolerance )
+			{
+				SplitNode = FMath::Clamp( FMath::RoundToInt( (float) MaxDeviationSample / NumSamplesPerSegment ), StartNode + 1, EndNode - 1 );
+			}
+		}
+
+		// Finally, nodes cannot be further away from each other than allowed
+		if ( SplitNode == INDEX_NONE && FVector::Distance( ChordStart, ChordEnd ) > MaxDistanceBetweenPathNodes )
+		{
+			SplitNode = ( StartNode + EndNode ) / 2;
+		}
+
+		if ( SplitNode != INDEX_NONE )
+		{
+			KeepPathNode[SplitNode] = true;
+			PendingSpans.Emplace( StartNode, SplitNode );
+			PendingSpans.Emplace( SplitNode, EndNode );
+		}
+	}
+
+	// Keep enough nodes for the path to stay a loop by adding back the nodes furthest from the kept ones
+	int32 NumKeptPathNodes = Algo::Count( KeepPathNode, true );
+	while ( NumKeptPathNodes < MinPathNodes )
+	{
+		int32 FurthestNodeIndex = INDEX_NONE;
+		double FurthestNodeDistance = -1.0;
+
+		for ( int32 i = 0; i < NumPathNodes; i++ )
+		{
+			if ( KeepPathNode[i] )
+			{
+				continue;
+			}
+			double ClosestKeptNodeDistance = UE_BIG_NUMBER;
+			for ( int32 j = 0; j < NumPathNodes; j++ )
+			{
+				if ( KeepPathNode[j] )
+				{
+					ClosestKeptNodeDistance = FMath::Min( ClosestKeptNodeDistance, FVector::Distance( PathNodes[i]->GetActorLocation(), PathNodes[j]->GetActorLocation() ) );
+				}
+			}
+			if ( ClosestKeptNodeDistance > FurthestNodeDistance )
+			{
+				FurthestNodeDistance = ClosestKeptNodeDistance;
+				FurthestNodeIndex = i;
+			}
+		}
+		KeepPathNode[FurthestNodeIndex] = true;
+		NumKeptPathNodes++;
+	}
+
+	for ( int32 i = 0; i < NumPathNodes; i++ )
+	{
+		if ( !KeepPathNode[i] )
+		{
+			OutRemovedPathNodes.Add( PathNodes[i] );
+		}
+	}
+}
+
+bool UBVPSubsystem::CheckCanApplyPathNodeTransforms( const TArray<AFGTargetPoint*>& PathNodes, const TArray<FTransform>& NewTransforms, bool bRigidTransform, FText& OutErrorMessage )
+{
+	if ( PathNodes.Num() != NewTransforms.Num() )
+	{
+		return false;
+	}
+
+	TMap<const AFGTargetPoint*, FVector> NewLocations;
+	TSet<const AFGDrivingTargetList*> AffectedTargetLists;
+	for ( int32 i = 0; i < PathNodes.Num(); i++ )
+	{
+		if ( !PathNodes[i] || !PathNodes[i]->GetOwningList() )
+		{
+			return false;
+		}
+		NewLocations.Add( PathNodes[i], NewTransforms[i].GetLocation() );
+		AffectedTargetLists.Add( PathNodes[i]->GetOwningList() );
+	}
+
+	// The rigid transform flag can come from the client, so make sure that all nodes have actually moved by the same transform before trusting it
+	if ( bRigidTransform )
+	{
+		constexpr double RigidTransformTolerance = 1.0;
+		const FTransform DeltaTransform = PathNodes[0]->GetActorTransform().Inverse() * NewTransforms[0];
+
+		for ( int32 i = 1; i < PathNodes.Num() && bRigidTransform; i++ )
+		{
+			const FVector ExpectedLocation = ( PathNodes[i]->GetActorTransform() * DeltaTransform ).GetLocation();
+			bRigidTransform = ExpectedLocation.Equals( NewTransforms[i].GetLocation(), RigidTransformTolerance );
+		}
+	}
+
+	// Check the links between the adjacent nodes. Rigid transforms keep the distance between two moved nodes, so only the links at the boundary of the selection need checking
+	TArray<AFGTargetPoint*> ListPathNodes;
+	for ( const AFGDrivingTargetList* TargetList : AffectedTargetLists )
+	{
+		GetTargetListPathNodes( TargetList, ListPathNodes );
+
+		for ( int32 i = 0; i < ListPathNodes.Num(); i++ )
+		{
+			const AFGTargetPoint* PathNodeA = ListPathNodes[i];
+			const AFGTargetPoint* PathNodeB = ListPathNodes[( i + 1 ) % ListPathNodes.Num()];
+			const FVector* NewLocationA = NewLocations.Find( PathNodeA );
+			const FVector* NewLocationB = NewLocations.Find( PathNodeB );
+
+			if ( ( !NewLocationA && !NewLocationB ) || ( bRigidTransform && NewLocationA && NewLocationB ) )
+			{
+				continue;
+			}
+			if ( !CheckDistanceBetweenTwoPoints( NewLocationA ? *NewLocationA : PathNodeA->GetActorLocation(), NewLocationB ? *NewLocationB : PathNodeB->GetActorLocation() ) )
+			{
+				OutErrorMessage = LOCTEXT("MovePathNodes_TooFar", "Cannot move Path Nodes as they would be Too Far from their adjacent Path Nodes.");
+				return false;
+			}
+		}
+	}
+	return true;
+}
+
+bool UBVPSubsystem::CheckCanRemovePathNodes( const TArray<AFGTargetPoint*>& PathNodes, FText& OutErrorMessage )
+{
+	TSet<const AFGTargetPoint*> RemovedPathNodes;
+	TSet<const AFGDrivingTargetList*> AffectedTargetLists;
+	for ( const AFGTargetPoint* PathNode : PathNodes )
+	{
+		if ( !PathNode || !PathNode->GetOwningList() )
+		{
+			return false;
+		}
+		RemovedPathNodes.Add( PathNode );
+		AffectedTargetLists.Add( PathNode->GetOwningList() );
+	}
+
+	TArray<AFGTargetPoint*> ListPathNodes;
+	for ( const AFGDrivingTargetList* TargetList : AffectedTargetLists )
+	{
+		GetTargetListPathNodes( TargetList, ListPathNodes );
+		ListPathNodes.RemoveAll( [&]( const AFGTargetPoint* PathNode ) { return RemovedPathNodes.Contains( PathNode ); } );
+
+		if ( ListPathNodes.Num() < 2 )
+		{
+			OutErrorMessage = LOCTEXT("RemovePathNodes_TooFew", "Cannot remove Path Nodes as the Path would have less than 2 Path Nodes left.");
+			return false;
+		}
+
+		// Remaining nodes become adjacent to each other, so they need to be close enough
+		for ( int32 i = 0; i < ListPathNodes.Num(); i++ )
+		{
+			if ( !CheckDistanceBetweenTwoPoints( ListPathNodes[i]->GetActorLocation(), ListPathNodes[( i + 1 ) % ListPathNodes.Num()]->GetActorLocation() ) )
+			{
+				OutErrorMessage = LOCTEXT("RemovePathNodes_TooFar", "Cannot remove Path Nodes as the remaining Path Nodes would end up Too Far from each other.");
+				return false;
+			}
+		}
+	}
+	return true;
+}
+
+AFGTargetPoint* UBVPSubsystem::FindPrevTargetPoint( const AFGTargetPoint* TargetPoint )
+{
+	fgcheck( TargetPoint );
+
+	const AFGDrivingTargetList* TargetList = TargetPoint->GetOwningList();
+	fgcheck( TargetList );
+
+	// Previous point of the first target is the last point ;)
+	if ( TargetPoint == TargetList->GetFirstTarget() )
+	{
+		return TargetList->GetLastTarget();
+	}
+
+	// Otherwise walk the linked list
+	AFGTargetPoint* CurrentTargetPoint = TargetList->GetFirstTarget();
+	while ( CurrentTargetPoint != nullptr )
+	{
+		if ( CurrentTargetPoint->GetNext() == TargetPoint )
+		{
+			return CurrentTargetPoint;
+		}
+		CurrentTargetPoint = CurrentTargetPoint->GetNext();
+	}
+	return nullptr;
+}
+
+AFGTargetPoint* UBVPSubsystem::FindNextTargetPoint( const AFGTargetPoint* TargetPoint )
+{
+	fgcheck( TargetPoint );
+
+	const AFGDrivingTargetList* TargetList = TargetPoint->GetOwningList();
+	fgcheck( TargetList );
+
+	// Next point of the last target is the first point ;)
+	if ( TargetPoint == TargetList->GetLastTarget() )
+	{
+		return TargetList->GetFirstTarget();
+	}
+	return TargetPoint->GetNext();
+}
+
+void UBVPSubsystem::GetPathHermiteSegments( const AFGDrivingTargetList* TargetPointList, TArray<FBVPHermiteSegment>& OutSegments )
+{
+	fgcheck( TargetPointList );
+	OutSegments.Reset();
+
+	const USplineComponent* SplineComponent = TargetPointList->GetPath();
+	if ( !SplineComponent )
+	{
+		return;
+	}
+
+	// Segments follow the same spline point mapping as the path visualization, with the last segment looping back to the first node
+	const int32 NumSplinePoints = SplineComponent->GetNumberOfSplinePoints();
+	OutSegments.Reserve( NumSplinePoints - NumBacktrackSplinePoints );
+
+	for ( int32 StartSplinePoint = NumBacktrackSplinePoints; StartSplinePoint < NumSplinePoints; StartSplinePoint++ )
+	{
+		const int32 EndSplinePoint = StartSplinePoint + 1 < NumSplinePoints ? StartSplinePoint + 1 : NumBacktrackSplinePoints;
+
+		OutSegments.Emplace(
+			SplineComponent->GetLocationAtSplinePoint( StartSplinePoint, ESplineCoordinateSpace::World ),
+			SplineComponent->GetLeaveTangentAtSplinePoint( StartSplinePoint, ESplineCoordinateSpace::World ),
+			SplineComponent->GetLocationAtSplinePoint( EndSplinePoint, ESplineCoordinateSpace::World ),
+			SplineComponent->GetArriveTangentAtSplinePoint( EndSplinePoint, ESplineCoordinateSpace::World ) );
+	}
+}
+
+void UBVPSubsystem::GetTargetListPathNodes( const AFGDrivingTargetList* TargetPointList, TArray<AFGTargetPoint*>& OutPathNodes )
+{
+	fgcheck( TargetPointList );
+	OutPathNodes.Reset();
+
+	for ( AFGTargetPoint* CurrentTargetPoint = TargetPointList->GetFirstTarget(); CurrentTargetPoint != nullptr; CurrentTargetPoint = CurrentTargetPoint->GetNext() )
+	{
+		OutPathNodes.Add( CurrentTargetPoint );
+	}
+}
+
+void UBVPSubsystem::RebuildTargetListPath( AFGDrivingTargetList* TargetPointList )
+{
+	fgcheck( TargetPointList );
+
+	if ( TargetPointList->HasAuthority() )
+	{
+		TargetPointList->CalculateTargetCount();
+	}
+	if ( TargetPointList->HasData() && TargetPointList->IsComplete() )
+	{
+		TargetPointList->CreatePath();
+	}
+}
+
+bool UBVPSubsystem::CheckDistanceBetweenTwoPoints( const FVector& LocationA, const FVector& LocationB )
+{
+	const UBVPSettings* BVPSettings = UBVPSettings::Get();
+	return FVector::Distance( LocationA, LocationB ) <= BVPSettings->MaxDistanceBetweenPathNodes;
+}
+
+bool UBVPSubsystem::IsLocationInWorldBounds( const FVector& Location )
+{
+	return !Location.ContainsNaN() && Location.GetAbsMax() <= UE_OLD_HALF_WORLD_MAX;
+}
+
+bool UBVPSubsystem::EstimatePathTravelTime( AFGDrivingTargetList* TargetPointList, FBVPPathTravelTimeEstimate& OutEstimate )
+{
+	OutEstimate = FBVPPathTravelTimeEstimate();
+	if ( !TargetPointList || !TargetPointList->HasData() || !TargetPointList->IsComplete() )
+	{
+		return false;
+	}
+
+	// Only the visualized paths track their geometry generation, the rest are estimated from scratch every time
+	const FBVPVehiclePathVisualization* PathVisualization = FindPathVisualization( TargetPointList );
+	if ( !PathVisualization )
+	{
+		return ComputePathTravelTime( TargetPointList, OutEstimate );
+	}
+
+	// Target speeds can change without changing the geometry of the path
+	uint32 SpeedChecksum = 0;
+	for ( const AFGTargetPoint* PathNode = TargetPointList->GetFirstTarget(); PathNode; PathNode = PathNode->GetNext() )
+	{
+		SpeedChecksum = HashCombine( SpeedChecksum, GetTypeHash( PathNode->GetTargetSpeed() ) );
+	}
+
+	FBVPCachedTravelTimeEstimate& CachedEstimate = TravelTimeEstimateCache.FindOrAdd( TargetPointList );
+	if ( CachedEstimate.GeometryGeneration != PathVisualization->GetGeometryGeneration() || CachedEstimate.SpeedChecksum != SpeedChecksum )
+	{
+		if ( !ComputePathTravelTime( TargetPointList, CachedEstimate.Estimate ) )
+		{
+			TravelTimeEstimateCache.Remove( TargetPointList );
+			return false;
+		}
+		CachedEstimate.GeometryGeneration = PathVisualization->GetGeometryGeneration();
+		CachedEstimate.SpeedChecksum = SpeedChecksum;
+	}
+	OutEstimate = CachedEstimate.Estimate;
+	return true;
+}
+
+bool UBVPSubsystem::EstimatePathThroughput( AFGDrivingTargetList* TargetPointList, int32 NumVehicles, float CargoPerTrip, float StationTime, FBVPPathThroughputEstimate& OutEstimate )
+{
+	OutEstimate = FBVPPathThroughputEstimate();
+
+	FBVPPathTravelTimeEstimate TravelTimeEstimate;
+	if ( !EstimatePathTravelTime( TargetPointList, TravelTimeEstimate ) )
+	{
+		return false;
+	}
+
+	// Each vehicle delivers its cargo once per lap
+	OutEstimate.RoundTripTime = TravelTimeEstimate.LapTime + FMath::Max( StationTime, 0.0f );
+	if ( OutEstimate.RoundTripTime > UE_KINDA_SMALL_NUMBER )
+	{
+		OutEstimate.TripsPerMinute = FMath::Max( NumVehicles, 0 ) * 60.0f / OutEstimate.RoundTripTime;
+		OutEstimate.ItemsPerMinute = OutEstimate.TripsPerMinute * FMath::Max( CargoPerTrip, 0.0f );
+	}
+	return true;
+}
+
+bool UBVPSubsystem::GetPathSegmentMetrics( const AFGTargetPoint* SegmentStartNode, FBVPPathSegmentMetrics& OutMetrics ) const
+{
+	const FBVPVehiclePathVisualization* PathVisualization = SegmentStartNode ? FindPathVisualization( SegmentStartNode->GetOwningList() ) : nullptr;
+	if ( const FBVPVehiclePathSegmentVisualization* SegmentVisualization = PathVisualization ? PathVisualization->FindSegmentByStartPathNode( SegmentStartNode ) : nullptr )
+	{
+		OutMetrics = SegmentVisualization->GetSegmentMetrics();
+		return true;
+	}
+	OutMetrics = FBVPPathSegmentMetrics();
+	return false;
+}
+
+bool UBVPSubsystem::GetAllPathSegmentMetrics( const AFGDrivingTargetList* TargetPointList, TArray<FBVPPathSegmentMetrics>& OutMetrics ) const
+{
+	OutMetrics.Reset();
+	if ( const FBVPVehiclePathVisualization* PathVisualization = FindPathVisualization( TargetPointList ) )
+	{
+		OutMetrics.Reserve( PathVisualization->GetVisualizationSegments().Num() );
+		for ( const FBVPVehiclePathSegmentVisualization* SegmentVisualization : PathVisualization->GetVisualizationSegments() )
+		{
+			OutMetrics.Add( SegmentVisualization->GetSegmentMetrics() );
+		}
+		return !OutMetrics.IsEmpty();
+	}
+	return false;
+}
+
+bool UBVPSubsystem::GetPathSegmentTravelTime( AFGTargetPoint* SegmentStartNode, float& OutTravelTime, float& OutSegmentLength, float& OutLapTime )
+{
+	OutTravelTime = 0.0f;
+	OutSegmentLength = 0.0f;
+	OutLapTime = 0.0f;
+
+	FBVPPathTravelTimeEstimate TravelTimeEstimate;
+	if ( !SegmentStartNode || !EstimatePathTravelTime( SegmentStartNode->GetOwningList(), TravelTimeEstimate ) )
+	{
+		return false;
+	}
+
+	// Estimates are only cached for the visualized paths, so their segments are always available here
+	const FBVPVehiclePathVisualization* PathVisualization = FindPathVisualization( SegmentStartNode->GetOwningList() );
+	const FBVPVehiclePathSegmentVisualization* SegmentVisualization = PathVisualization ? PathVisualization->FindSegmentByStartPathNode( SegmentStartNode ) : nullptr;
+	if ( !SegmentVisualization || !TravelTimeEstimate.SegmentTravelTimes.IsValidIndex( SegmentVisualization->GetSegmentIndex() ) )
+	{
+		return false;
+	}
+	OutTravelTime = TravelTimeEstimate.SegmentTravelTimes[SegmentVisualization->GetSegmentIndex()];
+	OutSegmentLength = SegmentVisualization->GetSegmentMetrics().ArcLength;
+	OutLapTime = TravelTimeEstimate.LapTime;
+	return true;
+}
+
+void UBVPSubsystem::GetAllPathProblems( TArray<FBVPPathProblem>& OutProblems ) const
+{
+	OutProblems.Reset();
+	for ( const FBVPVehiclePathVisualization* PathVisualization : VisualizedPaths )
+	{
+		OutProblems.Append( PathVisualization->GetPathProblems() );
+	}
+}
+
+void UBVPSubsystem::GetPathProblems( const AFGDrivingTargetList* TargetPointList, TArray<FBVPPathProblem>& OutProblems ) const
+{
+	OutProblems.Reset();
+	if ( const FBVPVehiclePathVisualization* PathVisualization = FindPathVisualization( TargetPointList ) )
+	{
+		OutProblems.Append( PathVisualization->GetPathProblems() );
+	}
+}
+
+void UBVPSubsystem::GetAllPathConflicts( TArray<FBVPPathConflict>& OutConflicts ) const
+{
+	OutConflicts.Reset();
+	PathConflictDetector.GetConflicts( OutConflicts );
+}
+
+void UBVPSubsystem::GetPathConflicts( const AFGDrivingTargetList* TargetPointList, TArray<FBVPPathConflict>& OutConflicts ) const
+{
+	OutConflicts.Reset();
+	PathConflictDetector.GetPathConflicts( TargetPointList, OutConflicts );
+}
+
+bool UBVPSubsystem::SnapPathNodesToGround( AFGPlayerController* PlayerController, const TArray<AFGTargetPoint*>& PathNodes, bool bAlignToSurface, FText& OutErrorMessage )
+{
+	if ( PathNodes.IsEmpty() || PathNodes.Contains( nullptr ) )
+	{
+		OutErrorMessage = LOCTEXT("GroundSnapInvalidNodes", "No valid path nodes to snap to the ground");
+		return false;
+	}
+	const UBVPSettings* BVPSettings = UBVPSettings::Get();
+
+	const int32 GroundSnapId = NextGroundSnapId++;
+	FBVPPendingGroundSnap& GroundSnap = PendingGroundSnaps.Add( GroundSnapId );
+	GroundSnap.PlayerController = PlayerController;
+	GroundSnap.PathNodes.Append( PathNodes );
+	GroundSnap.GroundHits.SetNum( PathNodes.Num() );
+	GroundSnap.NumPendingTraces = PathNodes.Num();
+	GroundSnap.bAlignToSurface = bAlignToSurface;
+
+	// Path nodes should never be snapped onto each other
+	FCollisionQueryParams CollisionQueryParams( SCENE_QUERY_STAT( BVPGroundSnap ), false );
+	for ( const AFGTargetPoint* PathNode : PathNodes )
+	{
+		CollisionQueryParams.AddIgnoredActor( PathNode );
+	}
+
+	FCollisionObjectQueryParams ObjectQueryParams{};
+	ObjectQueryParams.AddObjectTypesToQuery( ECC_WorldStatic );
+
+	// All traces are issued at once, and the results are collected by the delegate over the next frames. Index of the node is passed as the user data.
+	// Traces collect every surface along the way, as the first one from above may be a bridge or a roof over the ground the node is actually on
+	const FTraceDelegate TraceDelegate = FTraceDelegate::CreateUObject( this, &UBVPSubsystem::OnGroundSnapTraceCompleted, GroundSnapId );
+	for ( int32 NodeIndex = 0; NodeIndex < PathNodes.Num(); NodeIndex++ )
+	{
+		const FVector NodeLocation = PathNodes[NodeIndex]->GetActorLocation();
+		const FVector TraceStart = NodeLocation + FVector::UpVector * BVPSettings->GroundSnapTraceHeight;
+		const FVector TraceEnd = NodeLocation - FVector::UpVector * BVPSettings->GroundSnapTraceDepth;
+
+		GetWorld()->AsyncLineTraceByObjectType( EAsyncTraceType::Multi, TraceStart, TraceEnd, ObjectQueryParams, CollisionQueryParams, &TraceDelegate, NodeIndex );
+	}
+	return true;
+}
+
+bool UBVPSubsystem::SnapPathToGround( AFGPlayerController* PlayerController, AFGDrivingTargetList* TargetPointList, bool bAlignToSurface, FText& OutErrorMessage )
+{
+	if ( !TargetPointList )
+	{
+		OutErrorMessage = LOCTEXT("GroundSnapInvalidPath", "No valid path to snap to the ground");
+		return false;
+	}
+	TArray<AFGTargetPoint*> PathNodes;
+	GetTargetListPathNodes( TargetPointList, PathNodes );
+	return SnapPathNodesToGround( PlayerController, PathNodes, bAlignToSurface, OutErrorMessage );
+}
+
+void UBVPSubsystem::OnGroundSnapTraceCompleted( const FTraceHandle& TraceHandle, FTraceDatum& TraceDatum, int32 GroundSnapId )
+{
+	FBVPPendingGroundSnap* GroundSnap = PendingGroundSnaps.Find( GroundSnapId );
+	if ( !GroundSnap )
+	{
+		return;
+	}
+
+	// Snap to the surface closest to the current height of the node, so that nodes under a bridge stay under it
+	const int32 NodeIndex = (int32) TraceDatum.UserData;
+	const AFGTargetPoint* PathNode = GroundSnap->PathNodes.IsValidIndex( NodeIndex ) ? GroundSnap->PathNodes[NodeIndex].Get() : nullptr;
+	if ( PathNode && GroundSnap->GroundHits.IsValidIndex( NodeIndex ) )
+	{
+		const double NodeHeight = PathNode->GetActorLocation().Z;
+		const FHitResult* ClosestHit = nullptr;
+		for ( const FHitResult& HitResult : TraceDatum.OutHits )
+		{
+			if ( !ClosestHit || FMath::Abs( HitResult.ImpactPoint.Z - NodeHeight ) < FMath::Abs( ClosestHit->ImpactPoint.Z - NodeHeight ) )
+			{
+				ClosestHit = &HitResult;
+			}
+		}
+		if ( ClosestHit )
+		{
+			GroundSnap->GroundHits[NodeIndex] = *ClosestHit;
+		}
+	}
+
+	if ( --GroundSnap->NumPendingTraces == 0 )
+	{
+		FinishGroundSnap( GroundSnapId );
+	}
+}
+
+void UBVPSubsystem::FinishGroundSnap( int32 GroundSnapId )
+{
+	FBVPPendingGroundSnap GroundSnap;
+	if ( !PendingGroundSnaps.RemoveAndCopyValue( GroundSnapId, GroundSnap ) )
+	{
+		return;
+	}
+
+	TArray<AFGTargetPoint*> SnappedPathNodes;
+	TArray<FTransform> NewTransforms;
+
+	for ( int32 NodeIndex = 0; NodeIndex < GroundSnap.PathNodes.Num(); NodeIndex++ )
+	{
+		AFGTargetPoint* PathNode = GroundSnap.PathNodes[NodeIndex].Get();
+		const TOptional<FHitResult>& GroundHit = GroundSnap.GroundHits[NodeIndex];
+		if ( !PathNode || !GroundHit.IsSet() )
+		{
+			continue;
+		}
+
+		// Aligned nodes keep their heading, but have their up vector follow the surface normal
+		FQuat NewRotation = PathNode->GetActorQuat();
+		if ( GroundSnap.bAlignToSurface )
+		{
+			NewRotation = FRotationMatrix::MakeFromZX( GroundHit->ImpactNormal, PathNode->GetActorForwardVector() ).ToQuat();
+		}
+		SnappedPathNodes.Add( PathNode );
+		NewTransforms.Emplace( NewRotation, GroundHit->ImpactPoint );
+	}
+
+	FText ErrorMessage;
+	bool bSuccess = false;
+	if ( SnappedPathNodes.IsEmpty() )
+	{
+		ErrorMessage = LOCTEXT("GroundSnapNoGround", "Could not find any ground below the path nodes");
+	}
+	else
+	{
+		bSuccess = ApplyPathNodeTransformsInternal( GroundSnap.PlayerController.Get(), SnappedPathNodes, NewTransforms, false, ErrorMessage );
+	}
+	OnGroundSnapCompleted.Broadcast( GroundSnap.PlayerController.Get(), bSuccess, bSuccess ? SnappedPathNodes.Num() : 0, ErrorMessage );
+}
+
+bool UBVPSubsystem::ValidatePath( AFGDrivingTargetList* TargetPointList, TArray<FBVPPathViolation>& OutViolations ) const
+{
+	OutViolations.Reset();
+	return !TargetPointList || FBVPPathValidator::ValidatePath( TargetPointList, FBVPPathValidationLimits::FromSettings(), OutViolations );
+}
+
+bool UBVPSubsystem::ValidateAllPaths( TArray<FBVPPathViolation>& OutViolations ) const
+{
+	OutViolations.Reset();
+
+	TArray<AFGDrivingTargetList*> AllTargetLists;
+	GetAllTargetLists( AllTargetLists );
+
+	const FBVPPathValidationLimits Limits = FBVPPathValidationLimits::FromSettings();
+	bool bAllPathsValid = true;
+	for ( AFGDrivingTargetList* TargetList : AllTargetLists )
+	{
+		bAllPathsValid &= FBVPPathValidator::ValidatePath( TargetList, Limits, OutViolations );
+	}
+	return bAllPathsValid;
+}
+
+void UBVPSubsystem::GetAllTargetLists( TArray<AFGDrivingTargetList*>& OutTargetLists ) const
+{
+	const AFGVehicleSubsystem* VehicleSubsystem = AFGVehicleSubsystem::Get( GetWorld() );
+	if ( !VehicleSubsystem )
+	{
+		return;
+	}
+
+	// Clients do not populate mTargetLists, so we need to use TActorIterator instead.
+	if ( !GetWorld()->IsNetMode( NM_Client ) )
+	{
+		OutTargetLists.Append( VehicleSubsystem->mTargetLists );
+	}
+	else
+	{
+		for ( TActorIterator<AFGDrivingTargetList> It( GetWorld() ); It; ++It )
+		{
+			AFGDrivingTargetList* DrivingTargetList = *It;
+			if ( DrivingTargetList && !DrivingTargetList->IsTemporary() && DrivingTargetList->HasData() )
+			{
+				OutTargetLists.Add( DrivingTargetList );
+			}
+		}
+	}
+}
+
+void UBVPSubsystem::ValidateEditedPaths( const TSet<AFGDrivingTargetList*>& TargetLists ) const
+{
+	if ( GetWorld()->IsNetMode( NM_Client ) )
+	{
+		return;
+	}
+
+	TArray<FBVPPathViolation> Violations;
+	const FBVPPathValidationLimits Limits = FBVPPathValidationLimits::FromSettings();
+	for ( AFGDrivingTargetList* TargetList : TargetLists )
+	{
+		FBVPPathValidator::ValidatePath( TargetList, Limits, Violations );
+	}
+	LogPathViolations( Violations );
+}
+
+void UBVPSubsystem::LogPathViolations( const TArray<FBVPPathViolation>& Violations )
+{
+	// Warnings do not break the path, so they are only logged at the regular verbosity
+	for ( const FBVPPathViolation& Violation : Violations )
+	{
+		if ( Violation.Severity == EBVPPathViolationSeverity::Warning )
+		{
+			UE_LOG( LogBetterVehiclePaths, Log, TEXT("Path %s does not follow %s at path node %s (other path node: %s, value: %.2f)"), *GetNameSafe( Violation.TargetList.Get() ),
+				*UEnum::GetValueAsString( Violation.ViolationType ), *GetNameSafe( Violation.PathNode.Get() ), *GetNameSafe( Violation.OtherPathNode.Get() ), Violation.Value );
+			continue;
+		}
+		UE_LOG( LogBetterVehiclePaths, Warning, TEXT("Path %s violates %s at path node %s (other path node: %s, value: %.2f)"), *GetNameSafe( Violation.TargetList.Get() ),
+			*UEnum::GetValueAsString( Violation.ViolationType ), *GetNameSafe( Violation.PathNode.Get() ), *GetNameSafe( Violation.OtherPathNode.Get() ), Violation.Value );
+	}
+}
+
+bool UBVPSubsystem::ExportPaths( const TArray<AFGDrivingTargetList*>& TargetPointLists, TArray<uint8>& OutData ) const
+{
+	TArray<FBVPExportedPath> Paths;
+	for ( const AFGDrivingTargetList* TargetList : TargetPointLists )
+	{
+		if ( TargetList && TargetList->HasData() )
+		{
+			FBVPPathArchive::ExportPath( TargetList, Paths.AddDefaulted_GetRef() );
+		}
+	}
+	if ( Paths.IsEmpty() )
+	{
+		OutData.Reset();
+		return false;
+	}
+
+	FBVPPathArchive::Encode( Paths, OutData );
+	return true;
+}
+
+bool UBVPSubsystem::ExportPathsToString( const TArray<AFGDrivingTargetList*>& TargetPointLists, FString& OutString ) const
+{
+	TArray<uint8> Data;
+	if ( !ExportPaths( TargetPointLists, Data ) )
+	{
+		OutString.Reset();
+		return false;
+	}
+	OutString = FBase64::Encode( Data );
+	return true;
+}
+
+bool UBVPSubsystem::ExportPathsToFile( const TArray<AFGDrivingTargetList*>& TargetPointLists, const FString& FilePath, FText& OutErrorMessage ) const
+{
+	TArray<uint8> Data;
+	if ( !ExportPaths( TargetPointLists, Data ) )
+	{
+		OutErrorMessage = LOCTEXT("ExportPaths_NoPaths", "Cannot export the Paths as none of them have any Path Nodes.");
+		return false;
+	}
+	if ( !FFileHelper::SaveArrayToFile( Data, *FilePath ) )
+	{
+		OutErrorMessage = FText::Format( LOCTEXT("ExportPaths_WriteFailed", "Cannot write the exported Paths to the file {0}."), FText::FromString( FilePath ) );
+		return false;
+	}
+	return true;
+}
+
+bool UBVPSubsystem::ImportPaths( AFGPlayerController* PlayerController, const TArray<uint8>& Data, FText& OutErrorMessage )
+{
+	const int32 MaxPathImportDataSize = UBVPSettings::Get()->MaxPathImportDataSize;
+	if ( Data.Num() > MaxPathImportDataSize )
+	{
+		OutErrorMessage = FText::Format( LOCTEXT("ImportPaths_TooLarge", "Cannot import the Paths as the data is larger than {0} bytes."), MaxPathImportDataSize );
+		return false;
+	}
+
+	TArray<FBVPExportedPath> Paths;
+	if ( !FBVPPathArchive::Decode( Data, Paths ) )
+	{
+		OutErrorMessage = LOCTEXT("ImportPaths_Malformed", "Cannot import the Paths as the data is malformed or has been exported by a newer version.");
+		return false;
+	}
+	if ( !CheckCanImportPaths( Paths, OutErrorMessage ) )
+	{
+		return false;
+	}
+
+	// Send the encoded data instead of the decoded paths, since it is a lot smaller
+	if ( PlayerController && GetWorld()->IsNetMode( NM_Client ) )
+	{
+		if ( UBVPRemoteCallObject* RemoteCallObject = PlayerController->GetRemoteCallObjectOfClass<UBVPRemoteCallObject>() )
+		{
+			RemoteCallObject->Server_ImportPaths( Data );
+			return true;
+		}
+		return false;
+	}
+
+	// Only the server knows how many imports are still pending
+	if ( !CheckCanQueuePathImports( PlayerController, Paths.Num(), OutErrorMessage ) )
+	{
+		return false;
+	}
+	ImportPathsInternal( PlayerController, MoveTemp( Paths ) );
+	return true;
+}
+
+bool UBVPSubsystem::ImportPathsFromString( AFGPlayerController* PlayerController, const FString& String, FText& OutErrorMessage )
+{
+	TArray<uint8> Data;
+	if ( !FBase64::Decode( String.TrimStartAndEnd(), Data ) )
+	{
+		OutErrorMessage = LOCTEXT("ImportPaths_NotBase64", "Cannot import the Paths as the text is not a valid exported Path.");
+		return false;
+	}
+	return ImportPaths( PlayerController, Data, OutErrorMessage );
+}
+
+bool UBVPSubsystem::ImportPathsFromFile( AFGPlayerController* PlayerController, const FString& FilePath, FText& OutErrorMessage )
+{
+	TArray<uint8> Data;
+	if ( !FFileHelper::LoadFileToArray( Data, *FilePath ) )
+	{
+		OutErrorMessage = FText::Format( LOCTEXT("ImportPaths_ReadFailed", "Cannot read the Paths from the file {0}."), FText::FromString( FilePath ) );
+		return false;
+	}
+	return ImportPaths( PlayerController, Data, OutErrorMessage );
+}
+
+bool UBVPSubsystem::CheckCanImportPaths( const TArray<FBVPExportedPath>& Paths, FText& OutErrorMessage )
+{
+	if ( Paths.IsEmpty() )
+	{
+		OutErrorMessage = LOCTEXT("ImportPaths_Empty", "Cannot import the Paths as there are no Paths in the data.");
+		return false;
+	}
+
+	int32 TotalNumPathNodes = 0;
+	for ( const FBVPExportedPath& Path : Paths )
+	{
+		const int32 NumPathNodes = Path.PathNodes.Num();
+		if ( NumPathNodes < 2 )
+		{
+			OutErrorMessage = LOCTEXT("ImportPaths_TooShort", "Cannot import the Paths as one of them has less than 2 Path Nodes.");
+			return false;
+		}
+		TotalNumPathNodes += NumPathNodes;
+
+		// Data may come from a client, so the nodes can be anywhere
+		for ( const FBVPExportedPathNode& PathNode : Path.PathNodes )
+		{
+			if ( !IsLocationInWorldBounds( PathNode.Location ) || PathNode.Rotation.ContainsNaN() )
+			{
+				OutErrorMessage = LOCTEXT("ImportPaths_OutOfWorld", "Cannot import the Paths as some of their Path Nodes are outside of the world.");
+				return false;
+			}
+		}
+
+		// The path is a loop, so the last node has to be close enough to the first one as well
+		for ( int32 NodeIndex = 0; NodeIndex < NumPathNodes; NodeIndex++ )
+		{
+			if ( !CheckDistanceBetweenTwoPoints( Path.PathNodes[NodeIndex].Location, Path.PathNodes[( NodeIndex + 1 ) % NumPathNodes].Location ) )
+			{
+				OutErrorMessage = LOCTEXT("ImportPaths_TooFar", "Cannot import the Paths as some of their Path Nodes are Too Far from each other.");
+				return false;
+			}
+		}
+	}
+
+	if ( TotalNumPathNodes > UBVPSettings::Get()->MaxImportedPathNodes )
+	{
+		OutErrorMessage = FText::Format( LOCTEXT("ImportPaths_TooManyNodes", "Cannot import the Paths as they have more than {0} Path Nodes in total."), UBVPSettings::Get()->MaxImportedPathNodes );
+		return false;
+	}
+	return true;
+}
+
+bool UBVPSubsystem::CheckCanQueuePathImports( AFGPlayerController* PlayerController, int32 NumPaths, FText& OutErrorMessage ) const
+{
+	const UBVPSettings* BVPSettings = UBVPSettings::Get();
+	if ( PendingPathImports.Num() + NumPaths > BVPSettings->MaxPendingPathImports )
+	{
+		OutErrorMessage = LOCTEXT("ImportPaths_ServerBusy", "Cannot import the Paths as too many other Paths are still being imported. Try again later.");
+		return false;
+	}
+
+	if ( PlayerController )
+	{
+		int32 NumPlayerPendingImports = 0;
+		for ( const FBVPPendingPathImport& PendingImport : PendingPathImports )
+		{
+			if ( PendingImport.PlayerController == PlayerController )
+			{
+				NumPlayerPendingImports++;
+			}
+		}
+		if ( NumPlayerPendingImports + NumPaths > BVPSettings->MaxPendingPathImportsPerPlayer )
+		{
+			OutErrorMessage = FText::Format( LOCTEXT("ImportPaths_PlayerBusy", "Cannot import the Paths as you already have Paths being imported, and at most {0} can be imported at once."), BVPSettings->MaxPendingPathImportsPerPlayer );
+			return false;
+		}
+	}
+	return true;
+}
+
+void UBVPSubsystem::ImportPathsInternal( AFGPlayerController* PlayerController, TArray<FBVPExportedPath>&& Paths )
+{
+	const int32 MaxTargetSpeed = UBVPSettings::Get()->MaxTargetSpeed;
+
+	for ( FBVPExportedPath& Path : Paths )
+	{
+		for ( FBVPExportedPathNode& PathNode : Path.PathNodes )
+		{
+			PathNode.TargetSpeed = FMath::Clamp( PathNode.TargetSpeed, 0, MaxTargetSpeed );
+		}
+		FBVPPendingPathImport& PendingImport = PendingPathImports.AddDefaulted_GetRef();
+		PendingImport.PlayerController = PlayerController;
+		PendingImport.Path = MoveTemp( Path );
+	}
+}
+
+bool UBVPSubsystem::UndoPathEdit( AFGPlayerController* PlayerController, FText& OutErrorMessage )
+{
+	if ( !PlayerController )
+	{
+		return false;
+	}
+	if ( GetWorld()->IsNetMode( NM_Client ) )
+	{
+		if ( UBVPRemoteCallObject* RemoteCallObject = PlayerController->GetRemoteCallObjectOfClass<UBVPRemoteCallObject>() )
+		{
+			RemoteCallObject->Server_UndoPathEdit();
+			return true;
+		}
+		return false;
+	}
+
+	FBVPPathEditHistory* EditHistory = PathEditHistories.Find( PlayerController );
+	const FBVPPathEditRecord* Edit = EditHistory ? EditHistory->PeekUndo() : nullptr;
+	if ( !Edit )
+	{
+		OutErrorMessage = LOCTEXT("UndoPathEdit_Empty", "There is nothing to Undo.");
+		return false;
+	}
+
+	// Edits that can never be applied again are skipped, so that they do not block the rest of the history
+	bool bEditExpired = false;
+	const bool bEditApplied = ApplyPathEditInternal( *EditHistory, *Edit, true, bEditExpired, OutErrorMessage );
+	if ( bEditApplied || bEditExpired )
+	{
+		EditHistory->CommitUndo();
+	}
+	return bEditApplied;
+}
+
+bool UBVPSubsystem::RedoPathEdit( AFGPlayerController* PlayerController, FText& OutErrorMessage )
+{
+	if ( !PlayerController )
+	{
+		return false;
+	}
+	if ( GetWorld()->IsNetMode( NM_Client ) )
+	{
+		if ( UBVPRemoteCallObject* RemoteCallObject = PlayerController->GetRemoteCallObjectOfClass<UBVPRemoteCallObject>() )
+		{
+			RemoteCallObject->Server_RedoPathEdit();
+			return true;
+		}
+		return false;
+	}
+
+	FBVPPathEditHistory* EditHistory = PathEditHistories.Find( PlayerController );
+	const FBVPPathEditRecord* Edit = EditHistory ? EditHistory->PeekRedo() : nullptr;
+	if ( !Edit )
+	{
+		OutErrorMessage = LOCTEXT("RedoPathEdit_Empty", "There is nothing to Redo.");
+		return false;
+	}
+
+	bool bEditExpired = false;
+	const bool bEditApplied = ApplyPathEditInternal( *EditHistory, *Edit, false, bEditExpired, OutErrorMessage );
+	if ( bEditApplied || bEditExpired )
+	{
+		EditHistory->CommitRedo();
+	}
+	return bEditApplied;
+}
+
+FBVPPathEditHistory* UBVPSubsystem::FindPathEditHistoryForRecording( AFGPlayerController* PlayerController )
+{
+	if ( !PlayerController || GetWorld()->IsNetMode( NM_Client ) )
+	{
+		return nullptr;
+	}
+	if ( FBVPPathEditHistory* ExistingEditHistory = PathEditHistories.Find( PlayerController ) )
+	{
+		return ExistingEditHistory;
+	}
+
+	// Drop the histories of the players that have left before adding a new one
+	for ( auto It = PathEditHistories.CreateIterator(); It; ++It )
+	{
+		if ( !It.Key().IsValid() )
+		{
+			It.RemoveCurrent();
+		}
+	}
+	return &PathEditHistories.Add( PlayerController, FBVPPathEditHistory( UBVPSettings::Get()->MaxPathEditHistoryBytes ) );
+}
+
+bool UBVPSubsystem::ApplyPathEditInternal( FBVPPathEditHistory& EditHistory, const FBVPPathEditRecord& Edit, bool bUndo, bool& bOutEditExpired, FText& OutErrorMessage )
+{
+	bOutEditExpired = false;
+
+	const FVector Location = Edit.GetLocation( bUndo );
+	const FRotator Rotation = Edit.GetRotation( bUndo );
+	const int32 TargetSpeed = Edit.GetTargetSpeed( bUndo );
+
+	// Undoing a removal creates the node again, and undoing a creation removes it
+	const bool bCreatePathNode = Edit.EditType == ( bUndo ? EBVPPathEditType::Remove : EBVPPathEditType::Create );
+	const bool bRemovePathNode = Edit.EditType == ( bUndo ? EBVPPathEditType::Create : EBVPPathEditType::Remove );
+
+	if ( bCreatePathNode )
+	{
+		AFGTargetPoint* PrevPathNode = EditHistory.ResolveHandle( Edit.PrevPathNodeHandle );
+		const AFGTargetPoint* NextPathNode = PrevPathNode ? FindNextTargetPoint( PrevPathNode ) : nullptr;
+		if ( !NextPathNode )
+		{
+			bOutEditExpired = true;
+			OutErrorMessage = LOCTEXT("PathEdit_Expired", "Cannot apply the edit as its Path Nodes no longer exist.");
+			return false;
+		}
+		if ( !CheckDistanceBetweenTwoPoints( Location, PrevPathNode->GetActorLocation() ) || !CheckDistanceBetweenTwoPoints( Location, NextPathNode->GetActorLocation() ) )
+		{
+			OutErrorMessage = LOCTEXT("PathEdit_CreateTooFar", "Cannot restore the Path Node as it would be Too Far from it's adjacent Path Nodes.");
+			return false;
+		}
+
+		AFGTargetPoint* NewPathNode = SpawnPathNodeInternal( PrevPathNode, FTransform( Rotation, Location ), TargetSpeed );
+		RebuildTargetListPath( PrevPathNode->GetOwningList() );
+		EditHistory.RebindHandle( Edit.PathNodeHandle, NewPathNode );
+		return true;
+	}
+
+	AFGTargetPoint* PathNode = EditHistory.ResolveHandle( Edit.PathNodeHandle );
+	if ( !PathNode || !PathNode->GetOwningList() )
+	{
+		bOutEditExpired = true;
+		OutErrorMessage = LOCTEXT("PathEdit_Expired", "Cannot apply the edit as its Path Nodes no longer exist.");
+		return false;
+	}
+
+	if ( bRemovePathNode )
+	{
+		if ( !CheckCanRemovePathNode( PathNode, OutErrorMessage ) )
+		{
+			return false;
+		}
+		RemovePathNodesInternal( { PathNode } );
+		return true;
+	}
+	if ( Edit.EditType == EBVPPathEditType::Move )
+	{
+		if ( !CheckCanMovePathNode( PathNode, Location, Rotation, OutErrorMessage ) )
+		{
+			return false;
+		}
+		SetPathNodeTransformsInternal( { PathNode }, { FTransform( Rotation, Location ) } );
+		return true;
+	}
+
+	// Target speed is not a part of the path spline, so there is nothing to rebuild
+	PathNode->SetTargetSpeed( FMath::Clamp( TargetSpeed, 0, UBVPSettings::Get()->MaxTargetSpeed ) );
+	return true;
+}
+
+bool UBVPSubsystem::StartEditStressTest( AFGPlayerController* PlayerController, int32 EditRateMultiplier, float EditsPerSecond, float Duration, int32 RandomSeed )
+{
+	// Edits have to go through the real RPCs and the net driver, so the test is driven by the clients
+	if ( !PlayerController || !GetWorld()->IsNetMode( NM_Client ) || IsEditStressTestRunning() )
+	{
+		return false;
+	}
+	UBVPRemoteCallObject* RemoteCallObject = PlayerController->GetRemoteCallObjectOfClass<UBVPRemoteCallObject>();
+	if ( !RemoteCallObject || !PlayerController->GetNetConnection() )
+	{
+		return false;
+	}
+
+	EditStressTest = FBVPEditStressTest();
+	EditStressTest.PlayerController = PlayerController;
+	EditStressTest.RandomStream.Initialize( RandomSeed );
+	EditStressTest.EditRateMultiplier = FMath::Max( EditRateMultiplier, 1 );
+	EditStressTest.EditsPerSecond = FMath::Max( EditsPerSecond, 0.0f );
+	EditStressTest.EndTime = GetWorld()->GetRealTimeSeconds() + FMath::Max( Duration, 0.0f );
+	EditStressTest.bRunning = true;
+
+	// Sent on the same reliable channel as the edits, so the server starts counting before the first edit arrives
+	RemoteCallObject->Server_BeginEditStressTest();
+
+	UE_LOG( LogBetterVehiclePaths, Display, TEXT("Edit stress test started: %.1f edits per second multiplied by %d, %.1f seconds"),
+		EditStressTest.EditsPerSecond, EditStressTest.EditRateMultiplier, Duration );
+	return true;
+}
+
+void UBVPSubsystem::StopEditStressTest()
+{
+	if ( !EditStressTest.bRunning )
+	{
+		return;
+	}
+	EditStressTest.bRunning = false;
+	EditStressTest.bSettling = true;
+
+	// Give the reliable edits still in flight time to be acknowledged, and their results to replicate back, before comparing the paths
+	constexpr float EditStressTestSettleTime = 2.0f;
+	EditStressTest.SettleEndTime = GetWorld()->GetRealTimeSeconds() + EditStressTestSettleTime;
+}
+
+void UBVPSubsystem::FinishEditStressTest()
+{
+	EditStressTest.bSettling = false;
+
+	const double NumSamples = FMath::Max( EditStressTest.NumSamples, 1 );
+	UE_LOG( LogBetterVehiclePaths, Display, TEXT("Edit stress test finished: %d edits sent at %dx the edit rate, %d rejected before being sent. ")
+		TEXT("Bandwidth %.1f KB/s in and %.1f KB/s out on average, %.1f KB/s out at peak. Unacknowledged reliable bunches %.1f on average, %d at peak"),
+		EditStressTest.NumEditsSent, EditStressTest.EditRateMultiplier, EditStressTest.NumEditsRejectedLocally,
+		EditStressTest.TotalInBytesPerSecond / NumSamples / 1024.0, EditStressTest.TotalOutBytesPerSecond / NumSamples / 1024.0, EditStressTest.MaxOutBytesPerSecond / 1024.0,
+		EditStressTest.TotalNumOutReliableBunches / NumSamples, EditStressTest.MaxNumOutReliableBunches );
+
+	// Server compares the paths with its own state, and logs the ones that have diverged
+	AFGPlayerController* PlayerController = EditStressTest.PlayerController.Get();
+	UBVPRemoteCallObject* RemoteCallObject = PlayerController ? PlayerController->GetRemoteCallObjectOfClass<UBVPRemoteCallObject>() : nullptr;
+	if ( RemoteCallObject )
+	{
+		TArray<AFGDrivingTargetList*> TargetLists;
+		GetAllTargetLists( TargetLists );
+		TargetLists.RemoveAll( []( const AFGDrivingTargetList* TargetList ) { return !TargetList || !TargetList->GetFirstTarget(); } );
+
+		for ( AFGDrivingTargetList* TargetList : TargetLists )
+		{
+			FBVPEditStressTestPathReport Report;
+			BuildEditStressTestPathReport( TargetList, Report );
+			RemoteCallObject->Server_ReportEditStressTestPath( Report );
+		}
+		RemoteCallObject->Server_ReportEditStressTest( EditStressTest.NumEditsSent );
+	}
+}
+
+void UBVPSubsystem::BuildEditStressTestPathReport( AFGDrivingTargetList* TargetPointList, FBVPEditStressTestPathReport& OutReport )
+{
+	TArray<AFGTargetPoint*> PathNodes;
+	GetTargetListPathNodes( TargetPointList, PathNodes );
+
+	OutReport.TargetList = TargetPointList;
+	OutReport.Locations.Reset( PathNodes.Num() );
+	OutReport.TargetSpeeds.Reset( PathNodes.Num() );
+	for ( const AFGTargetPoint* PathNode : PathNodes )
+	{
+		OutReport.Locations.Add( FVector_NetQuantize( PathNode->GetActorLocation() ) );
+		OutReport.TargetSpeeds.Add( PathNode->GetTargetSpeed() );
+	}
+}
+
+bool UBVPSubsystem::DoesPathMatchEditStressTestReport( const AFGDrivingTargetList* TargetPointList, const FBVPEditStressTestPathReport& Report )
+{
+	TArray<AFGTargetPoint*> PathNodes;
+	GetTargetListPathNodes( TargetPointList, PathNodes );
+	if ( PathNodes.Num() != Report.Locations.Num() || PathNodes.Num() != Report.TargetSpeeds.Num() )
+	{
+		return false;
+	}
+
+	// Locations are compared with a tolerance rather than rounded, as rounding puts the locations near the middle between two whole units on either side of it
+	for ( int32 i = 0; i < PathNodes.Num(); i++ )
+	{
+		if ( !PathNodes[i]->GetActorLocation().Equals( Report.Locations[i], EditStressTestLocationTolerance ) || PathNodes[i]->GetTargetSpeed() != Report.TargetSpeeds[i] )
+		{
+			return false;
+		}
+	}
+	return true;
+}
+
+void UBVPSubsystem::BeginServerEditStressTest( AFGPlayerController* PlayerController )
+{
+	if ( ServerEditStressTest.ActiveClients.IsEmpty() )
+	{
+		ServerEditStressTest = FBVPServerEditStressTest();
+		ServerEditStressTest.StartNumServerEdits = NumServerEdits;
+		ServerEditStressTest.StartNumRejectedServerEdits = NumRejectedServerEdits;
+		ServerEditStressTest.LastFrameTimestamp = FPlatformTime::Seconds();
+	}
+	ServerEditStressTest.ActiveClients.Add( PlayerController, FBVPServerEditStressTestClient() );
+
+	UE_LOG( LogBetterVehiclePaths, Display, TEXT("Edit stress test started by %s, %d clients taking part"), *GetNameSafe( PlayerController ), ServerEditStressTest.ActiveClients.Num() );
+}
+
+void UBVPSubsystem::ReportServerEditStressTestPath( AFGPlayerController* PlayerController, const FBVPEditStressTestPathReport& Report )
+{
+	// Reports are only accepted from clients taking part in the test, and each server path is compared and logged at most once per client,
+	// so the work and the log output of a report are bounded by the paths of the server no matter what the client sends
+	FBVPServerEditStressTestClient* Client = ServerEditStressTest.ActiveClients.Find( PlayerController );
+	if ( !Client )
+	{
+		return;
+	}
+	// Lists the client knows about but the server does not arrive as null
+	const AFGDrivingTargetList* TargetList = Report.TargetList;
+	if ( !TargetList )
+	{
+		Client->NumUnknownPaths++;
+		return;
+	}
+	bool bAlreadyReported = false;
+	Client->ReportedTargetLists.Add( TargetList, &bAlreadyReported );
+	if ( bAlreadyReported )
+	{
+		return;
+	}
+
+	if ( !DoesPathMatchEditStressTestReport( TargetList, Report ) )
+	{
+		UE_LOG( LogBetterVehiclePaths, Warning, TEXT("Path %s on %s does not match the server"), *TargetList->GetName(), *GetNameSafe( PlayerController ) );
+		Client->NumPathMismatches++;
+	}
+}
+
+void UBVPSubsystem::ReportServerEditStressTest( AFGPlayerController* PlayerController, int32 NumEditsSent )
+{
+	FBVPServerEditStressTestClient Client;
+	if ( !ServerEditStressTest.ActiveClients.RemoveAndCopyValue( PlayerController, Client ) )
+	{
+		return;
+	}
+	ServerEditStressTest.NumEditsSent += FMath::Max( NumEditsSent, 0 );
+
+	// Lists the client has not reported are missing on it
+	int32 NumPathMismatches = Client.NumPathMismatches + Client.NumUnknownPaths;
+	TArray<AFGDrivingTargetList*> ServerTargetLists;
+	GetAllTargetLists( ServerTargetLists );
+	for ( const AFGDrivingTargetList* TargetList : ServerTargetLists )
+	{
+		if ( TargetList && TargetList->GetFirstTarget() && !Client.ReportedTargetLists.Contains( TargetList ) )
+		{
+			UE_LOG( LogBetterVehiclePaths, Warning, TEXT("Path %s is missing on %s"), *TargetList->GetName(), *GetNameSafe( PlayerController ) );
+			NumPathMismatches++;
+		}
+	}
+	ServerEditStressTest.NumPathMismatches += NumPathMismatches;
+
+	UE_LOG( LogBetterVehiclePaths, Display, TEXT("Edit stress test reported by %s: %d edits sent, %d of %d paths do not match the server, %d paths unknown to the server"),
+		*GetNameSafe( PlayerController ), NumEditsSent, NumPathMismatches, ServerTargetLists.Num(), Client.NumUnknownPaths );
+
+	if ( ServerEditStressTest.ActiveClients.IsEmpty() )
+	{
+		FinishServerEditStressTest();
+	}
+}
+
+void UBVPSubsystem::FinishServerEditStressTest()
+{
+	ServerEditStressTest.ActiveClients.Empty();
+
+	// Paths should still satisfy all of the constraints no matter how many edits have been rejected along the way
+	TArray<FBVPPathViolation> Violations;
+	ValidateAllPaths( Violations );
+	LogPathViolations( Violations );
+
+	const int32 NumEditsReceived = NumServerEdits - ServerEditStressTest.StartNumServerEdits;
+	const int32 NumEditsRejected = NumRejectedServerEdits - ServerEditStressTest.StartNumRejectedServerEdits;
+	const double AverageHandlerTime = NumEditsReceived != 0 ? ServerEditStressTest.TotalHandlerTime / NumEditsReceived : 0.0;
+	const double AverageGameThreadTime = ServerEditStressTest.NumFrames != 0 ? ServerEditStressTest.TotalGameThreadTime / ServerEditStressTest.NumFrames : 0.0;
+
+	UE_LOG( LogBetterVehiclePaths, Display, TEXT("Edit stress test finished on the server: %d edits sent by the clients, %d received, %d rejected. ")
+		TEXT("Edit handlers took %.3f ms on average, %.3f ms at peak. Game thread took %.2f ms on average, %.2f ms at peak over %d frames. %d paths did not match, %d path violations found"),
+		ServerEditStressTest.NumEditsSent, NumEditsReceived, NumEditsRejected,
+		AverageHandlerTime * 1000.0, ServerEditStressTest.MaxHandlerTime * 1000.0, AverageGameThreadTime * 1000.0, ServerEditStressTest.MaxGameThreadTime * 1000.0,
+		ServerEditStressTest.NumFrames, ServerEditStressTest.NumPathMismatches, Violations.Num() );
+}
+
+UMaterialInterface* UBVPSubsystem::GetPathVisualizationMaterialInstance( const FLinearColor& Color )
+{
+	// Colors that only differ past 8 bits per channel render the same, so they share the instance
+	const FColor QuantizedColor = Color.ToFColor( true );
+	TWeakObjectPtr<UMaterialInstanceDynamic>& MaterialInstance = PathVisualizationMaterialInstances.FindOrAdd( QuantizedColor );
+	if ( !MaterialInstance.IsValid() )
+	{
+		MaterialInstance = UMaterialInstanceDynamic::Create( PathVisualizationMaterial, this );
+		MaterialInstance->SetVectorParameterValue( UBVPSettings::Get()->PathVisualizationColorParameterName, FLinearColor( QuantizedColor ) );
+	}
+	return MaterialInstance.Get();
+}
+
+AFGTargetPoint* UBVPSubsystem::FindNearestPathNode( const FVector& Location, float MaxDistance ) const
+{
+	return PathNodeIndex.FindNearestPathNode( Location, MaxDistance );
+}
+
+void UBVPSubsystem::FindPathNodesInRadius( const FVector& Location, float Radius, TArray<AFGTargetPoint*>& OutPathNodes ) const
+{
+	OutPathNodes.Reset();
+	PathNodeIndex.FindPathNodesInRadius( Location, Radius, OutPathNodes );
+}
+
+void UBVPSubsystem::FindPathNodesInBox( const FBox& Box, TArray<AFGTargetPoint*>& OutPathNodes ) const
+{
+	OutPathNodes.Reset();
+	PathNodeIndex.FindPathNodesInBox( Box, OutPathNodes );
+}
+
+void UBVPSubsystem::SetVisualizationRequesterState( APlayerController* Requester, FName VisualizationId, EBVPPathVisualizationType VisualizationType, bool bVisualizationEnabled )
+{
+	if ( FBVPPlayerVisualizationTracker* VisualizationTracker = FindVisualizationTrackerForPlayer( Requester, true ) )
+	{
+		VisualizationTracker->SetVisualizationBit( VisualizationId, VisualizationType, bVisualizationEnabled );
+	}
+}
+
+bool UBVPSubsystem::GetVisualizationRequesterState( APlayerController* Requester, FName VisualizationId, EBVPPathVisualizationType VisualizationType )
+{
+	if (const FBVPPlayerVisualizationTracker* VisualizationTracker = FindVisualizationTrackerForPlayer( Requester, false ) )
+	{
+		return VisualizationTracker->GetVisualizationBit( VisualizationId, VisualizationType );
+	}
+	return false;
+}
+
+void UBVPSubsystem::BindPlayerActions( AFGCharacterPlayer* CharacterPlayer, UEnhancedInputComponent* InputComponent )
+{
+	const UBVPSettings* BVPSettings = UBVPSettings::Get();
+	InputComponent->BindAction( BVPSettings->InputActionVisualizePaths.LoadSynchronous(), ETriggerEvent::Triggered, this, &UBVPSubsystem::Input_ToggleVisualizePaths, CharacterPlayer );
+	InputComponent->BindAction( BVPSettings->InputActionOpenPathEditor.LoadSynchronous(), ETriggerEvent::Triggered, this, &UBVPSubsystem::Input_OpenPathEditor, CharacterPlayer );
+}
+
+FBVPPlayerVisualizationTracker* UBVPSubsystem::FindVisualizationTrackerForPlayer( APlayerController* PlayerController, bool bCreateIfNotFound )
+{
+	for ( FBVPPlayerVisualizationTracker* VisualizationTracker : VisualizationTrackers )
+	{
+		if ( VisualizationTracker->IsVisualizationTrackerValid() && VisualizationTracker->GetOwner() == PlayerController )
+		{
+			return VisualizationTracker;
+		}
+	}
+
+	if ( bCreateIfNotFound && PlayerController )
+	{
+		FBVPPlayerVisualizationTracker* NewPlayerTracker = new FBVPPlayerVisualizationTracker( this, PlayerController );
+		VisualizationTrackers.Add( NewPlayerTracker );
+
+		return NewPlayerTracker;
+	}
+	return nullptr;
+}
+
+void UBVPSubsystem::Input_ToggleVisualizePaths( const FInputActionValue& ActionValue, AFGCharacterPlayer* CharacterPlayer )
+{
+	if ( ActionValue.IsNonZero() )
+	{
+		if ( APlayerController* PlayerController = CharacterPlayer->GetController<APlayerController>() )
+		{
+			const FName VisualizationIdKeyBind( TEXT("BVP_InputToggleVisualizePaths") );
+			constexpr EBVPPathVisualizationType VisualizationType = EBVPPathVisualizationType::SegmentVisualization;
+			
+			const bool bCurrentState = GetVisualizationRequesterState( PlayerController, VisualizationIdKeyBind, VisualizationType );
+			SetVisualizationRequesterState( PlayerController, VisualizationIdKeyBind, VisualizationType, !bCurrentState );	
+		}
+	}
+}
+
+void UBVPSubsystem::Input_OpenPathEditor( const FInputActionValue& ActionValue, AFGCharacterPlayer* CharacterPlayer )
+{
+	if ( ActionValue.IsNonZero() )
+	{
+		if ( const AFGPlayerController* PlayerController = CharacterPlayer->GetFGPlayerController() )
+		{
+			if ( AFGHUD* HUD = PlayerController->GetHUD<AFGHUD>() )
+			{
+				HUD->OpenInteractUI( PathEditorWidget, this );
+			}
+		}
+	}
+}
+
+void UBVPSubsystem::TickActiveVisualizations()
+{
+	const AFGVehicleSubsystem* VehicleSubsystem = AFGVehicleSubsystem::Get( this );
+	if ( !VehicleSubsystem )
+	{
+		return;
+	}
+
+	// Cleanup stale visualization paths before we do anything
+	bool bRemovedAnyPaths = false;
+	for ( int32 i = VisualizedPaths.Num() - 1; i >= 0; i-- )
+	{
+		FBVPVehiclePathVisualization* PathVisualization = VisualizedPaths[i];
+		fgcheck( PathVisualization );
+
+		if ( !PathVisualization->IsVisualizationValid() )
+		{
+			VisualizedPathsByTargetList.Remove( PathVisualization->GetTargetListKey() );
+			PathVisualization->DestroyVisualization();
+			delete PathVisualization;
+			VisualizedPaths.RemoveAt( i );
+			bNetworkOverviewDirty = true;
+			bRemovedAnyPaths = true;
+		}
+	}
+
+	// Travel time estimates are only cached for the visualized paths, so drop the ones of the paths that are gone
+	if ( bRemovedAnyPaths )
+	{
+		for ( auto It = TravelTimeEstimateCache.CreateIterator(); It; ++It )
+		{
+			const AFGDrivingTargetList* TargetPointList = It.Key().ResolveObjectPtr();
+			if ( !TargetPointList || !FindPathVisualization( TargetPointList ) )
+			{
+				It.RemoveCurrent();
+			}
+		}
+	}
+	
+	TArray<AFGDrivingTargetList*> AllTargetLists;
+	GetAllTargetLists( AllTargetLists );
+
+	// If we are the client, we need to manually ensure that each target point has a valid cache owner list
+	if ( GetWorld()->IsNetMode( NM_Client ) )
+	{
+		for ( AFGDrivingTargetList* DrivingTargetList : AllTargetLists )
+		{
+			for( AFGTargetPoint* Target = DrivingTargetList->GetFirstTarget(); Target; Target = Target->GetNext() )
+			{
+				Target->SetOwningList( DrivingTargetList );
+				Target->SetVisibility( DrivingTargetList->IsPathVisible() );
+			}
+		}
+	}
+
+	// Update each target list have in the world
+	for ( AFGDrivingTargetList* DrivingTargetList : AllTargetLists )
+	{
+		FBVPVehiclePathVisualization*& ExistingVisualization = VisualizedPathsByTargetList.FindOrAdd( DrivingTargetList );
+		if ( !ExistingVisualization )
+		{
+			ExistingVisualization = new FBVPVehiclePathVisualization( this, DrivingTargetList );
+			VisualizedPaths.Add( ExistingVisualization );
+			bNetworkOverviewDirty = true;
+		}
+
+		fgcheck( ExistingVisualization->IsVisualizationValid() );
+		ExistingVisualization->UpdateVisualization();
+
+		// Node movement replicated from the server is only picked up here, through the change in the path geometry
+		PathNodeIndex.SyncTargetList( DrivingTargetList, ExistingVisualization->GetGeometryGeneration() );
+	}
+	PathNodeIndex.RemoveStaleTargetLists();
+
+	// Visualization actors and their components are the objects the GC has to trace for us. Their actual cost is measured around each GC, see OnPostGarbageCollect
+	int32 NumVisualizationActors = 0;
+	int32 NumVisualizationComponents = 0;
+	for ( const FBVPVehiclePathVisualization* PathVisualization : VisualizedPaths )
+	{
+		const int32 NumPathComponents = PathVisualization->GetNumVisualizationComponents();
+		NumVisualizationActors += NumPathComponents != 0 ? 1 : 0;
+		NumVisualizationComponents += NumPathComponents;
+	}
+	SET_DWORD_STAT( STAT_BVPVisualizationActors, NumVisualizationActors );
+	SET_DWORD_STAT( STAT_BVPVisualizationComponents, NumVisualizationComponents );
+}
+
+void UBVPSubsystem::AddHibernatedSegment( FBVPVehiclePathSegmentVisualization* SegmentVisualization )
+{
+	fgcheck( SegmentVisualization && SegmentVisualization->IsSegmentHibernated() );
+	HibernatedSegments.Add( SegmentVisualization );
+	NumHibernatedComponents += SegmentVisualization->GetNumHibernatedComponents();
+}
+
+void UBVPSubsystem::RemoveHibernatedSegment( FBVPVehiclePathSegmentVisualization* SegmentVisualization )
+{
+	fgcheck( SegmentVisualization );
+	if ( HibernatedSegments.RemoveSingle( SegmentVisualization ) != 0 )
+	{
+		NumHibernatedComponents -= SegmentVisualization->GetNumHibernatedComponents();
+	}
+}
+
+void UBVPSubsystem::TickHibernatedSegments()
+{
+	const UBVPSettings* BVPSettings = UBVPSettings::Get();
+	const double CurrentTime = GetWorld()->GetRealTimeSeconds();
+
+	// Segments are sorted by hibernation time, so we only ever need to release segments from the start of the list
+	int32 NumSegmentsToRelease = 0;
+	int32 NumRemainingComponents = NumHibernatedComponents;
+
+	while ( NumSegmentsToRelease < HibernatedSegments.Num() )
+	{
+		const FBVPVehiclePathSegmentVisualization* SegmentVisualization = HibernatedSegments[NumSegmentsToRelease];
+		const bool bHibernationExpired = CurrentTime - SegmentVisualization->GetHibernationStartTime() >= BVPSettings->PathVisualizationHibernationTime;
+
+		if ( !bHibernationExpired && NumRemainingComponents <= BVPSettings->MaxHibernatedPathComponents )
+		{
+			break;
+		}
+		NumRemainingComponents -= SegmentVisualization->GetNumHibernatedComponents();
+		NumSegmentsToRelease++;
+	}
+
+	if ( NumSegmentsToRelease != 0 )
+	{
+		const TArray<FBVPVehiclePathSegmentVisualization*> SegmentsToRelease( HibernatedSegments.GetData(), NumSegmentsToRelease );
+		HibernatedSegments.RemoveAt( 0, NumSegmentsToRelease );
+		NumHibernatedComponents = NumRemainingComponents;
+
+		for ( FBVPVehiclePathSegmentVisualization* SegmentVisualization : SegmentsToRelease )
+		{
+			SegmentVisualization->ReleaseHibernatedComponents();
+		}
+	}
+	SET_DWORD_STAT( STAT_BVPHibernatedComponents, NumHibernatedComponents );
+}
+
+void UBVPSubsystem::TickVisualizationTrackers()
+{
+	// Cleanup stale or empty visualization trackers, as they use up performance
+	for ( int32 i = VisualizationTrackers.Num() - 1; i >= 0; i-- )
+	{
+		FBVPPlayerVisualizationTracker* VisualizationTracker = VisualizationTrackers[i];
+		fgcheck( VisualizationTracker );
+
+		if ( !VisualizationTracker->IsVisualizationTrackerValid() || VisualizationTracker->IsVisualizationTrackerEmpty() )
+		{
+			VisualizationTracker->DestroyVisualizationTracker();
+			delete VisualizationTracker;
+			VisualizationTrackers.RemoveAt( i );
+		}
+	}
+	
+	if ( VisualizationTrackers.IsEmpty() )
+	{
+		return;
+	}
+	
+	// Pack the segment data once for all trackers
+	TArray<FBVPVehiclePathSegmentVisualization*> AllPathVisualizationSegments;
+	CollectAllVisualizationSegments( AllPathVisualizationSegments );
+
+	TArray<FBVPSegmentRelevanceData> SegmentRelevanceData;
+	SegmentRelevanceData.SetNum( AllPathVisualizationSegments.Num() );
+	for ( int32 i = 0; i < AllPathVisualizationSegments.Num(); i++ )
+	{
+		AllPathVisualizationSegments[i]->GetRelevanceData( SegmentRelevanceData[i] );
+	}
+
+	// Capture observers of all trackers on the game thread
+	TArray<FBVPRelevanceObserver> RelevanceObservers;
+	RelevanceObservers.Reserve( VisualizationTrackers.Num() );
+	
+	for ( FBVPPlayerVisualizationTracker* VisualizationTracker : VisualizationTrackers )
+	{
+		fgcheck( VisualizationTracker );
+		fgcheck( VisualizationTracker->IsVisualizationTrackerValid() );
+
+		FBVPRelevanceObserver& RelevanceObserver = RelevanceObservers.AddDefaulted_GetRef();
+		if ( !VisualizationTracker->BuildRelevanceObserver( AllPathVisualizationSegments, RelevanceObserver ) )
+		{
+			RelevanceObservers.Pop();
+		}
+	}
+
+	// Evaluate the relevance for all observers in a single parallel sweep over the segments
+	TArray<double> ClosestObserverDistances;
+	FBVPPlayerVisualizationTracker::EvaluateRelevance( AllPathVisualizationSegments, SegmentRelevanceData, RelevanceObservers, ClosestObserverDistances );
+
+	// Apply the results back on the game thread
+	for ( const FBVPRelevanceObserver& RelevanceObserver : RelevanceObservers )
+	{
+		RelevanceObserver.Tracker->ApplyRelevanceObserver( AllPathVisualizationSegments, RelevanceObserver );
+	}
+	for ( int32 i = 0; i < AllPathVisualizationSegments.Num(); i++ )
+	{
+		if ( ClosestObserverDistances[i] < UE_BIG_NUMBER )
+		{
+			AllPathVisualizationSegments[i]->ReportObserverDistance( ClosestObserverDistances[i] );
+		}
+	}
+}
+
+void UBVPSubsystem::CollectAllVisualizationSegments( TArray<FBVPVehiclePathSegmentVisualization*>& OutAllSegments )
+{
+	OutAllSegments.Reserve( LastNumVisualizationSegments );
+
+	for ( const FBVPVehiclePathVisualization* PathVisualization : VisualizedPaths )
+	{
+		OutAllSegments.Append( PathVisualization->GetVisualizationSegments() );
+	}
+	LastNumVisualizationSegments = OutAllSegments.Num();
+}
+
+int32 UBVPSubsystem::AllocateSegmentStateSlot()
+{
+	return !FreeSegmentStateSlots.IsEmpty() ? FreeSegmentStateSlots.Pop( false ) : NumSegmentStateSlots++;
+}
+
+void UBVPSubsystem::ReleaseSegmentStateSlot( int32 SlotIndex )
+{
+	fgcheck( SlotIndex >= 0 && SlotIndex < NumSegmentStateSlots );
+	FreeSegmentStateSlots.Add( SlotIndex );
+}
+
+void UBVPSubsystem::TickNetworkOverview()
+{
+	// Network overview is shared between all local players, so show it if any of them wants it
+	bool bWantsNetworkOverview = false;
+	for ( const FBVPPlayerVisualizationTracker* VisualizationTracker : VisualizationTrackers )
+	{
+		bWantsNetworkOverview |= EnumHasAnyFlags( VisualizationTracker->GetCombinedVisualizationFlags(), EBVPPathVisualizationType::NetworkOverview );
+	}
+
+	if ( !bWantsNetworkOverview )
+	{
+		if ( NetworkOverviewActor )
+		{
+			NetworkOverviewActor->Destroy();
+			NetworkOverviewActor = nullptr;
+			NetworkOverviewLineBatch = nullptr;
+		}
+		return;
+	}
+
+	if ( !NetworkOverviewActor )
+	{
+		FActorSpawnParameters SpawnParameters{};
+		SpawnParameters.Name = TEXT("NetworkOverviewActor");
+		SpawnParameters.NameMode = FActorSpawnParameters::ESpawnActorNameMode::Requested;
+		NetworkOverviewActor = GetWorld()->SpawnActor<ABVPPathVisualizationActor>( SpawnParameters );
+
+		NetworkOverviewLineBatch = NewObject<ULineBatchComponent>( NetworkOverviewActor, NAME_None, RF_Transient );
+		NetworkOverviewLineBatch->SetupAttachment( NetworkOverviewActor->GetRootComponent() );
+		NetworkOverviewLineBatch->RegisterComponent();
+		bNetworkOverviewDirty = true;
+	}
+
+	// Only regenerate lines for the paths that have changed, but re-submit all of them into the single line batch
+	int32 NumNetworkOverviewLines = 0;
+	for ( FBVPVehiclePathVisualization* PathVisualization : VisualizedPaths )
+	{
+		bNetworkOverviewDirty |= PathVisualization->UpdateNetworkOverviewLines();
+		NumNetworkOverviewLines += PathVisualization->GetNetworkOverviewLines().Num();
+	}
+
+	if ( bNetworkOverviewDirty )
+	{
+		TArray<FBatchedLine> NetworkOverviewLines;
+		NetworkOverviewLines.Reserve( NumNetworkOverviewLines );
+
+		for ( const FBVPVehiclePathVisualization* PathVisualization : VisualizedPaths )
+		{
+			NetworkOverviewLines.Append( PathVisualization->GetNetworkOverviewLines() );
+		}
+		NetworkOverviewLineBatch->Flush();
+		NetworkOverviewLineBatch->DrawLines( NetworkOverviewLines );
+		bNetworkOverviewDirty = false;
+	}
+}
+
+void UBVPSubsystem::TickProblemDetector()
+{
+	const UBVPSettings* BVPSettings = UBVPSettings::Get();
+
+	// Only a few paths are re-analyzed per frame. Paths that have not changed since their last analysis are skipped quickly
+	const int32 NumPathsToAnalyze = FMath::Min( FMath::Max( BVPSettings->ProblemDetectorPathsPerFrame, 1 ), VisualizedPaths.Num() );
+	for ( int32 i = 0; i < NumPathsToAnalyze; i++ )
+	{
+		ProblemDetectorCursor = ( ProblemDetectorCursor + 1 ) % VisualizedPaths.Num();
+		VisualizedPaths[ProblemDetectorCursor]->UpdatePathProblems();
+	}
+
+	// Conflicts involve multiple paths, so the changed paths are re-tested against all of the others at once
+	if ( PathConflictDetector.Update( VisualizedPaths ) )
+	{
+		TMap<TObjectKey<AFGDrivingTargetList>, TArray<TObjectKey<AFGTargetPoint>>> ConflictingSegmentStartNodes;
+		PathConflictDetector.GetConflictingSegmentStartNodes( ConflictingSegmentStartNodes );
+
+		for ( FBVPVehiclePathVisualization* PathVisualization : VisualizedPaths )
+		{
+			TArray<TObjectKey<AFGTargetPoint>> PathSegmentStartNodes;
+			ConflictingSegmentStartNodes.RemoveAndCopyValue( PathVisualization->GetTargetListKey(), PathSegmentStartNodes );
+			PathVisualization->SetConflictingSegmentStartNodes( MoveTemp( PathSegmentStartNodes ) );
+		}
+	}
+
+	// Problem highlight is shared between all local players, same as the network overview
+	bool bWantsProblemHighlight = false;
+	for ( const FBVPPlayerVisualizationTracker* VisualizationTracker : VisualizationTrackers )
+	{
+		bWantsProblemHighlight |= EnumHasAnyFlags( VisualizationTracker->GetCombinedVisualizationFlags(), EBVPPathVisualizationType::ProblemHighlight );
+	}
+	for ( FBVPVehiclePathVisualization* PathVisualization : VisualizedPaths )
+	{
+		PathVisualization->ApplyProblemHighlight( bWantsProblemHighlight, BVPSettings->ProblemHighlightColor, BVPSettings->ConflictHighlightColor );
+	}
+}
+
+void UBVPSubsystem::TickLoadValidation()
+{
+	if ( !bPendingLoadValidation )
+	{
+		return;
+	}
+	bPendingLoadValidation = false;
+
+	TArray<FBVPPathViolation> Violations;
+	if ( !ValidateAllPaths( Violations ) )
+	{
+		UE_LOG( LogBetterVehiclePaths, Warning, TEXT("Found %d violations in the vehicle paths loaded from the save"), Violations.Num() );
+		LogPathViolations( Violations );
+	}
+}
+
+void UBVPSubsystem::TickPathImports()
+{
+	if ( PendingPathImports.IsEmpty() )
+	{
+		return;
+	}
+	if ( !AFGVehicleSubsystem::Get( GetWorld() ) )
+	{
+		return;
+	}
+
+	// Spawn the nodes of the imported paths in order, spending the node budget of this frame across as many paths as it allows
+	int32 RemainingNodeBudget = FMath::Max( UBVPSettings::Get()->PathImportNodesPerFrame, 1 );
+	while ( RemainingNodeBudget > 0 && !PendingPathImports.IsEmpty() )
+	{
+		FBVPPendingPathImport& PendingImport = PendingPathImports[0];
+		// Target list is only registered once all of its nodes have been spawned, so that no vehicle picks up a partial path
+		if ( PendingImport.NumSpawnedPathNodes == 0 )
+		{
+			PendingImport.TargetList = SpawnTargetListInternal();
+		}
+
+		// Target list might have been destroyed while the import was in progress
+		AFGDrivingTargetList* TargetList = PendingImport.TargetList.Get();
+		if ( !TargetList )
+		{
+			PendingPathImports.RemoveAt( 0 );
+			continue;
+		}
+
+		const int32 NumPathNodesToSpawn = FMath::Min( RemainingNodeBudget, PendingImport.Path.PathNodes.Num() - PendingImport.NumSpawnedPathNodes );
+		for ( int32 i = 0; i < NumPathNodesToSpawn; i++ )
+		{
+			const FBVPExportedPathNode& PathNode = PendingImport.Path.PathNodes[PendingImport.NumSpawnedPathNodes++];
+			const FTransform Transform( PathNode.Rotation, PathNode.Location );
+
+			AFGTargetPoint* NewPathNode = GetWorld()->SpawnActorDeferred<AFGTargetPoint>( PathNodeClass, Transform, TargetList, nullptr );
+			fgcheck( NewPathNode );
+			NewPathNode->SetTargetSpeed( PathNode.TargetSpeed );
+
+			// Appends the node to the end of the list. Target count and the path are only updated once all nodes have been spawned
+			TargetList->InsertItem( NewPathNode );
+			NewPathNode->FinishSpawning( Transform, false );
+			PathNodeIndex.UpdatePathNode( NewPathNode );
+		}
+		RemainingNodeBudget -= NumPathNodesToSpawn;
+
+		if ( PendingImport.NumSpawnedPathNodes == PendingImport.Path.PathNodes.Num() )
+		{
+			MarkTargetListComplete( TargetList );
+			RebuildTargetListPath( TargetList );
+			RegisterTargetListInternal( TargetList );
+			ValidateEditedPaths( { TargetList } );
+
+			PendingPathImports.RemoveAt( 0 );
+			OnPathImported.Broadcast( TargetList );
+		}
+	}
+}
+
+void UBVPSubsystem::TickEditStressTest()
+{
+	// Server side measures every frame while any client is taking part, and ends the test early if all of them have left
+	if ( !ServerEditStressTest.ActiveClients.IsEmpty() )
+	{
+		for ( auto It = ServerEditStressTest.ActiveClients.CreateIterator(); It; ++It )
+		{
+			if ( !It.Key().IsValid() )
+			{
+				It.RemoveCurrent();
+			}
+		}
+		if ( ServerEditStressTest.ActiveClients.IsEmpty() )
+		{
+			FinishServerEditStressTest();
+		}
+		else
+		{
+			// Time between the ticks is a full frame of work plus the idle time at the start of this frame, which is the server waiting for its tick rate
+			const double FrameTimestamp = FPlatformTime::Seconds();
+			const double GameThreadTime = FMath::Max( FrameTimestamp - ServerEditStressTest.LastFrameTimestamp - FApp::GetIdleTime(), 0.0 );
+			ServerEditStressTest.LastFrameTimestamp = FrameTimestamp;
+			ServerEditStressTest.TotalGameThreadTime += GameThreadTime;
+			ServerEditStressTest.MaxGameThreadTime = FMath::Max( ServerEditStressTest.MaxGameThreadTime, GameThreadTime );
+			ServerEditStressTest.NumFrames++;
+		}
+	}
+
+	if ( !EditStressTest.bRunning && !EditStressTest.bSettling )
+	{
+		return;
+	}
+	AFGPlayerController* PlayerController = EditStressTest.PlayerController.Get();
+	if ( !PlayerController || !PlayerController->GetNetConnection() )
+	{
+		EditStressTest = FBVPEditStressTest();
+		return;
+	}
+	SampleEditStressTestConnection( PlayerController );
+
+	if ( EditStressTest.bSettling )
+	{
+		if ( GetWorld()->GetRealTimeSeconds() >= EditStressTest.SettleEndTime )
+		{
+			FinishEditStressTest();
+		}
+		return;
+	}
+	if ( GetWorld()->GetRealTimeSeconds() >= EditStressTest.EndTime )
+	{
+		StopEditStressTest();
+		return;
+	}
+
+	TArray<AFGDrivingTargetList*> TargetLists;
+	GetAllTargetLists( TargetLists );
+	TargetLists.RemoveAll( []( const AFGDrivingTargetList* TargetList ) { return !TargetList || !TargetList->GetFirstTarget(); } );
+	if ( TargetLists.IsEmpty() )
+	{
+		return;
+	}
+
+	// Edits are paced in real time, so that a slow client does not send fewer of them than requested
+	EditStressTest.PendingEdits += EditStressTest.EditRateMultiplier * EditStressTest.EditsPerSecond * FApp::GetDeltaTime();
+	const int32 NumEditsThisFrame = FMath::FloorToInt32( EditStressTest.PendingEdits );
+	EditStressTest.PendingEdits -= NumEditsThisFrame;
+
+	for ( int32 i = 0; i < NumEditsThisFrame; i++ )
+	{
+		IssueStressTestEdit( PlayerController, TargetLists );
+	}
+}
+
+void UBVPSubsystem::SampleEditStressTestConnection( const AFGPlayerController* PlayerController )
+{
+	UNetConnection* NetConnection = PlayerController->GetNetConnection();
+	if ( !NetConnection )
+	{
+		return;
+	}
+
+	// Edit RPCs are reliable and ride on the actor channel of the player, so the bunches waiting for an ack there are the RPCs the server has not confirmed yet
+	const UActorChannel* ActorChannel = NetConnection->FindActorChannelRef( const_cast<AFGPlayerController*>( PlayerController ) );
+	const int32 NumOutReliableBunches = ActorChannel ? ActorChannel->NumOutRec : 0;
+
+	EditStressTest.TotalInBytesPerSecond += NetConnection->InBytesPerSecond;
+	EditStressTest.TotalOutBytesPerSecond += NetConnection->OutBytesPerSecond;
+	EditStressTest.MaxOutBytesPerSecond = FMath::Max( EditStressTest.MaxOutBytesPerSecond, NetConnection->OutBytesPerSecond );
+	EditStressTest.TotalNumOutReliableBunches += NumOutReliableBunches;
+	EditStressTest.MaxNumOutReliableBunches = FMath::Max( EditStressTest.MaxNumOutReliableBunches, NumOutReliableBunches );
+	EditStressTest.NumSamples++;
+}
+
+void UBVPSubsystem::IssueStressTestEdit( AFGPlayerController* PlayerController, const TArray<AFGDrivingTargetList*>& TargetLists )
+{
+	FRandomStream& RandomStream = EditStressTest.RandomStream;
+	const UBVPSettings* BVPSettings = UBVPSettings::Get();
+
+	AFGDrivingTargetList* TargetList = TargetLists[RandomStream.RandHelper( TargetLists.Num() )];
+	TArray<AFGTargetPoint*> PathNodes;
+	GetTargetListPathNodes( TargetList, PathNodes );
+	if ( PathNodes.Num() < 2 )
+	{
+		return;
+	}
+	AFGTargetPoint* PathNode = PathNodes[RandomStream.RandHelper( PathNodes.Num() )];
+	const AFGTargetPoint* NextPathNode = FindNextTargetPoint( PathNode );
+
+	// Keep enough nodes around so that the paths do not collapse over a long test
+	constexpr int32 MinStressTestPathNodes = 8;
+	int32 EditType = RandomStream.RandHelper( 4 );
+	if ( EditType == 3 && PathNodes.Num() <= MinStressTestPathNodes )
+	{
+		EditType = 0;
+	}
+
+	// Edits go through the same functions as the edits of the player, so they are checked on the client and sent as the regular server RPCs
+	bool bEditSent = false;
+	FText IgnoredErrorMessage;
+	switch ( EditType )
+	{
+	case 0:
+		{
+			// Offsets of up to half of the maximum distance between the nodes are regularly rejected, exercising both outcomes of the edit
+			const double MaxOffset = BVPSettings->MaxDistanceBetweenPathNodes * 0.5;
+			const FVector Offset( RandomStream.FRandRange( -MaxOffset, MaxOffset ), RandomStream.FRandRange( -MaxOffset, MaxOffset ), 0.0 );
+			bEditSent = MovePathNode( PlayerController, PathNode, PathNode->GetActorLocation() + Offset, PathNode->GetActorRotation(), false, IgnoredErrorMessage );
+			break;
+		}
+	case 1:
+		bEditSent = SetPathNodeTargetSpeed( PlayerController, PathNode, RandomStream.RandRange( 1, FMath::Max( BVPSettings->MaxTargetSpeed, 1 ) ) );
+		break;
+	case 2:
+		// New nodes are created at the middle of the segment, hit the same way the path editor traces it
+		if ( USplineComponent* SplineComponent = NextPathNode ? TargetList->GetPath() : nullptr )
+		{
+			const FVector HitLocation = ( PathNode->GetActorLocation() + NextPathNode->GetActorLocation() ) * 0.5;
+			FBVPVehiclePathSegmentHit SegmentHit;
+			SegmentHit.SplineComponent = SplineComponent;
+			SegmentHit.ProgressAlongSpline = FindInputKeyClosestToHitLocation( TargetList, SplineComponent, HitLocation );
+			SegmentHit.PointAfter = GetTargetPointAtSplinePoint( TargetList, SplineComponent->SplineCurves.Position.GetPointIndexForInputValue( SegmentHit.ProgressAlongSpline ), SplineComponent->GetNumberOfSplinePoints() );
+			bEditSent = SegmentHit.PointAfter && CreateNewPathNode( PlayerController, SegmentHit, IgnoredErrorMessage );
+		}
+		break;
+	default:
+		bEditSent = RemovePathNode( PlayerController, PathNode, IgnoredErrorMessage );
+		break;
+	}
+
+	if ( bEditSent )
+	{
+		EditStressTest.NumEditsSent++;
+	}
+	else
+	{
+		EditStressTest.NumEditsRejectedLocally++;
+	}
+}
+
+void UBVPSubsystem::RecordServerEdit( bool bEditAccepted, double HandlerTime )
+{
+	NumServerEdits++;
+	INC_DWORD_STAT( STAT_BVPServerEdits );
+	if ( !bEditAccepted )
+	{
+		NumRejectedServerEdits++;
+		INC_DWORD_STAT( STAT_BVPRejectedServerEdits );
+	}
+	if ( !ServerEditStressTest.ActiveClients.IsEmpty() )
+	{
+		ServerEditStressTest.TotalHandlerTime += HandlerTime;
+		ServerEditStressTest.MaxHandlerTime = FMath::Max( ServerEditStressTest.MaxHandlerTime, HandlerTime );
+	}
+}
+
+void UBVPRemoteCallObject::GetLifetimeReplicatedProps( TArray<FLifetimeProperty>& OutLifetimeProps ) const
+{
+	Super::GetLifetimeReplicatedProps( OutLifetimeProps );
 
 	DOREPLIFETIME( ThisClass, ForceNetField_UBVPRemoteCallObject );
 }
@@ -628,11 +3451,14 @@ void UBVPRemoteCallObject::Server_EditPathNode_Implementation( AFGTargetPoint* T
 	if ( BVPSubsystem && TargetPoint )
 	{
 		// If we have failed to update the path node, force the correct location back to the client
+		const double HandlerStartTime = FPlatformTime::Seconds();
 		FText IgnoredErrorMessage;
-		if ( !BVPSubsystem->MovePathNode( nullptr, TargetPoint, NewLocation, NewRotation, false, IgnoredErrorMessage ) )
+		const bool bEditAccepted = BVPSubsystem->MovePathNode( GetOuterFGPlayerController(), TargetPoint, NewLocation, NewRotation, false, IgnoredErrorMessage );
+		if ( !bEditAccepted )
 		{
 			Client_ForcePathNodeUpdate( TargetPoint, TargetPoint->GetActorLocation(), TargetPoint->GetActorRotation() );
 		}
+		BVPSubsystem->RecordServerEdit( bEditAccepted, FPlatformTime::Seconds() - HandlerStartTime );
 	}
 }
 
@@ -641,6 +3467,10 @@ void UBVPRemoteCallObject::Client_ForcePathNodeUpdate_Implementation( AFGTargetP
 	if ( TargetPoint )
 	{
 		TargetPoint->SetActorLocationAndRotation( NewLocation, NewRotation );
+		if ( UBVPSubsystem* BVPSubsystem = GetWorld()->GetSubsystem<UBVPSubsystem>() )
+		{
+			BVPSubsystem->PathNodeIndex.UpdatePathNode( TargetPoint );
+		}
 		if ( AFGDrivingTargetList* OwnerTargetList = TargetPoint->GetOwningList() )
 		{
 			if ( OwnerTargetList->IsComplete() && OwnerTargetList->HasData() )
@@ -656,24 +3486,38 @@ void UBVPRemoteCallObject::Server_RemovePathNode_Implementation( AFGTargetPoint*
 	UBVPSubsystem* BVPSubsystem = GetWorld()->GetSubsystem<UBVPSubsystem>();
 	if ( BVPSubsystem && TargetPoint )
 	{
+		const double HandlerStartTime = FPlatformTime::Seconds();
 		FText IgnoredErrorMessage;
-		BVPSubsystem->RemovePathNode( nullptr, TargetPoint, IgnoredErrorMessage );
+		const bool bEditAccepted = BVPSubsystem->RemovePathNode( GetOuterFGPlayerController(), TargetPoint, IgnoredErrorMessage );
+		BVPSubsystem->RecordServerEdit( bEditAccepted, FPlatformTime::Seconds() - HandlerStartTime );
 	}
 }
 
 void UBVPRemoteCallObject::Server_CreatePathNode_Implementation( AFGTargetPoint* AfterPoint, const FVector& NewLocation, const FRotator& NewRotation, int32 TargetSpeed )
 {
 	UBVPSubsystem* BVPSubsystem = GetWorld()->GetSubsystem<UBVPSubsystem>();
+	if ( !BVPSubsystem )
+	{
+		return;
+	}
 
-	if ( BVPSubsystem && AfterPoint && UBVPSubsystem::FindNextTargetPoint( AfterPoint ) &&
+	const double HandlerStartTime = FPlatformTime::Seconds();
+	bool bEditAccepted = false;
+	if ( AfterPoint && UBVPSubsystem::FindNextTargetPoint( AfterPoint ) &&
 		UBVPSubsystem::CheckDistanceBetweenTwoPoints( AfterPoint->GetActorLocation(), NewLocation ) &&
 		UBVPSubsystem::CheckDistanceBetweenTwoPoints( UBVPSubsystem::FindNextTargetPoint( AfterPoint )->GetActorLocation(), NewLocation ) )
 	{
 		if ( AFGTargetPoint* NewTargetPoint = BVPSubsystem->CreatePawnPathNodeInternal( AfterPoint, NewLocation, NewRotation, TargetSpeed ) )
 		{
+			if ( FBVPPathEditHistory* EditHistory = BVPSubsystem->FindPathEditHistoryForRecording( GetOuterFGPlayerController() ) )
+			{
+				EditHistory->RecordCreate( NewTargetPoint, AfterPoint );
+			}
 			Client_NotifyPointSpawned( NewTargetPoint );
+			bEditAccepted = true;
 		}
 	}
+	BVPSubsystem->RecordServerEdit( bEditAccepted, FPlatformTime::Seconds() - HandlerStartTime );
 }
 
 void UBVPRemoteCallObject::Client_NotifyPointSpawned_Implementation( AFGTargetPoint* NewPoint )
@@ -689,10 +3533,223 @@ void UBVPRemoteCallObject::Client_NotifyPointSpawned_Implementation( AFGTargetPo
 void UBVPRemoteCallObject::Server_SetPathNodeTargetSpeed_Implementation( AFGTargetPoint* TargetPoint, int32 TargetSpeed )
 {
 	UBVPSubsystem* BVPSubsystem = GetWorld()->GetSubsystem<UBVPSubsystem>();
-	if ( BVPSubsystem && TargetPoint && TargetSpeed > 0 )
+	if ( BVPSubsystem )
+	{
+		const double HandlerStartTime = FPlatformTime::Seconds();
+		const bool bEditAccepted = TargetPoint && TargetSpeed > 0 && BVPSubsystem->SetPathNodeTargetSpeed( GetOuterFGPlayerController(), TargetPoint, TargetSpeed );
+		BVPSubsystem->RecordServerEdit( bEditAccepted, FPlatformTime::Seconds() - HandlerStartTime );
+	}
+}
+
+void UBVPRemoteCallObject::Server_BeginEditStressTest_Implementation()
+{
+	if ( UBVPSubsystem* BVPSubsystem = GetWorld()->GetSubsystem<UBVPSubsystem>() )
+	{
+		BVPSubsystem->BeginServerEditStressTest( GetOuterFGPlayerController() );
+	}
+}
+
+void UBVPRemoteCallObject::Server_ReportEditStressTestPath_Implementation( const FBVPEditStressTestPathReport& Report )
+{
+	if ( UBVPSubsystem* BVPSubsystem = GetWorld()->GetSubsystem<UBVPSubsystem>() )
+	{
+		BVPSubsystem->ReportServerEditStressTestPath( GetOuterFGPlayerController(), Report );
+	}
+}
+
+void UBVPRemoteCallObject::Server_ReportEditStressTest_Implementation( int32 NumEditsSent )
+{
+	if ( UBVPSubsystem* BVPSubsystem = GetWorld()->GetSubsystem<UBVPSubsystem>() )
+	{
+		BVPSubsystem->ReportServerEditStressTest( GetOuterFGPlayerController(), NumEditsSent );
+	}
+}
+
+void UBVPRemoteCallObject::Server_ApplyPathNodeTransforms_Implementation( const TArray<AFGTargetPoint*>& PathNodes, const TArray<FTransform>& NewTransforms, bool bRigidTransform )
+{
+	UBVPSubsystem* BVPSubsystem = GetWorld()->GetSubsystem<UBVPSubsystem>();
+	if ( BVPSubsystem && PathNodes.Num() == NewTransforms.Num() )
+	{
+		// If the edit has been rejected, force the current transforms of all the nodes back to the client
+		FText IgnoredErrorMessage;
+		if ( !BVPSubsystem->ApplyPathNodeTransformsInternal( nullptr, PathNodes, NewTransforms, bRigidTransform, IgnoredErrorMessage ) )
+		{
+			TArray<AFGTargetPoint*> ValidPathNodes;
+			TArray<FTransform> CurrentTransforms;
+			for ( AFGTargetPoint* PathNode : PathNodes )
+			{
+				if ( PathNode )
+				{
+					ValidPathNodes.Add( PathNode );
+					CurrentTransforms.Add( PathNode->GetActorTransform() );
+				}
+			}
+			Client_ForcePathNodeTransforms( ValidPathNodes, CurrentTransforms );
+		}
+	}
+}
+
+void UBVPRemoteCallObject::Server_TransformPathRange_Implementation( AFGTargetPoint* FirstPathNode, AFGTargetPoint* LastPathNode, const FMatrix& Transform )
+{
+	UBVPSubsystem* BVPSubsystem = GetWorld()->GetSubsystem<UBVPSubsystem>();
+	if ( BVPSubsystem && FirstPathNode && LastPathNode )
+	{
+		// If the edit has been rejected, force the current transforms of the range back to the client
+		FText IgnoredErrorMessage;
+		if ( !BVPSubsystem->TransformPathRangeInternal( nullptr, FirstPathNode, LastPathNode, Transform, IgnoredErrorMessage ) )
+		{
+			TArray<AFGTargetPoint*> PathNodes;
+			UBVPSubsystem::GetPathNodeRange( FirstPathNode, LastPathNode, PathNodes );
+
+			TArray<FTransform> CurrentTransforms;
+			for ( const AFGTargetPoint* PathNode : PathNodes )
+			{
+				CurrentTransforms.Add( PathNode->GetActorTransform() );
+			}
+			Client_ForcePathNodeTransforms( PathNodes, CurrentTransforms );
+		}
+	}
+}
+
+void UBVPRemoteCallObject::Server_RemovePathNodes_Implementation( const TArray<AFGTargetPoint*>& PathNodes )
+{
+	UBVPSubsystem* BVPSubsystem = GetWorld()->GetSubsystem<UBVPSubsystem>();
+	if ( BVPSubsystem )
+	{
+		FText IgnoredErrorMessage;
+		BVPSubsystem->RemovePathNodes( nullptr, PathNodes, IgnoredErrorMessage );
+	}
+}
+
+void UBVPRemoteCallObject::Server_SimplifyPath_Implementation( AFGDrivingTargetList* TargetPointList, float Tolerance, int32 SpeedChangeThreshold )
+{
+	UBVPSubsystem* BVPSubsystem = GetWorld()->GetSubsystem<UBVPSubsystem>();
+	if ( BVPSubsystem && TargetPointList )
+	{
+		int32 IgnoredNumRemovedNodes = 0;
+		FText IgnoredErrorMessage;
+		BVPSubsystem->SimplifyPath( nullptr, TargetPointList, Tolerance, SpeedChangeThreshold, IgnoredNumRemovedNodes, IgnoredErrorMessage );
+	}
+}
+
+void UBVPRemoteCallObject::Server_ResamplePath_Implementation( AFGDrivingTargetList* TargetPointList, float Spacing )
+{
+	UBVPSubsystem* BVPSubsystem = GetWorld()->GetSubsystem<UBVPSubsystem>();
+	if ( BVPSubsystem && TargetPointList )
+	{
+		int32 IgnoredNumPathNodes = 0;
+		FText IgnoredErrorMessage;
+		BVPSubsystem->ResamplePath( nullptr, TargetPointList, Spacing, IgnoredNumPathNodes, IgnoredErrorMessage );
+	}
+}
+
+void UBVPRemoteCallObject::Server_OptimizePathTargetSpeeds_Implementation( AFGDrivingTargetList* TargetPointList )
+{
+	UBVPSubsystem* BVPSubsystem = GetWorld()->GetSubsystem<UBVPSubsystem>();
+	if ( BVPSubsystem && TargetPointList )
+	{
+		TArray<int32> IgnoredTargetSpeeds;
+		FText IgnoredErrorMessage;
+		BVPSubsystem->OptimizePathTargetSpeeds( nullptr, TargetPointList, IgnoredTargetSpeeds, IgnoredErrorMessage );
+	}
+}
+
+void UBVPRemoteCallObject::Server_ImportPaths_Implementation( const TArray<uint8>& Data )
+{
+	if ( UBVPSubsystem* BVPSubsystem = GetWorld()->GetSubsystem<UBVPSubsystem>() )
+	{
+		FText ErrorMessage;
+		if ( !BVPSubsystem->ImportPaths( GetOuterFGPlayerController(), Data, ErrorMessage ) )
+		{
+			UE_LOG( LogBetterVehiclePaths, Warning, TEXT("Rejected the path import of %s: %s"), *GetNameSafe( GetOuterFGPlayerController() ), *ErrorMessage.ToString() );
+		}
+	}
+}
+
+void UBVPRemoteCallObject::Server_UndoPathEdit_Implementation()
+{
+	if ( UBVPSubsystem* BVPSubsystem = GetWorld()->GetSubsystem<UBVPSubsystem>() )
+	{
+		FText IgnoredErrorMessage;
+		BVPSubsystem->UndoPathEdit( GetOuterFGPlayerController(), IgnoredErrorMessage );
+	}
+}
+
+void UBVPRemoteCallObject::Server_RedoPathEdit_Implementation()
+{
+	if ( UBVPSubsystem* BVPSubsystem = GetWorld()->GetSubsystem<UBVPSubsystem>() )
+	{
+		FText IgnoredErrorMessage;
+		BVPSubsystem->RedoPathEdit( GetOuterFGPlayerController(), IgnoredErrorMessage );
+	}
+}
+
+void UBVPRemoteCallObject::Server_ReversePath_Implementation( AFGDrivingTargetList* TargetPointList )
+{
+	UBVPSubsystem* BVPSubsystem = GetWorld()->GetSubsystem<UBVPSubsystem>();
+	if ( BVPSubsystem && TargetPointList )
+	{
+		FText IgnoredErrorMessage;
+		BVPSubsystem->ReversePath( nullptr, TargetPointList, IgnoredErrorMessage );
+	}
+}
+
+void UBVPRemoteCallObject::Server_SplitPathAtNode_Implementation( AFGTargetPoint* FirstPathNode, AFGTargetPoint* LastPathNode )
+{
+	if ( UBVPSubsystem* BVPSubsystem = GetWorld()->GetSubsystem<UBVPSubsystem>() )
+	{
+		FText IgnoredErrorMessage;
+		BVPSubsystem->SplitPathAtNode( nullptr, FirstPathNode, LastPathNode, IgnoredErrorMessage );
+	}
+}
+
+void UBVPRemoteCallObject::Server_MergePaths_Implementation( AFGTargetPoint* AfterPathNode, AFGTargetPoint* FirstMergedPathNode )
+{
+	if ( UBVPSubsystem* BVPSubsystem = GetWorld()->GetSubsystem<UBVPSubsystem>() )
+	{
+		FText IgnoredErrorMessage;
+		BVPSubsystem->MergePaths( nullptr, AfterPathNode, FirstMergedPathNode, IgnoredErrorMessage );
+	}
+}
+
+void UBVPRemoteCallObject::Client_ForcePathNodeTransforms_Implementation( const TArray<AFGTargetPoint*>& PathNodes, const TArray<FTransform>& NewTransforms )
+{
+	UBVPSubsystem* BVPSubsystem = GetWorld()->GetSubsystem<UBVPSubsystem>();
+	if ( BVPSubsystem && PathNodes.Num() == NewTransforms.Num() )
 	{
-		BVPSubsystem->SetPathNodeTargetSpeed( nullptr, TargetPoint, TargetSpeed );
+		BVPSubsystem->SetPathNodeTransformsInternal( PathNodes, NewTransforms );
 	}
 }
 
+static FAutoConsoleCommandWithWorldAndArgs EditStressTestCommand(
+	TEXT("BVP.EditStressTest"),
+	TEXT("Sends randomized path edits through the server RPCs of the local player, and reports the bandwidth, the reliable backlog and whether the paths match the server once done. ")
+	TEXT("The rate multiplier only scales the edit rate of this one player. To simulate concurrent editors, run it on several client processes at once, ")
+	TEXT("e.g. clients started with -nullrhi connected to a dedicated server started with -server; the server logs its own load when all of them have finished. ")
+	TEXT("Usage: BVP.EditStressTest [EditRateMultiplier] [EditsPerSecond] [Duration] [Seed], or BVP.EditStressTest stop"),
+	FConsoleCommandWithWorldAndArgsDelegate::CreateLambda( []( const TArray<FString>& Args, UWorld* World )
+	{
+		UBVPSubsystem* BVPSubsystem = World ? World->GetSubsystem<UBVPSubsystem>() : nullptr;
+		if ( !BVPSubsystem )
+		{
+			return;
+		}
+		if ( !Args.IsEmpty() && Args[0] == TEXT("stop") )
+		{
+			BVPSubsystem->StopEditStressTest();
+			return;
+		}
+
+		const int32 EditRateMultiplier = Args.IsValidIndex( 0 ) ? FCString::Atoi( *Args[0] ) : 1;
+		const float EditsPerSecond = Args.IsValidIndex( 1 ) ? FCString::Atof( *Args[1] ) : 5.0f;
+		const float Duration = Args.IsValidIndex( 2 ) ? FCString::Atof( *Args[2] ) : 60.0f;
+		const int32 RandomSeed = Args.IsValidIndex( 3 ) ? FCString::Atoi( *Args[3] ) : 0;
+
+		if ( !BVPSubsystem->StartEditStressTest( World->GetFirstPlayerController<AFGPlayerController>(), EditRateMultiplier, EditsPerSecond, Duration, RandomSeed ) )
+		{
+			UE_LOG( LogBetterVehiclePaths, Warning, TEXT("Failed to start the edit stress test. It has to be run on a client connected to a server, and only one test can run at a time") );
+		}
+	} )
+);
+
 #undef LOCTEXT_NAMESPACE
@@ -2,14 +2,17 @@
 
 #include "BVPVehiclePathSegmentVisualization.h"
 
+#include "BVPPathVisualizationActor.h"
 #include "BVPPlayerVisualizationTracker.h"
 #include "BVPSettings.h"
 #include "BVPSubsystem.h"
 #include "BVPVehiclePathVisualization.h"
 #include "Components/BoxComponent.h"
+#include "Components/LineBatchComponent.h"
 #include "Components/SplineComponent.h"
 #include "Components/SplineMeshComponent.h"
 #include "Engine/World.h"
+#include "WheeledVehicles/FGTargetPoint.h"
 #include "WheeledVehicles/FGTargetPointLinkedList.h"
 
 struct FBVPSegmentColliderInfo
@@ -22,6 +25,13 @@ struct FBVPSegmentColliderInfo
 
 FBVPVehiclePathSegmentVisualization::FBVPVehiclePathSegmentVisualization( FBVPVehiclePathVisualization* InOwner, int32 InSegmentIndex ) : OwnerVisualization( InOwner ), SegmentIndex( InSegmentIndex )
 {
+	fgcheck( OwnerVisualization && OwnerVisualization->GetSubsystem() );
+	StateSlotIndex = OwnerVisualization->GetSubsystem()->AllocateSegmentStateSlot();
+}
+
+FBVPVehiclePathSegmentVisualization::~FBVPVehiclePathSegmentVisualization()
+{
+	OwnerVisualization->GetSubsystem()->ReleaseSegmentStateSlot( StateSlotIndex );
 }
 
 void FBVPVehiclePathSegmentVisualization::AddRemoveVisualizationRequest( bool bRemove )
@@ -32,6 +42,12 @@ void FBVPVehiclePathSegmentVisualization::AddRemoveVisualizationRequest( bool bR
 	if ( ( VisualizationRequestCounter != 0 ) != bWantedVisualizationBefore )
 	{
 		bNeedsVisualizationRebuild = true;
+
+		// Path needs to add or remove this segment from its merged meshes or lines
+		if ( VisualizationLOD != EBVPSegmentVisualizationLOD::Full )
+		{
+			OwnerVisualization->MarkLODRepresentationDirty();
+		}
 	}
 }
 
@@ -46,6 +62,18 @@ void FBVPVehiclePathSegmentVisualization::AddRemoveCollisionRequest( bool bRemov
 	}
 }
 
+bool FBVPVehiclePathSegmentVisualization::SetSegmentPathNodes( AFGTargetPoint* InStartPathNode, AFGTargetPoint* InEndPathNode )
+{
+	const bool bStartPathNodeChanged = StartPathNode.Get() != InStartPathNode;
+	StartPathNode = InStartPathNode;
+	EndPathNode = InEndPathNode;
+
+	// Target speeds do not affect the geometry, so they are refreshed separately
+	SegmentMetrics.StartTargetSpeed = InStartPathNode ? InStartPathNode->GetTargetSpeed() : 0;
+	SegmentMetrics.EndTargetSpeed = InEndPathNode ? InEndPathNode->GetTargetSpeed() : 0;
+	return bStartPathNodeChanged;
+}
+
 void FBVPVehiclePathSegmentVisualization::UpdateSegmentWithNewSpline()
 {
 	const USplineComponent* SplineComponent = OwnerVisualization->GetTargetList()->GetPath();
@@ -72,11 +100,71 @@ void FBVPVehiclePathSegmentVisualization::UpdateSegmentWithNewSpline()
 		LeaveLocation = NewLeaveLocation;
 		LeaveTangent = NewLeaveTangent;
 
+		// The hermite curve is equivalent to a bezier curve with these control points, and is contained within their convex hull
+		const FVector BezierControlPoints[] { ArriveLocation, ArriveLocation + ArriveTangent / 3.0f, LeaveLocation - LeaveTangent / 3.0f, LeaveLocation };
+		SegmentBounds = FBox( BezierControlPoints, UE_ARRAY_COUNT( BezierControlPoints ) );
+		UpdateSegmentGeometryMetrics();
+		OwnerVisualization->IncrementGeometryGeneration();
+
 		bNeedsVisualizationRebuild |= VisualizationRequestCounter != 0;
 		bNeedsCollisionRebuild |= CollisionRequestCounter != 0;
+
+		if ( VisualizationRequestCounter != 0 && VisualizationLOD != EBVPSegmentVisualizationLOD::Full )
+		{
+			OwnerVisualization->MarkLODRepresentationDirty();
+		}
+	}
+}
+
+void FBVPVehiclePathSegmentVisualization::ReportObserverDistance( double ObserverDistance )
+{
+	ClosestObserverDistance = FMath::Min( ClosestObserverDistance, ObserverDistance );
+}
+
+void FBVPVehiclePathSegmentVisualization::UpdateVisualizationLOD()
+{
+	const double ObserverDistance = ClosestObserverDistance;
+	ClosestObserverDistance = UE_BIG_NUMBER;
+
+	// Segments that are not visualized keep their current LOD to avoid rebuilding the path LOD representation for no reason
+	if ( VisualizationRequestCounter == 0 )
+	{
+		return;
+	}
+	const UBVPSettings* BVPSettings = UBVPSettings::Get();
+	const float LODHysteresis = FMath::Max( BVPSettings->PathVisualizationRelevanceHysteresis, 0.0f );
+
+	// Switching to a coarser LOD requires the observer to move past the LOD distance by the hysteresis, switching to a finer one does not
+	const double MergedLODDistance = BVPSettings->PathVisualizationMergedLODDistance + ( VisualizationLOD < EBVPSegmentVisualizationLOD::Merged ? LODHysteresis : 0.0f );
+	const double LineLODDistance = BVPSettings->PathVisualizationLineLODDistance + ( VisualizationLOD < EBVPSegmentVisualizationLOD::Line ? LODHysteresis : 0.0f );
+
+	EBVPSegmentVisualizationLOD NewVisualizationLOD = EBVPSegmentVisualizationLOD::Full;
+	if ( ObserverDistance >= LineLODDistance )
+	{
+		NewVisualizationLOD = EBVPSegmentVisualizationLOD::Line;
+	}
+	else if ( ObserverDistance >= MergedLODDistance )
+	{
+		NewVisualizationLOD = EBVPSegmentVisualizationLOD::Merged;
+	}
+
+	if ( NewVisualizationLOD != VisualizationLOD )
+	{
+		VisualizationLOD = NewVisualizationLOD;
+		bNeedsVisualizationRebuild = true;
+		OwnerVisualization->MarkLODRepresentationDirty();
 	}
 }
 
+bool FBVPVehiclePathSegmentVisualization::IsSegmentNearlyStraight( float MaxAngleDegrees ) const
+{
+	const FVector ChordDirection = ( LeaveLocation - ArriveLocation ).GetSafeNormal();
+	const double MinDotProduct = FMath::Cos( FMath::DegreesToRadians( MaxAngleDegrees ) );
+
+	return FVector::DotProduct( ArriveTangent.GetSafeNormal(), ChordDirection ) >= MinDotProduct &&
+		FVector::DotProduct( LeaveTangent.GetSafeNormal(), ChordDirection ) >= MinDotProduct;
+}
+
 bool FBVPVehiclePathSegmentVisualization::IsSegmentUpToDate() const
 {
 	return !bNeedsVisualizationRebuild && !bNeedsCollisionRebuild;
@@ -88,6 +176,77 @@ bool FBVPVehiclePathSegmentVisualization::IsSegmentRelevantForObserver( const FV
 		FVector::Distance( LeaveLocation, ObserverLocation ) <= RelevanceDistance;
 }
 
+void FBVPVehiclePathSegmentVisualization::GetRelevanceData( FBVPSegmentRelevanceData& OutRelevanceData ) const
+{
+	FVector BoundsExtent;
+	SegmentBounds.GetCenterAndExtents( OutRelevanceData.BoundsCenter, BoundsExtent );
+
+	OutRelevanceData.ArriveLocation = ArriveLocation;
+	OutRelevanceData.LeaveLocation = LeaveLocation;
+	OutRelevanceData.BoundsRadius = BoundsExtent.Size();
+	OutRelevanceData.Bounds = SegmentBounds;
+	OutRelevanceData.StateSlotIndex = StateSlotIndex;
+}
+
+void FBVPVehiclePathSegmentVisualization::SetSegmentColorOverride( const TOptional<FLinearColor>& NewColorOverride )
+{
+	if ( ColorOverride != NewColorOverride )
+	{
+		ColorOverride = NewColorOverride;
+		bNeedsVisualizationRebuild |= VisualizationComponent.IsValid();
+
+		// Line LOD segments are drawn by the path with their segment color
+		if ( VisualizationRequestCounter != 0 && VisualizationLOD == EBVPSegmentVisualizationLOD::Line )
+		{
+			OwnerVisualization->MarkLODRepresentationDirty();
+		}
+	}
+}
+
+FLinearColor FBVPVehiclePathSegmentVisualization::GetSegmentColor() const
+{
+	return ColorOverride.IsSet() ? ColorOverride.GetValue() : OwnerVisualization->GetPathColor();
+}
+
+void FBVPVehiclePathSegmentVisualization::AppendSegmentLines( TArray<FBatchedLine>& OutLines, const FLinearColor& LineColor, int32 NumLines, float LineThickness ) const
+{
+	TArray<FVector, TInlineAllocator<16>> SampleLocations;
+	SampleLocations.SetNumUninitialized( FMath::Max( NumLines, 1 ) + 1 );
+
+	TArray<double, TInlineAllocator<16>> SampleAlphas;
+	SampleAlphas.SetNumUninitialized( SampleLocations.Num() );
+	for ( int32 SampleIndex = 0; SampleIndex < SampleAlphas.Num(); SampleIndex++ )
+	{
+		SampleAlphas[SampleIndex] = (double) SampleIndex / ( SampleAlphas.Num() - 1 );
+	}
+	GetHermiteSegment().EvaluateBatch( SampleAlphas, SampleLocations, TArrayView<FVector>() );
+
+	for ( int32 SampleIndex = 1; SampleIndex < SampleLocations.Num(); SampleIndex++ )
+	{
+		OutLines.Emplace( SampleLocations[SampleIndex - 1], SampleLocations[SampleIndex], LineColor, -1.0f, LineThickness, SDPG_World );
+	}
+}
+
+float FBVPVehiclePathSegmentVisualization::GetSplineInputKeyAtAlpha( double Alpha ) const
+{
+	const USplineComponent* SplineComponent = OwnerVisualization->GetTargetList()->GetPath();
+	fgcheck( SplineComponent );
+
+	int32 StartSplinePoint = INDEX_NONE, EndSplinePoint = INDEX_NONE;
+	GetSplinePointsForSegment( StartSplinePoint, EndSplinePoint );
+
+	// The last segment wraps around from the last node to the first one. The spline has no points past its end, but the same curve is
+	// represented by the backtrack points at its start, the last of which is a copy of the last node followed by the first node
+	if ( EndSplinePoint <= StartSplinePoint )
+	{
+		StartSplinePoint = UBVPSubsystem::NumBacktrackSplinePoints - 1;
+		EndSplinePoint = UBVPSubsystem::NumBacktrackSplinePoints;
+	}
+	const float StartKey = SplineComponent->SplineCurves.Position.Points[ StartSplinePoint ].InVal;
+	const float EndKey = SplineComponent->SplineCurves.Position.Points[ EndSplinePoint ].InVal;
+	return StartKey + Alpha * ( EndKey - StartKey );
+}
+
 void FBVPVehiclePathSegmentVisualization::UpdateSegment()
 {
 	if ( OwnerVisualization->GetTargetList()->GetPath() )
@@ -102,33 +261,23 @@ void FBVPVehiclePathSegmentVisualization::UpdateSegment()
 		{
 			ForceUpdateCollision();
 		}
+		UpdateHibernationState();
 	}
 }
 
 void FBVPVehiclePathSegmentVisualization::DestroySegment()
 {
-	if ( VisualizationComponent )
-	{
-		VisualizationComponent->DestroyComponent();
-		VisualizationComponent = nullptr;
-		bNeedsVisualizationRebuild = true;
-	}
-	
-	if ( !CollisionComponents.IsEmpty() )
-	{
-		for ( UBoxComponent* BoxComponent : CollisionComponents )
-		{
-			fgcheck( BoxComponent );
-			BoxComponent->DestroyComponent();
-		}
-		CollisionComponents.Empty();
-		bNeedsCollisionRebuild = true;
-	}
+	DestroySegmentComponents();
 
 	if ( OwnerVisualization != nullptr )
 	{
-		if ( const UBVPSubsystem* OwnerSubsystem = OwnerVisualization->GetSubsystem() )
+		if ( UBVPSubsystem* OwnerSubsystem = OwnerVisualization->GetSubsystem() )
 		{
+			if ( IsSegmentHibernated() )
+			{
+				OwnerSubsystem->RemoveHibernatedSegment( this );
+				HibernationStartTime = -1.0;
+			}
 			for ( FBVPPlayerVisualizationTracker* VisualizationTracker : OwnerSubsystem->GetAllPlayerTrackers() )
 			{
 				fgcheck( VisualizationTracker );
@@ -138,35 +287,88 @@ void FBVPVehiclePathSegmentVisualization::DestroySegment()
 	}
 }
 
-void FBVPVehiclePathSegmentVisualization::AddReferencedObjects( FReferenceCollector& ReferenceCollector )
+int32 FBVPVehiclePathSegmentVisualization::GetNumSegmentComponents() const
 {
-	ReferenceCollector.AddReferencedObject( VisualizationComponent );
-	ReferenceCollector.AddReferencedObjects( CollisionComponents );
+	return ( VisualizationComponent.IsValid() ? 1 : 0 ) + CollisionComponents.Num();
+}
+
+void FBVPVehiclePathSegmentVisualization::ReleaseHibernatedComponents()
+{
+	// The subsystem has already dropped us from the hibernated segment list at this point
+	fgcheck( IsSegmentHibernated() );
+	HibernationStartTime = -1.0;
+
+	DestroySegmentComponents();
+	bNeedsVisualizationRebuild = false;
+	bNeedsCollisionRebuild = false;
+}
+
+void FBVPVehiclePathSegmentVisualization::DestroySegmentComponents()
+{
+	if ( VisualizationComponent.IsValid() )
+	{
+		OwnerVisualization->DestroyVisualizationComponent( VisualizationComponent.Get() );
+		VisualizationComponent.Reset();
+		bNeedsVisualizationRebuild = true;
+	}
+	
+	if ( !CollisionComponents.IsEmpty() )
+	{
+		for ( const TWeakObjectPtr<UBoxComponent>& BoxComponent : CollisionComponents )
+		{
+			OwnerVisualization->DestroyVisualizationComponent( BoxComponent.Get() );
+		}
+		CollisionComponents.Empty();
+		bNeedsCollisionRebuild = true;
+	}
+}
+
+void FBVPVehiclePathSegmentVisualization::UpdateHibernationState()
+{
+	UBVPSubsystem* OwnerSubsystem = OwnerVisualization->GetSubsystem();
+	fgcheck( OwnerSubsystem );
+
+	// Segments without any requests keep their hidden components around for a while in case they become relevant again
+	const bool bWantsHibernation = VisualizationRequestCounter == 0 && CollisionRequestCounter == 0 && GetNumSegmentComponents() != 0;
+
+	if ( bWantsHibernation && !IsSegmentHibernated() )
+	{
+		HibernationStartTime = OwnerSubsystem->GetWorld()->GetRealTimeSeconds();
+		NumHibernatedComponents = GetNumSegmentComponents();
+		OwnerSubsystem->AddHibernatedSegment( this );
+	}
+	else if ( !bWantsHibernation && IsSegmentHibernated() )
+	{
+		OwnerSubsystem->RemoveHibernatedSegment( this );
+		HibernationStartTime = -1.0;
+	}
 }
 
 void FBVPVehiclePathSegmentVisualization::ForceUpdateVisualization()
 {
-	const bool bWantsVisualization = VisualizationRequestCounter != 0;
-	if ( !VisualizationComponent && bWantsVisualization )
+	// Coarser LODs are rendered by the owning path, so the segment only needs its own mesh at the full LOD
+	const bool bWantsVisualization = VisualizationRequestCounter != 0 && VisualizationLOD == EBVPSegmentVisualizationLOD::Full;
+	USplineMeshComponent* SplineMeshComponent = VisualizationComponent.Get();
+	if ( !SplineMeshComponent && bWantsVisualization )
 	{
 		fgcheck( OwnerVisualization->GetTargetList() );
 
-		VisualizationComponent = NewObject<USplineMeshComponent>( OwnerVisualization->GetVisualizationActor(), NAME_None, RF_Transient );
-		VisualizationComponent->SetupAttachment( OwnerVisualization->GetVisualizationActor()->GetRootComponent() );
-		VisualizationComponent->SetMobility( EComponentMobility::Movable );
+		SplineMeshComponent = OwnerVisualization->GetVisualizationActor()->CreateVisualizationComponent<USplineMeshComponent>();
+		SplineMeshComponent->SetMobility( EComponentMobility::Movable );
 
-		VisualizationComponent->SetCollisionEnabled( ECollisionEnabled::NoCollision );
-		VisualizationComponent->SetStaticMesh( OwnerVisualization->GetSubsystem()->PathVisualizationMesh );
-		VisualizationComponent->SetMaterial( 0, OwnerVisualization->GetOrCreateMaterialInstance() );
+		SplineMeshComponent->SetCollisionEnabled( ECollisionEnabled::NoCollision );
+		SplineMeshComponent->SetStaticMesh( OwnerVisualization->GetSubsystem()->PathVisualizationMesh );
 
-		VisualizationComponent->SetStartAndEnd( ArriveLocation, ArriveTangent, LeaveLocation, LeaveTangent );
-		VisualizationComponent->RegisterComponent();
+		SplineMeshComponent->SetStartAndEnd( ArriveLocation, ArriveTangent, LeaveLocation, LeaveTangent );
+		SplineMeshComponent->RegisterComponent();
+		VisualizationComponent = SplineMeshComponent;
 	}
 
-	if ( VisualizationComponent )
+	if ( SplineMeshComponent )
 	{
-		VisualizationComponent->SetStartAndEnd( ArriveLocation, ArriveTangent, LeaveLocation, LeaveTangent );
-		VisualizationComponent->SetVisibility( bWantsVisualization );
+		OwnerVisualization->ApplyVisualizationMaterial( SplineMeshComponent, GetSegmentColor() );
+		SplineMeshComponent->SetStartAndEnd( ArriveLocation, ArriveTangent, LeaveLocation, LeaveTangent );
+		SplineMeshComponent->SetVisibility( bWantsVisualization );
 	}
 	bNeedsVisualizationRebuild = false;
 }
@@ -176,11 +378,24 @@ void FBVPVehiclePathSegmentVisualization::ForceUpdateCollision()
 	const UBVPSettings* BVPSettings = UBVPSettings::Get();
 	const float CollisionThickness = BVPSettings->PathVisualizationCollisionThickness;
 
+	// Drop the handles to the colliders that have been destroyed together with the actor
+	CollisionComponents.RemoveAll( []( const TWeakObjectPtr<UBoxComponent>& BoxComponent ) { return !BoxComponent.IsValid(); } );
+
+	// Segments that no longer want collision keep their colliders with the collision disabled until they are released by hibernation
+	if ( CollisionRequestCounter == 0 )
+	{
+		for ( const TWeakObjectPtr<UBoxComponent>& BoxComponent : CollisionComponents )
+		{
+			BoxComponent->SetCollisionEnabled( ECollisionEnabled::NoCollision );
+		}
+		bNeedsCollisionRebuild = false;
+		return;
+	}
+
 	// First fetch info from the already spawned colliders
 	TArray<FBVPSegmentColliderInfo> SegmentColliders;
-	for ( const UBoxComponent* BoxComponent : CollisionComponents )
+	for ( const TWeakObjectPtr<UBoxComponent>& BoxComponent : CollisionComponents )
 	{
-		fgcheck( BoxComponent );
 		FBVPSegmentColliderInfo& NewCollider = SegmentColliders.AddDefaulted_GetRef();
 
 		NewCollider.ColliderLocation = BoxComponent->GetComponentLocation();
@@ -188,15 +403,7 @@ void FBVPVehiclePathSegmentVisualization::ForceUpdateCollision()
 		NewCollider.ColliderLength = BoxComponent->GetScaledBoxExtent().X * 2.0f;
 	}
 
-	// Only build the collision segments if we actually want them
-	if ( CollisionRequestCounter != 0 )
-	{
-		RebuildCollidersForSpline( SegmentColliders );
-	}
-	else
-	{
-		SegmentColliders.Empty();
-	}
+	RebuildCollidersForSpline( SegmentColliders );
 	
 	// Spawn new colliders (or remove existing ones)
 	if ( SegmentColliders.Num() != CollisionComponents.Num() )
@@ -204,17 +411,14 @@ void FBVPVehiclePathSegmentVisualization::ForceUpdateCollision()
 		// Remove extra colliders that we do not need
 		for ( int32 i = CollisionComponents.Num() - 1; i >= SegmentColliders.Num(); i-- )
 		{
-			fgcheck( CollisionComponents[i] );
-			CollisionComponents[i]->DestroyComponent();
-
+			OwnerVisualization->DestroyVisualizationComponent( CollisionComponents[i].Get() );
 			CollisionComponents.RemoveAt( i );
 		}
 		
 		// Spawn extra colliders
 		for ( int32 i = CollisionComponents.Num(); i < SegmentColliders.Num(); i++ )
 		{
-			UBoxComponent* BoxComponent = NewObject<UBoxComponent>( OwnerVisualization->GetVisualizationActor(), NAME_None, RF_Transient );
-			BoxComponent->SetupAttachment( OwnerVisualization->GetVisualizationActor()->GetRootComponent() );
+			UBoxComponent* BoxComponent = OwnerVisualization->GetVisualizationActor()->CreateVisualizationComponent<UBoxComponent>();
 			BoxComponent->SetMobility( EComponentMobility::Movable );
 			
 			BoxComponent->SetWorldLocationAndRotation( SegmentColliders[i].ColliderLocation, SegmentColliders[i].ColliderDirection.Rotation() );
@@ -226,6 +430,7 @@ void FBVPVehiclePathSegmentVisualization::ForceUpdateCollision()
 			CollisionResponseContainer.SetResponse( ECC_GameTraceChannel13, ECR_Overlap );
 				
 			BoxComponent->SetCollisionResponseToChannels( CollisionResponseContainer );
+			BoxComponent->SetCollisionEnabled( ECollisionEnabled::QueryOnly );
 			BoxComponent->RegisterComponent();
 
 			CollisionComponents.Add( BoxComponent );
@@ -235,7 +440,7 @@ void FBVPVehiclePathSegmentVisualization::ForceUpdateCollision()
 	// Update existing colliders
 	for ( int32 i = 0; i < SegmentColliders.Num(); i++ )
 	{
-		UBoxComponent* BoxComponent = CollisionComponents[i];
+		UBoxComponent* BoxComponent = CollisionComponents[i].Get();
 		fgcheck( BoxComponent );
 
 		const FBVPSegmentColliderInfo& ColliderInfo = SegmentColliders[i];
@@ -245,6 +450,12 @@ void FBVPVehiclePathSegmentVisualization::ForceUpdateCollision()
 			const FVector BoxExtent = BoxComponent->GetUnscaledBoxExtent();
 			BoxComponent->SetBoxExtent( FVector( ColliderInfo.ColliderLength / 2.0f, BoxExtent.Y, BoxExtent.Z ) );
 		}
+
+		// Colliders woken up from hibernation have their collision disabled
+		if ( BoxComponent->GetCollisionEnabled() == ECollisionEnabled::NoCollision )
+		{
+			BoxComponent->SetCollisionEnabled( ECollisionEnabled::QueryOnly );
+		}
 	}
 	bNeedsCollisionRebuild = false;
 }
@@ -255,36 +466,29 @@ void FBVPVehiclePathSegmentVisualization::RebuildCollidersForSpline( TArray<FBVP
 	const float CollisionStep = BVPSettings->PathVisualizationCollisionStep;
 	const float MaxAngleDiff = BVPSettings->PathVisualizationCollisionMaximumAngleDifference;
 
-	USplineComponent* SplineComponent = OwnerVisualization->GetTargetList()->GetPath();
-	fgcheck( SplineComponent );
-	
-	int32 StartSplinePoint = INDEX_NONE, EndSplinePoint = INDEX_NONE;
-	GetSplinePointsForSegment( StartSplinePoint, EndSplinePoint );
-
-	SplineComponent->UpdateSpline();
+	// Sample the whole segment in one go using the cached hermite data instead of querying the spline component for every sample
+	const FBVPHermiteSegment HermiteSegment = GetHermiteSegment();
+	const double SegmentLengthDistance = SegmentMetrics.ArcLength;
+	const int32 NumSteps = FMath::Max( FMath::CeilToInt( SegmentLengthDistance / CollisionStep ), 1 );
 
-	const float StartProgress = SplineComponent->SplineCurves.Position.Points[ StartSplinePoint ].InVal;
-	const float EndProgress = SplineComponent->SplineCurves.Position.Points[ EndSplinePoint ].InVal;
-	const float SegmentLengthDistance = FMath::Abs( SplineComponent->GetDistanceAlongSplineAtSplineInputKey( EndProgress ) - SplineComponent->GetDistanceAlongSplineAtSplineInputKey( StartProgress ) );
+	TArray<FVector> SampleLocations, SampleDirections;
+	HermiteSegment.EvaluateUniform( NumSteps, SampleLocations, &SampleDirections );
 	
-	float CurrentProgressAlongSpline = StartProgress;
-	FVector CurrentDirectionAlongSpline = SplineComponent->GetDirectionAtSplineInputKey( CurrentProgressAlongSpline, ESplineCoordinateSpace::World );
-	FVector CurrentLocationAlongSpline = SplineComponent->GetLocationAtSplineInputKey( CurrentProgressAlongSpline, ESplineCoordinateSpace::World );
+	FVector CurrentDirectionAlongSpline = SampleDirections[0].GetSafeNormal();
+	FVector CurrentLocationAlongSpline = SampleLocations[0];
 	int32 CurrentSegmentIndex = 0;
 
 	constexpr float LocationTolerance = 1.0f;
 	constexpr float DirectionTolerance = 0.01f;
 	constexpr float LengthTolerance = 1.0f;
 
-	const float ProgressIncrementMax = ( EndProgress - StartProgress ) / ( SegmentLengthDistance / CollisionStep );
-	while ( CurrentProgressAlongSpline < EndProgress )
+	for ( int32 SampleIndex = 1; SampleIndex <= NumSteps; SampleIndex++ )
 	{
-		const float ProgressIncrement = FMath::Min( ProgressIncrementMax, EndProgress - CurrentProgressAlongSpline );
-		const FVector NextDistanceAlongSpline = SplineComponent->GetDirectionAtSplineInputKey( CurrentProgressAlongSpline + ProgressIncrement, ESplineCoordinateSpace::World );
-		const FVector NextLocationAlongSpline = SplineComponent->GetLocationAtSplineInputKey( CurrentProgressAlongSpline + ProgressIncrement, ESplineCoordinateSpace::World );
+		const FVector NextDirectionAlongSpline = SampleDirections[SampleIndex].GetSafeNormal();
+		const FVector& NextLocationAlongSpline = SampleLocations[SampleIndex];
 
-		const float AngleDifFromPrev = FMath::RadiansToDegrees( FMath::Acos( FVector::DotProduct( CurrentDirectionAlongSpline, NextDistanceAlongSpline ) ) );
-		if ( AngleDifFromPrev >= MaxAngleDiff || CurrentProgressAlongSpline + ProgressIncrement >= EndProgress )
+		const float AngleDifFromPrev = FMath::RadiansToDegrees( FMath::Acos( FMath::Clamp( FVector::DotProduct( CurrentDirectionAlongSpline, NextDirectionAlongSpline ), -1.0, 1.0 ) ) );
+		if ( AngleDifFromPrev >= MaxAngleDiff || SampleIndex == NumSteps )
 		{
 			FBVPSegmentColliderInfo& ColliderInfo = ColliderList.IsValidIndex( CurrentSegmentIndex ) ? ColliderList[CurrentSegmentIndex] :
 				ColliderList.AddDefaulted_GetRef();
@@ -302,15 +506,59 @@ void FBVPVehiclePathSegmentVisualization::RebuildCollidersForSpline( TArray<FBVP
 				ColliderInfo.bNeedsUpdate = true;
 			}
 
-			CurrentDirectionAlongSpline = NextDistanceAlongSpline;
+			CurrentDirectionAlongSpline = NextDirectionAlongSpline;
 			CurrentLocationAlongSpline = NextLocationAlongSpline;
 			CurrentSegmentIndex++;
 		}
-		CurrentProgressAlongSpline += ProgressIncrement;
 	}
 	ColliderList.RemoveAt( CurrentSegmentIndex, ColliderList.Num() - CurrentSegmentIndex );
 }
 
+void FBVPVehiclePathSegmentVisualization::UpdateSegmentGeometryMetrics()
+{
+	constexpr int32 NumMetricsSamples = 16;
+	const FBVPHermiteSegment HermiteSegment = GetHermiteSegment();
+
+	TArray<FVector> SampleLocations, SampleDerivatives;
+	HermiteSegment.EvaluateUniform( NumMetricsSamples, SampleLocations, &SampleDerivatives );
+
+	double ArcLength = 0.0, MaxCurvature = 0.0;
+	double MinGrade = UE_BIG_NUMBER, MaxGrade = -UE_BIG_NUMBER;
+
+	for ( int32 SampleIndex = 0; SampleIndex <= NumMetricsSamples; SampleIndex++ )
+	{
+		const FVector& Derivative = SampleDerivatives[SampleIndex];
+		const double DerivativeSize = Derivative.Size();
+
+		if ( SampleIndex != 0 )
+		{
+			ArcLength += FVector::Distance( SampleLocations[SampleIndex - 1], SampleLocations[SampleIndex] );
+		}
+		if ( DerivativeSize > UE_KINDA_SMALL_NUMBER )
+		{
+			// Curvature of a parametric curve is |P' x P''| / |P'|^3, converted from 1/cm to 1/m
+			const FVector SecondDerivative = HermiteSegment.EvaluateSecondDerivative( (double) SampleIndex / NumMetricsSamples );
+			const double Curvature = FVector::CrossProduct( Derivative, SecondDerivative ).Size() / FMath::Pow( DerivativeSize, 3.0 );
+			MaxCurvature = FMath::Max( MaxCurvature, Curvature / FBVPSpeedProfile::CentimetersToMeters );
+
+			const double Grade = Derivative.Z / DerivativeSize;
+			MinGrade = FMath::Min( MinGrade, Grade );
+			MaxGrade = FMath::Max( MaxGrade, Grade );
+		}
+	}
+
+	// Degenerate segments have no direction to measure the grade in
+	if ( MinGrade > MaxGrade )
+	{
+		MinGrade = MaxGrade = 0.0;
+	}
+	SegmentMetrics.ArcLength = ArcLength;
+	SegmentMetrics.MaxCurvature = MaxCurvature;
+	SegmentMetrics.MinGrade = MinGrade;
+	SegmentMetrics.MaxGrade = MaxGrade;
+	SegmentMetrics.Bounds = FBox( SampleLocations );
+}
+
 void FBVPVehiclePathSegmentVisualization::GetSplinePointsForSegment( int32& OutStartPoint, int32& OutEndPoint ) const
 {
 	const USplineComponent* SplineComponent = OwnerVisualization->GetTargetList()->GetPath();
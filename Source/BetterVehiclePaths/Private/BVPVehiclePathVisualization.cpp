@@ -6,15 +6,22 @@
 #include "BVPSettings.h"
 #include "BVPSubsystem.h"
 #include "BVPVehiclePathSegmentVisualization.h"
+#include "Components/LineBatchComponent.h"
+#include "Components/SplineMeshComponent.h"
 #include "Engine/World.h"
-#include "Materials/MaterialInstanceDynamic.h"
 #include "WheeledVehicles/FGTargetPoint.h"
 #include "WheeledVehicles/FGTargetPointLinkedList.h"
 
-FBVPVehiclePathVisualization::FBVPVehiclePathVisualization( UBVPSubsystem* InSubsystem, AFGDrivingTargetList* InTargetList ) : OwnerSubsystem( InSubsystem ), TargetPointList( InTargetList )
+FBVPVehiclePathVisualization::FBVPVehiclePathVisualization( UBVPSubsystem* InSubsystem, AFGDrivingTargetList* InTargetList ) : OwnerSubsystem( InSubsystem ), TargetPointList( InTargetList ), TargetListKey( InTargetList )
 {
 	fgcheck( OwnerSubsystem );
-	fgcheck( TargetPointList );
+	fgcheck( InTargetList );
+
+	// Use the hash of the target point name here as it gives results consistent between game restarts
+	const FRandomStream RandomStream( (int32) GetTypeHash( InTargetList->GetName() ) );
+
+	// Only randomize hue to avoid randomized colors appearing more bleak
+	PathColor = FLinearColor( RandomStream.GetFraction(), 0.9f, 0.5f ).HSVToLinearRGB();
 }
 
 FBVPVehiclePathVisualization::~FBVPVehiclePathVisualization()
@@ -26,37 +33,63 @@ FBVPVehiclePathVisualization::~FBVPVehiclePathVisualization()
 	VisualizationSegments.Empty();
 }
 
-AActor* FBVPVehiclePathVisualization::GetVisualizationActor()
+ABVPPathVisualizationActor* FBVPVehiclePathVisualization::GetVisualizationActor()
 {
-	if ( !VisualizationActor )
+	if ( !VisualizationActor.IsValid() )
 	{
+		AFGDrivingTargetList* TargetList = TargetPointList.Get();
+		fgcheck( TargetList );
+
 		FActorSpawnParameters SpawnParameters{};
-		SpawnParameters.Name = *FString::Printf( TEXT("VisualizationActor_%s"), *TargetPointList->GetName() );
+		SpawnParameters.Name = *FString::Printf( TEXT("VisualizationActor_%s"), *TargetList->GetName() );
 		SpawnParameters.NameMode = FActorSpawnParameters::ESpawnActorNameMode::Requested;
-		SpawnParameters.Owner = TargetPointList;
+		SpawnParameters.Owner = TargetList;
 		
 		ABVPPathVisualizationActor* SpawnedActor = OwnerSubsystem->GetWorld()->SpawnActor<ABVPPathVisualizationActor>( SpawnParameters );
-		SpawnedActor->OwnerTargetList = TargetPointList;
+		SpawnedActor->OwnerTargetList = TargetList;
 		VisualizationActor = SpawnedActor;
 	}
-	return VisualizationActor;
+	return VisualizationActor.Get();
+}
+
+int32 FBVPVehiclePathVisualization::GetNumVisualizationComponents() const
+{
+	const ABVPPathVisualizationActor* Actor = VisualizationActor.Get();
+	return Actor ? Actor->GetNumVisualizationComponents() : 0;
 }
 
-UMaterialInterface* FBVPVehiclePathVisualization::GetOrCreateMaterialInstance()
+void FBVPVehiclePathVisualization::DestroyVisualizationComponent( UPrimitiveComponent* Component ) const
 {
-	if ( !MaterialInstance && OwnerSubsystem )
+	if ( ABVPPathVisualizationActor* Actor = VisualizationActor.Get() )
+	{
+		Actor->DestroyVisualizationComponent( Component );
+	}
+	else if ( IsValid( Component ) )
 	{
-		const UBVPSettings* BVPSettings = UBVPSettings::Get();
-		MaterialInstance = UMaterialInstanceDynamic::Create( OwnerSubsystem->PathVisualizationMaterial, OwnerSubsystem );
+		Component->DestroyComponent();
+	}
+}
 
-		// Use the hash of the target point name here as it gives results consistent between game restarts
-		const FRandomStream RandomStream( (int32) GetTypeHash( TargetPointList->GetName() ) );
+void FBVPVehiclePathVisualization::ApplyVisualizationMaterial( UPrimitiveComponent* PrimitiveComponent, const FLinearColor& Color ) const
+{
+	fgcheck( PrimitiveComponent );
+	const UBVPSettings* BVPSettings = UBVPSettings::Get();
 
-		// Only randomize hue to avoid randomized colors appearing more bleak
-		const FLinearColor LinearColor = FLinearColor( RandomStream.GetFraction(), 0.9f, 0.5f ).HSVToLinearRGB();
-		MaterialInstance->SetVectorParameterValue( BVPSettings->PathVisualizationColorParameterName, LinearColor );
+	// Materials that do not read the custom primitive data fall back to a material instance per color
+	UMaterialInterface* Material = OwnerSubsystem->PathVisualizationMaterial;
+	if ( !BVPSettings->bPathVisualizationMaterialUsesCustomData )
+	{
+		Material = OwnerSubsystem->GetPathVisualizationMaterialInstance( Color );
+	}
+
+	if ( PrimitiveComponent->GetMaterial( 0 ) != Material )
+	{
+		PrimitiveComponent->SetMaterial( 0, Material );
+	}
+	if ( BVPSettings->bPathVisualizationMaterialUsesCustomData )
+	{
+		PrimitiveComponent->SetCustomPrimitiveDataVector4( BVPSettings->PathVisualizationColorCustomDataIndex, FVector4( Color ) );
 	}
-	return MaterialInstance;
 }
 
 FBVPVehiclePathSegmentVisualization* FBVPVehiclePathVisualization::FindSegmentByIndex( int32 SegmentIndex ) const
@@ -64,34 +97,46 @@ FBVPVehiclePathSegmentVisualization* FBVPVehiclePathVisualization::FindSegmentBy
 	return VisualizationSegments.IsValidIndex( SegmentIndex ) ? VisualizationSegments[SegmentIndex] : nullptr;
 }
 
-FBVPVehiclePathSegmentVisualization* FBVPVehiclePathVisualization::FindSegmentByStartPathNode( const AFGTargetPoint* InPathNodeAfter ) const
+FBVPVehiclePathSegmentVisualization* FBVPVehiclePathVisualization::FindSegmentByStartPathNode( TObjectKey<AFGTargetPoint> InPathNodeAfter ) const
+{
+	FBVPVehiclePathSegmentVisualization* const* SegmentVisualization = SegmentsByStartPathNode.Find( InPathNodeAfter );
+	return SegmentVisualization ? *SegmentVisualization : nullptr;
+}
+
+FBVPVehiclePathSegmentVisualization* FBVPVehiclePathVisualization::FindSegmentClosestToLocation( const FVector& Location, double SearchRadius, double& OutAlpha ) const
 {
-	if ( TargetPointList )
+	FBVPVehiclePathSegmentVisualization* ClosestSegment = nullptr;
+	double ClosestDistanceSquared = FMath::Square( SearchRadius );
+
+	for ( FBVPVehiclePathSegmentVisualization* SegmentVisualization : VisualizationSegments )
 	{
-		int32 CurrentNodeIndex = 0;
-		const AFGTargetPoint* CurrentNode = TargetPointList->GetFirstTarget();
+		// Bounds of the segment contain the whole curve, so they can be used to quickly discard segments that are too far away
+		if ( SegmentVisualization->GetSegmentBounds().ComputeSquaredDistanceToPoint( Location ) > ClosestDistanceSquared )
+		{
+			continue;
+		}
+		const FBVPHermiteSegment HermiteSegment = SegmentVisualization->GetHermiteSegment();
+		const double Alpha = HermiteSegment.FindClosestAlpha( Location );
+		const double DistanceSquared = FVector::DistSquared( HermiteSegment.EvaluatePosition( Alpha ), Location );
 
-		while ( CurrentNode != nullptr )
+		if ( DistanceSquared <= ClosestDistanceSquared )
 		{
-			if ( CurrentNode == InPathNodeAfter )
-			{
-				return FindSegmentByIndex( CurrentNodeIndex );
-			}
-			CurrentNode = CurrentNode->GetNext();
-			CurrentNodeIndex++;
+			ClosestSegment = SegmentVisualization;
+			ClosestDistanceSquared = DistanceSquared;
+			OutAlpha = Alpha;
 		}
 	}
-	return nullptr;
+	return ClosestSegment;
 }
 
 bool FBVPVehiclePathVisualization::IsVisualizationValid() const
 {
-	return TargetPointList != nullptr && OwnerSubsystem != nullptr;
+	return TargetPointList.IsValid() && OwnerSubsystem != nullptr;
 }
 
 void FBVPVehiclePathVisualization::UpdateVisualization()
 {
-	if ( TargetPointList )
+	if ( TargetPointList.IsValid() )
 	{
 		// Attempt to fetch the spline component data
 		if ( TargetPointList->GetPath() == nullptr && TargetPointList->IsComplete() )
@@ -112,26 +157,45 @@ void FBVPVehiclePathVisualization::UpdateVisualization()
 		// Build the segments if we have a valid spline component
 		if ( TargetPointList->GetPath() != nullptr )
 		{
-			// Spawn or remove segments as needed
-			if ( TargetPointList->GetTargetCount() != VisualizationSegments.Num() )
+			// Match the segments to the path nodes if nodes have been inserted, removed or moved between the lists
+			bool bSegmentPathNodesChanged = TargetPointList->GetTargetCount() != VisualizationSegments.Num();
+			if ( !bSegmentPathNodesChanged )
 			{
-				// Remove additional segments that are not needed
-				for ( int32 i = VisualizationSegments.Num() - 1; i >= TargetPointList->GetTargetCount(); i-- )
+				const AFGTargetPoint* PathNode = TargetPointList->GetFirstTarget();
+				for ( const FBVPVehiclePathSegmentVisualization* SegmentVisualization : VisualizationSegments )
 				{
-					FBVPVehiclePathSegmentVisualization* SegmentToDelete = VisualizationSegments[i];
-					fgcheck( SegmentToDelete );
-					
-					SegmentToDelete->DestroySegment();
-					delete SegmentToDelete;
-					
-					VisualizationSegments.RemoveAt( i );
+					if ( SegmentVisualization->GetStartPathNode() != PathNode )
+					{
+						bSegmentPathNodesChanged = true;
+						break;
+					}
+					PathNode = PathNode ? PathNode->GetNext() : nullptr;
 				}
+			}
+			if ( bSegmentPathNodesChanged )
+			{
+				ReconcileSegments( TargetPointList->GetTargetCount() );
+			}
 
-				// Spawn new segments for additional target points
-				for ( int32 i = VisualizationSegments.Num(); i < TargetPointList->GetTargetCount(); i++ )
+			// Assign the path nodes to the segments with a single walk of the list. The last segment wraps around to the first node.
+			// This also refreshes the target speeds of the segments, which can change without the nodes changing
+			AFGTargetPoint* SegmentStartNode = TargetPointList->GetFirstTarget();
+			for ( FBVPVehiclePathSegmentVisualization* SegmentVisualization : VisualizationSegments )
+			{
+				AFGTargetPoint* SegmentEndNode = SegmentStartNode && SegmentStartNode->GetNext() ? SegmentStartNode->GetNext() : TargetPointList->GetFirstTarget();
+				SegmentVisualization->SetSegmentPathNodes( SegmentStartNode, SegmentEndNode );
+				SegmentStartNode = SegmentStartNode ? SegmentStartNode->GetNext() : nullptr;
+			}
+
+			if ( bSegmentPathNodesChanged )
+			{
+				SegmentsByStartPathNode.Reset();
+				for ( FBVPVehiclePathSegmentVisualization* SegmentVisualization : VisualizationSegments )
 				{
-					FBVPVehiclePathSegmentVisualization* NewSegment = new FBVPVehiclePathSegmentVisualization( this, i );
-					VisualizationSegments.Add( NewSegment );
+					if ( const AFGTargetPoint* StartPathNode = SegmentVisualization->GetStartPathNode() )
+					{
+						SegmentsByStartPathNode.Add( StartPathNode, SegmentVisualization );
+					}
 				}
 			}
 
@@ -141,11 +205,17 @@ void FBVPVehiclePathVisualization::UpdateVisualization()
 				fgcheck( SegmentVisualization );
 
 				SegmentVisualization->UpdateSegmentWithNewSpline();
+				SegmentVisualization->UpdateVisualizationLOD();
 				if ( !SegmentVisualization->IsSegmentUpToDate() )
 				{
 					SegmentVisualization->UpdateSegment();
 				}
 			}
+
+			if ( bNeedsLODRepresentationRebuild )
+			{
+				RebuildLODRepresentation();
+			}
 		}
 		// Otherwise, kill the existing segments
 		else if ( !VisualizationSegments.IsEmpty() )
@@ -159,6 +229,58 @@ void FBVPVehiclePathVisualization::UpdateVisualization()
 	}
 }
 
+void FBVPVehiclePathVisualization::ReconcileSegments( int32 NumSegments )
+{
+	// Segments that start at the nodes still in the list keep their start node, and everything else is spare
+	TMap<TObjectKey<AFGTargetPoint>, FBVPVehiclePathSegmentVisualization*> UnclaimedSegments = SegmentsByStartPathNode;
+	TArray<FBVPVehiclePathSegmentVisualization*> NewSegments;
+	TSet<FBVPVehiclePathSegmentVisualization*> ClaimedSegments;
+	NewSegments.Reserve( NumSegments );
+
+	const AFGTargetPoint* PathNode = TargetPointList->GetFirstTarget();
+	for ( int32 i = 0; i < NumSegments; i++ )
+	{
+		FBVPVehiclePathSegmentVisualization* ClaimedSegment = nullptr;
+		if ( PathNode )
+		{
+			UnclaimedSegments.RemoveAndCopyValue( TObjectKey<AFGTargetPoint>( PathNode ), ClaimedSegment );
+			ClaimedSegments.Add( ClaimedSegment );
+		}
+		NewSegments.Add( ClaimedSegment );
+		PathNode = PathNode ? PathNode->GetNext() : nullptr;
+	}
+
+	TArray<FBVPVehiclePathSegmentVisualization*> SpareSegments;
+	for ( FBVPVehiclePathSegmentVisualization* SegmentVisualization : VisualizationSegments )
+	{
+		if ( !ClaimedSegments.Contains( SegmentVisualization ) )
+		{
+			SpareSegments.Add( SegmentVisualization );
+		}
+	}
+
+	// Fill the gaps with the spare segments first, then spawn new segments for the rest
+	for ( int32 i = 0; i < NumSegments; i++ )
+	{
+		if ( NewSegments[i] == nullptr )
+		{
+			NewSegments[i] = !SpareSegments.IsEmpty() ? SpareSegments.Pop( false ) : new FBVPVehiclePathSegmentVisualization( this, i );
+		}
+		NewSegments[i]->SetSegmentIndex( i );
+	}
+
+	// Remove additional segments that are not needed
+	for ( FBVPVehiclePathSegmentVisualization* SegmentToDelete : SpareSegments )
+	{
+		SegmentToDelete->DestroySegment();
+		delete SegmentToDelete;
+	}
+
+	VisualizationSegments = MoveTemp( NewSegments );
+	bNeedsLODRepresentationRebuild = true;
+	GeometryGeneration++;
+}
+
 void FBVPVehiclePathVisualization::DestroyVisualization()
 {
 	for ( FBVPVehiclePathSegmentVisualization* SegmentVisualization : VisualizationSegments )
@@ -167,22 +289,239 @@ void FBVPVehiclePathVisualization::DestroyVisualization()
 		SegmentVisualization->DestroySegment();
 	}
 	VisualizationSegments.Empty();
+	SegmentsByStartPathNode.Empty();
+
+	NetworkOverviewLines.Empty();
+	GeometryGeneration++;
+
+	// Components will be destroyed together with the actor
+	MergedRunComponents.Empty();
+	LineBatchComponent.Reset();
+	bNeedsLODRepresentationRebuild = false;
 
-	if ( VisualizationActor != nullptr )
+	if ( ABVPPathVisualizationActor* Actor = VisualizationActor.Get() )
 	{
-		VisualizationActor->Destroy();
-		VisualizationActor = nullptr;
+		Actor->Destroy();
 	}
+	VisualizationActor.Reset();
 }
 
-void FBVPVehiclePathVisualization::AddStructReferencedObjects( FReferenceCollector& Collector )
+bool FBVPVehiclePathVisualization::UpdateNetworkOverviewLines()
 {
-	Collector.AddReferencedObject( OwnerSubsystem );
-	Collector.AddReferencedObject( TargetPointList );
+	if ( NetworkOverviewLinesGeneration == GeometryGeneration )
+	{
+		return false;
+	}
+	const UBVPSettings* BVPSettings = UBVPSettings::Get();
+	const int32 NumLineSamples = FMath::Max( BVPSettings->NetworkOverviewSamplesPerSegment, 1 );
+	const FLinearColor PathColor = GetPathColor();
 
-	for ( FBVPVehiclePathSegmentVisualization* SegmentVisualization : VisualizationSegments )
+	NetworkOverviewLines.Reset( VisualizationSegments.Num() * NumLineSamples );
+	for ( const FBVPVehiclePathSegmentVisualization* SegmentVisualization : VisualizationSegments )
+	{
+		fgcheck( SegmentVisualization );
+		SegmentVisualization->AppendSegmentLines( NetworkOverviewLines, PathColor, NumLineSamples, BVPSettings->NetworkOverviewLineThickness );
+	}
+	NetworkOverviewLinesGeneration = GeometryGeneration;
+	return true;
+}
+
+bool FBVPVehiclePathVisualization::UpdatePathProblems()
+{
+	// Target speeds do not change the geometry generation, but they do change the problems
+	uint32 SpeedChecksum = 0;
+	for ( const FBVPVehiclePathSegmentVisualization* SegmentVisualization : VisualizationSegments )
+	{
+		SpeedChecksum = HashCombine( SpeedChecksum, GetTypeHash( SegmentVisualization->GetSegmentMetrics().StartTargetSpeed ) );
+	}
+	if ( PathProblemsGeneration == GeometryGeneration && PathProblemsSpeedChecksum == SpeedChecksum )
+	{
+		return false;
+	}
+	const UBVPSettings* BVPSettings = UBVPSettings::Get();
+
+	PathProblems.Reset();
+	for ( const FBVPVehiclePathSegmentVisualization* SegmentVisualization : VisualizationSegments )
 	{
 		fgcheck( SegmentVisualization );
-		SegmentVisualization->AddReferencedObjects( Collector );
+		const FBVPPathSegmentMetrics& SegmentMetrics = SegmentVisualization->GetSegmentMetrics();
+
+		const auto AddPathProblem = [&]( EBVPPathProblemType ProblemType, float Value, float Threshold )
+		{
+			FBVPPathProblem& PathProblem = PathProblems.AddDefaulted_GetRef();
+			PathProblem.ProblemType = ProblemType;
+			PathProblem.SegmentStartNode = SegmentVisualization->GetStartPathNode();
+			PathProblem.Location = SegmentMetrics.Bounds.GetCenter();
+			PathProblem.Value = Value;
+			PathProblem.Threshold = Threshold;
+		};
+
+		const float MaxGrade = FMath::Max( FMath::Abs( SegmentMetrics.MinGrade ), FMath::Abs( SegmentMetrics.MaxGrade ) );
+		if ( MaxGrade > BVPSettings->ProblemMaxGrade )
+		{
+			AddPathProblem( EBVPPathProblemType::SteepGrade, MaxGrade, BVPSettings->ProblemMaxGrade );
+		}
+		if ( SegmentMetrics.MaxCurvature > BVPSettings->ProblemMaxCurvature )
+		{
+			AddPathProblem( EBVPPathProblemType::SharpCurve, SegmentMetrics.MaxCurvature, BVPSettings->ProblemMaxCurvature );
+		}
+
+		// Lateral acceleration in a turn is v^2 * curvature. Assume the vehicle drives the sharpest turn at the higher of the endpoint speeds
+		const double MaxSpeed = FMath::Max( SegmentMetrics.StartTargetSpeed, SegmentMetrics.EndTargetSpeed ) / FBVPSpeedProfile::MetersPerSecondToKilometersPerHour;
+		const float LateralAcceleration = FMath::Square( MaxSpeed ) * SegmentMetrics.MaxCurvature;
+		if ( LateralAcceleration > BVPSettings->ProblemMaxLateralAcceleration )
+		{
+			AddPathProblem( EBVPPathProblemType::ExcessiveCurveSpeed, LateralAcceleration, BVPSettings->ProblemMaxLateralAcceleration );
+		}
+	}
+	PathProblemsGeneration = GeometryGeneration;
+	PathProblemsSpeedChecksum = SpeedChecksum;
+	bProblemHighlightDirty = true;
+	return true;
+}
+
+void FBVPVehiclePathVisualization::SetConflictingSegmentStartNodes( TArray<TObjectKey<AFGTargetPoint>>&& NewSegmentStartNodes )
+{
+	if ( ConflictingSegmentStartNodes != NewSegmentStartNodes )
+	{
+		ConflictingSegmentStartNodes = MoveTemp( NewSegmentStartNodes );
+		bProblemHighlightDirty = true;
+	}
+}
+
+void FBVPVehiclePathVisualization::ApplyProblemHighlight( bool bHighlightEnabled, const FLinearColor& ProblemColor, const FLinearColor& ConflictColor )
+{
+	if ( bHighlightEnabled == bProblemHighlightApplied && !bProblemHighlightDirty )
+	{
+		return;
+	}
+
+	// Conflicts take precedence over the problems, since they involve more than one path
+	TArray<TOptional<FLinearColor>> SegmentColors;
+	SegmentColors.SetNum( VisualizationSegments.Num() );
+	if ( bHighlightEnabled )
+	{
+		for ( const FBVPPathProblem& PathProblem : PathProblems )
+		{
+			if ( const FBVPVehiclePathSegmentVisualization* SegmentVisualization = FindSegmentByStartPathNode( PathProblem.SegmentStartNode.Get() ) )
+			{
+				SegmentColors[SegmentVisualization->GetSegmentIndex()] = ProblemColor;
+			}
+		}
+		for ( const TObjectKey<AFGTargetPoint>& SegmentStartNode : ConflictingSegmentStartNodes )
+		{
+			if ( const FBVPVehiclePathSegmentVisualization* SegmentVisualization = FindSegmentByStartPathNode( SegmentStartNode ) )
+			{
+				SegmentColors[SegmentVisualization->GetSegmentIndex()] = ConflictColor;
+			}
+		}
+	}
+
+	for ( int32 SegmentIndex = 0; SegmentIndex < VisualizationSegments.Num(); SegmentIndex++ )
+	{
+		VisualizationSegments[SegmentIndex]->SetSegmentColorOverride( SegmentColors[SegmentIndex] );
+	}
+	bProblemHighlightApplied = bHighlightEnabled;
+	bProblemHighlightDirty = false;
+}
+
+void FBVPVehiclePathVisualization::RebuildLODRepresentation()
+{
+	const UBVPSettings* BVPSettings = UBVPSettings::Get();
+	const int32 MaxMergedSegments = FMath::Max( BVPSettings->PathVisualizationMaxMergedSegments, 1 );
+	const int32 NumLineSamples = FMath::Max( BVPSettings->PathVisualizationLineSamplesPerSegment, 1 );
+	const double MinMergeDotProduct = FMath::Cos( FMath::DegreesToRadians( BVPSettings->PathVisualizationMergeMaxAngle ) );
+	const FLinearColor PathColor = GetPathColor();
+
+	TArray<FBatchedLine> PathLines;
+	int32 NumMergedRuns = 0;
+
+	for ( int32 SegmentIndex = 0; SegmentIndex < VisualizationSegments.Num(); )
+	{
+		const FBVPVehiclePathSegmentVisualization* FirstSegment = VisualizationSegments[SegmentIndex];
+		fgcheck( FirstSegment );
+
+		if ( !FirstSegment->WantsVisualization() || FirstSegment->GetVisualizationLOD() == EBVPSegmentVisualizationLOD::Full )
+		{
+			SegmentIndex++;
+			continue;
+		}
+
+		// Line LOD segments are sampled into the line batch of the path
+		if ( FirstSegment->GetVisualizationLOD() == EBVPSegmentVisualizationLOD::Line )
+		{
+			FirstSegment->AppendSegmentLines( PathLines, FirstSegment->GetSegmentColor(), NumLineSamples, BVPSettings->PathVisualizationLineThickness );
+			SegmentIndex++;
+			continue;
+		}
+
+		// Extend the run of merged segments while they are straight and continue in the same direction as the first one
+		int32 LastSegmentIndex = SegmentIndex;
+		if ( FirstSegment->IsSegmentNearlyStraight( BVPSettings->PathVisualizationMergeMaxAngle ) )
+		{
+			const FVector RunDirection = ( FirstSegment->GetLeaveLocation() - FirstSegment->GetArriveLocation() ).GetSafeNormal();
+
+			while ( LastSegmentIndex + 1 < VisualizationSegments.Num() && LastSegmentIndex + 1 - SegmentIndex < MaxMergedSegments )
+			{
+				const FBVPVehiclePathSegmentVisualization* NextSegment = VisualizationSegments[LastSegmentIndex + 1];
+				const FVector NextSegmentDirection = ( NextSegment->GetLeaveLocation() - NextSegment->GetArriveLocation() ).GetSafeNormal();
+
+				if ( !NextSegment->WantsVisualization() || NextSegment->GetVisualizationLOD() != EBVPSegmentVisualizationLOD::Merged ||
+					!NextSegment->IsSegmentNearlyStraight( BVPSettings->PathVisualizationMergeMaxAngle ) || FVector::DotProduct( RunDirection, NextSegmentDirection ) < MinMergeDotProduct )
+				{
+					break;
+				}
+				LastSegmentIndex++;
+			}
+		}
+		const FBVPVehiclePathSegmentVisualization* LastSegment = VisualizationSegments[LastSegmentIndex];
+
+		// Runs of a single segment keep the original curve, longer runs are straight by definition
+		FVector StartTangent = FirstSegment->GetArriveTangent();
+		FVector EndTangent = LastSegment->GetLeaveTangent();
+		if ( LastSegmentIndex != SegmentIndex )
+		{
+			StartTangent = EndTangent = LastSegment->GetLeaveLocation() - FirstSegment->GetArriveLocation();
+		}
+
+		if ( !MergedRunComponents.IsValidIndex( NumMergedRuns ) || !MergedRunComponents[NumMergedRuns].IsValid() )
+		{
+			USplineMeshComponent* MergedRunComponent = GetVisualizationActor()->CreateVisualizationComponent<USplineMeshComponent>();
+			MergedRunComponent->SetMobility( EComponentMobility::Movable );
+
+			MergedRunComponent->SetCollisionEnabled( ECollisionEnabled::NoCollision );
+			MergedRunComponent->SetStaticMesh( OwnerSubsystem->PathVisualizationMesh );
+			ApplyVisualizationMaterial( MergedRunComponent, PathColor );
+			MergedRunComponent->RegisterComponent();
+
+			MergedRunComponents.SetNum( FMath::Max( MergedRunComponents.Num(), NumMergedRuns + 1 ) );
+			MergedRunComponents[NumMergedRuns] = MergedRunComponent;
+		}
+		USplineMeshComponent* MergedRunComponent = MergedRunComponents[NumMergedRuns++].Get();
+		MergedRunComponent->SetStartAndEnd( FirstSegment->GetArriveLocation(), StartTangent, LastSegment->GetLeaveLocation(), EndTangent );
+
+		SegmentIndex = LastSegmentIndex + 1;
+	}
+
+	// Remove merged runs that are no longer needed
+	for ( int32 i = MergedRunComponents.Num() - 1; i >= NumMergedRuns; i-- )
+	{
+		DestroyVisualizationComponent( MergedRunComponents[i].Get() );
+		MergedRunComponents.RemoveAt( i );
+	}
+
+	// Lines are always regenerated from scratch since they are cheap
+	ULineBatchComponent* PathLineBatch = LineBatchComponent.Get();
+	if ( !PathLineBatch && !PathLines.IsEmpty() )
+	{
+		PathLineBatch = GetVisualizationActor()->CreateVisualizationComponent<ULineBatchComponent>();
+		PathLineBatch->RegisterComponent();
+		LineBatchComponent = PathLineBatch;
+	}
+	if ( PathLineBatch )
+	{
+		PathLineBatch->Flush();
+		PathLineBatch->DrawLines( PathLines );
 	}
+	bNeedsLODRepresentationRebuild = false;
 }
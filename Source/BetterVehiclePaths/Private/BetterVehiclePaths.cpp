@@ -6,6 +6,8 @@
 #include "EnhancedInputComponent.h"
 #include "FGCharacterPlayer.h"
 
+DEFINE_LOG_CATEGORY( LogBetterVehiclePaths );
+
 void FBetterVehiclePathsModule::StartupModule()
 {
 	OnInputInitializedHandle = AFGCharacterPlayer::OnPlayerInputInitialized.AddLambda( []( AFGCharacterPlayer* CharacterPlayer, UInputComponent* InputComponent )
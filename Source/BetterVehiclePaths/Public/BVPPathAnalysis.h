@@ -0,0 +1,237 @@
+﻿// Copyright Nikita Zolotukhin. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "BVPPathAnalysis.generated.h"
+
+class AFGTargetPoint;
+class AFGDrivingTargetList;
+
+// Speed profile of a looped path sampled at discrete points. Speeds are in m/s, distances are in meters
+struct BETTERVEHICLEPATHS_API FBVPSpeedProfile
+{
+	static constexpr double CentimetersToMeters = 0.01;
+	static constexpr double MetersPerSecondToKilometersPerHour = 3.6;
+	static constexpr double GravityAcceleration = 9.81;
+
+	// Speed at each sample
+	TArray<double> SampleSpeeds;
+	// Distance from each sample to the next one. The last sample is followed by the first one
+	TArray<double> SampleDistances;
+	// Sine of the slope angle at each sample, positive when driving uphill
+	TArray<double> SampleGrades;
+
+	void SetNumSamples( int32 NumSamples );
+	FORCEINLINE int32 GetNumSamples() const { return SampleSpeeds.Num(); }
+
+	// Limits the speeds by how fast the vehicle can accelerate and brake between the samples. Grade reduces the acceleration uphill and the deceleration downhill
+	void ApplyAccelerationLimits( double MaxAcceleration, double MaxDeceleration );
+
+	// Time it takes to drive from the start sample to the end sample, in seconds. End sample can be past the last sample to wrap around the loop
+	double ComputeTravelTime( int32 StartSample, int32 EndSample ) const;
+};
+
+USTRUCT( BlueprintType )
+struct BETTERVEHICLEPATHS_API FBVPPathTravelTimeEstimate
+{
+	GENERATED_BODY()
+
+	// Total length of the path loop, in world units
+	UPROPERTY( EditAnywhere, BlueprintReadWrite, Category = "Path Analysis" )
+	float PathLength{};
+
+	// Estimated time it takes to drive the whole loop, in seconds
+	UPROPERTY( EditAnywhere, BlueprintReadWrite, Category = "Path Analysis" )
+	float LapTime{};
+
+	// Length of each segment in the order of the path nodes, in world units. Segment N starts at the path node N
+	UPROPERTY( EditAnywhere, BlueprintReadWrite, Category = "Path Analysis" )
+	TArray<float> SegmentLengths;
+
+	// Estimated time it takes to drive each segment in the order of the path nodes, in seconds
+	UPROPERTY( EditAnywhere, BlueprintReadWrite, Category = "Path Analysis" )
+	TArray<float> SegmentTravelTimes;
+};
+
+USTRUCT( BlueprintType )
+struct BETTERVEHICLEPATHS_API FBVPPathThroughputEstimate
+{
+	GENERATED_BODY()
+
+	// Estimated time of a single round trip including the time spent at the stations, in seconds
+	UPROPERTY( EditAnywhere, BlueprintReadWrite, Category = "Path Analysis" )
+	float RoundTripTime{};
+
+	// Number of round trips completed by all vehicles on the route per minute
+	UPROPERTY( EditAnywhere, BlueprintReadWrite, Category = "Path Analysis" )
+	float TripsPerMinute{};
+
+	// Number of items delivered by all vehicles on the route per minute
+	UPROPERTY( EditAnywhere, BlueprintReadWrite, Category = "Path Analysis" )
+	float ItemsPerMinute{};
+};
+
+USTRUCT( BlueprintType )
+struct BETTERVEHICLEPATHS_API FBVPPathSegmentMetrics
+{
+	GENERATED_BODY()
+
+	// Length of the segment along the spline, in world units
+	UPROPERTY( EditAnywhere, BlueprintReadWrite, Category = "Path Analysis" )
+	float ArcLength{};
+
+	// Maximum curvature of the segment, in 1/m. Inverse of the radius of the sharpest turn
+	UPROPERTY( EditAnywhere, BlueprintReadWrite, Category = "Path Analysis" )
+	float MaxCurvature{};
+
+	// Minimum and maximum grade of the segment as the sine of the slope angle in the driving direction, negative when driving downhill
+	UPROPERTY( EditAnywhere, BlueprintReadWrite, Category = "Path Analysis" )
+	float MinGrade{};
+
+	UPROPERTY( EditAnywhere, BlueprintReadWrite, Category = "Path Analysis" )
+	float MaxGrade{};
+
+	// Target speeds of the path nodes at the start and the end of the segment, in km/h
+	UPROPERTY( EditAnywhere, BlueprintReadWrite, Category = "Path Analysis" )
+	int32 StartTargetSpeed{};
+
+	UPROPERTY( EditAnywhere, BlueprintReadWrite, Category = "Path Analysis" )
+	int32 EndTargetSpeed{};
+
+	// Bounds of the segment curve
+	UPROPERTY( EditAnywhere, BlueprintReadWrite, Category = "Path Analysis" )
+	FBox Bounds{ForceInit};
+};
+
+// Kind of a problem found on the path segment
+UENUM( BlueprintType )
+enum class EBVPPathProblemType : uint8
+{
+	// Segment is too steep for vehicles to climb or descend safely
+	SteepGrade,
+	// Segment turns too sharply for vehicles to follow
+	SharpCurve,
+	// Target speed of the segment is too high for its sharpest turn
+	ExcessiveCurveSpeed
+};
+
+USTRUCT( BlueprintType )
+struct BETTERVEHICLEPATHS_API FBVPPathProblem
+{
+	GENERATED_BODY()
+
+	UPROPERTY( EditAnywhere, BlueprintReadWrite, Category = "Path Analysis" )
+	EBVPPathProblemType ProblemType{};
+
+	// Path node the segment with the problem starts at. Weak, as the problems outlive the edits that remove the node
+	UPROPERTY( EditAnywhere, BlueprintReadWrite, Category = "Path Analysis" )
+	TWeakObjectPtr<AFGTargetPoint> SegmentStartNode;
+
+	// Location of the problem, center of the segment bounds
+	UPROPERTY( EditAnywhere, BlueprintReadWrite, Category = "Path Analysis" )
+	FVector Location{ForceInit};
+
+	// Measured value and the threshold it has exceeded, in the units of the matching setting
+	UPROPERTY( EditAnywhere, BlueprintReadWrite, Category = "Path Analysis" )
+	float Value{};
+
+	UPROPERTY( EditAnywhere, BlueprintReadWrite, Category = "Path Analysis" )
+	float Threshold{};
+};
+
+// Kind of a conflict between the segments of two different paths
+UENUM( BlueprintType )
+enum class EBVPPathConflictType : uint8
+{
+	// Segments cross each other at an angle
+	Crossing,
+	// Segments run along each other in opposite directions
+	HeadOnOverlap,
+	// Segments run along each other in the same direction
+	SharedOverlap
+};
+
+USTRUCT( BlueprintType )
+struct BETTERVEHICLEPATHS_API FBVPPathConflict
+{
+	GENERATED_BODY()
+
+	UPROPERTY( EditAnywhere, BlueprintReadWrite, Category = "Path Analysis" )
+	EBVPPathConflictType ConflictType{};
+
+	// Path nodes the conflicting segments of both paths start at. Weak, as the conflicts outlive the edits that remove the nodes
+	UPROPERTY( EditAnywhere, BlueprintReadWrite, Category = "Path Analysis" )
+	TWeakObjectPtr<AFGTargetPoint> SegmentStartNodeA;
+
+	UPROPERTY( EditAnywhere, BlueprintReadWrite, Category = "Path Analysis" )
+	TWeakObjectPtr<AFGTargetPoint> SegmentStartNodeB;
+
+	// Location of the conflict, midpoint between the closest points of the segments
+	UPROPERTY( EditAnywhere, BlueprintReadWrite, Category = "Path Analysis" )
+	FVector Location{ForceInit};
+
+	// Distance between the closest points of the segments
+	UPROPERTY( EditAnywhere, BlueprintReadWrite, Category = "Path Analysis" )
+	float Distance{};
+};
+
+// Kind of a constraint violated by the path
+UENUM( BlueprintType )
+enum class EBVPPathViolationType : uint8
+{
+	// Distance to the next path node is above the maximum distance between path nodes
+	NodesTooFar,
+	// Distance to the next path node is below the minimum distance between path nodes. Only a warning, as the edits do not enforce the minimum distance
+	NodesTooClose,
+	// Path node is at the same location as another path node of the same path
+	DuplicateNode,
+	// Target speed of the path node is outside of the allowed range
+	TargetSpeedOutOfRange,
+	// Linked list of the path nodes is inconsistent with the target list
+	BrokenLink
+};
+
+// How severe a violation of the path constraints is
+UENUM( BlueprintType )
+enum class EBVPPathViolationSeverity : uint8
+{
+	// Path still works, but does not follow the recommended constraints
+	Warning,
+	// Path is broken or breaks the constraints the edits enforce
+	Error
+};
+
+USTRUCT( BlueprintType )
+struct BETTERVEHICLEPATHS_API FBVPPathViolation
+{
+	GENERATED_BODY()
+
+	UPROPERTY( EditAnywhere, BlueprintReadWrite, Category = "Path Analysis" )
+	EBVPPathViolationType ViolationType{};
+
+	UPROPERTY( EditAnywhere, BlueprintReadWrite, Category = "Path Analysis" )
+	EBVPPathViolationSeverity Severity{EBVPPathViolationSeverity::Error};
+
+	UPROPERTY( EditAnywhere, BlueprintReadWrite, Category = "Path Analysis" )
+	TWeakObjectPtr<AFGDrivingTargetList> TargetList;
+
+	// Path node violating the constraint, and the other path node involved in the violation if there is one
+	UPROPERTY( EditAnywhere, BlueprintReadWrite, Category = "Path Analysis" )
+	TWeakObjectPtr<AFGTargetPoint> PathNode;
+
+	UPROPERTY( EditAnywhere, BlueprintReadWrite, Category = "Path Analysis" )
+	TWeakObjectPtr<AFGTargetPoint> OtherPathNode;
+
+	// Measured value that has violated the constraint, such as the distance or the target speed
+	UPROPERTY( EditAnywhere, BlueprintReadWrite, Category = "Path Analysis" )
+	float Value{};
+};
+
+// Travel time estimate cached for the state of the path it has been computed for
+struct FBVPCachedTravelTimeEstimate
+{
+	int32 GeometryGeneration{INDEX_NONE};
+	uint32 SpeedChecksum{};
+	FBVPPathTravelTimeEstimate Estimate;
+};
@@ -0,0 +1,64 @@
+﻿// Copyright Nikita Zolotukhin. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "BVPPathAnalysis.h"
+#include "UObject/ObjectKey.h"
+
+class AFGTargetPoint;
+class AFGDrivingTargetList;
+class FBVPVehiclePathVisualization;
+class FBVPVehiclePathSegmentVisualization;
+
+// Finds conflicts between the segments of different paths. Segment bounds of all paths are kept sorted along the X axis and swept to find the overlapping pairs,
+// which are then refined by finding the closest points between their curves. Only the entries of the paths that have changed since the last update are replaced and tested again
+class BETTERVEHICLEPATHS_API FBVPPathConflictDetector
+{
+	struct FSweepEntry
+	{
+		FBox Bounds{ForceInit};
+		const FBVPVehiclePathSegmentVisualization* SegmentVisualization{};
+		TObjectKey<AFGDrivingTargetList> TargetList;
+	};
+
+	struct FAnalyzedPath
+	{
+		const FBVPVehiclePathVisualization* PathVisualization{};
+		int32 GeometryGeneration{};
+	};
+
+	struct FConflictRecord
+	{
+		TObjectKey<AFGDrivingTargetList> TargetListA;
+		TObjectKey<AFGDrivingTargetList> TargetListB;
+		FBVPPathConflict Conflict;
+	};
+
+	TArray<FConflictRecord> Conflicts;
+	TMap<TObjectKey<AFGDrivingTargetList>, FAnalyzedPath> AnalyzedPaths;
+
+	// Segments of all analyzed paths sorted by the minimum X of their bounds. Kept between the updates so that only the entries of the changed paths are replaced
+	TArray<FSweepEntry> SweepEntries;
+	// Largest X extent of the sweep entries, which limits how far before an entry the entries overlapping it can start
+	double MaxSweepEntryExtentX{};
+
+	// Kept around between the updates to avoid re-allocating them every time
+	TArray<FSweepEntry> ChangedSweepEntries;
+	TArray<FSweepEntry> MergedSweepEntries;
+public:
+	// Re-tests the segments of the paths whose geometry has changed since the last update, and drops the conflicts of the removed paths. Returns true if the conflicts have changed
+	bool Update( const TArray<FBVPVehiclePathVisualization*>& PathVisualizations );
+
+	void GetConflicts( TArray<FBVPPathConflict>& OutConflicts ) const;
+	void GetPathConflicts( const AFGDrivingTargetList* TargetList, TArray<FBVPPathConflict>& OutConflicts ) const;
+	// Collects the start path nodes of the conflicting segments of each path
+	void GetConflictingSegmentStartNodes( TMap<TObjectKey<AFGDrivingTargetList>, TArray<TObjectKey<AFGTargetPoint>>>& OutSegmentStartNodes ) const;
+
+	FORCEINLINE int32 GetNumConflicts() const { return Conflicts.Num(); }
+private:
+	// Records the conflict between the segments of the two entries if their bounds overlap and their curves are close enough
+	void TestSweepEntryPair( const FSweepEntry& EntryA, const FSweepEntry& EntryB, double MaxDistance, double MinCrossingAngleCosine );
+	// Finds the closest points between the two segments and classifies the conflict between them. Returns false if the segments are too far apart
+	static bool RefineConflict( const FBVPVehiclePathSegmentVisualization* SegmentA, const FBVPVehiclePathSegmentVisualization* SegmentB, double MaxDistance, double MinCrossingAngleCosine, FBVPPathConflict& OutConflict );
+};
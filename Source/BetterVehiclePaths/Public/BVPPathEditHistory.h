@@ -0,0 +1,104 @@
+﻿// Copyright Nikita Zolotukhin. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "UObject/ObjectKey.h"
+#include "UObject/WeakObjectPtrTemplates.h"
+
+class AFGTargetPoint;
+
+enum class EBVPPathEditType : uint8
+{
+	Move,
+	SetTargetSpeed,
+	Create,
+	Remove
+};
+
+// Single edit recorded in the undo history. Path nodes are referenced through the handles of the history,
+// since undoing a removal spawns a new node actor that has to take the place of the removed one in all other edits.
+// The state before the edit is stored once, and the state after it as a quantized delta from it
+struct FBVPPathEditRecord
+{
+	int32 PathNodeHandle{INDEX_NONE};
+	// Node after which the node has been created or removed
+	int32 PrevPathNodeHandle{INDEX_NONE};
+	EBVPPathEditType EditType{};
+private:
+	// Number of bits the location delta is shifted by. Zero for the usual moves, raised for the moves too long to fit 16 bits in whole units
+	uint8 LocationDeltaShift{};
+	// Location before the edit, and the delta to the location after it in units of 1 << LocationDeltaShift
+	FVector3f OldLocation{ForceInit};
+	int16 LocationDelta[3]{};
+	// Rotation before the edit compressed to 16 bits per axis, and the delta to the rotation after it, wrapped around the full turn
+	uint16 OldRotation[3]{};
+	int16 RotationDelta[3]{};
+	uint16 OldTargetSpeed{};
+	uint16 NewTargetSpeed{};
+public:
+	void SetLocations( const FVector& InOldLocation, const FVector& InNewLocation );
+	void SetRotations( const FRotator& InOldRotation, const FRotator& InNewRotation );
+	void SetTargetSpeeds( int32 InOldTargetSpeed, int32 InNewTargetSpeed );
+
+	// State of the node before the edit if bOld is true, or after it otherwise
+	FVector GetLocation( bool bOld ) const;
+	FRotator GetRotation( bool bOld ) const;
+	int32 GetTargetSpeed( bool bOld ) const;
+};
+
+// Undo and redo history of the path edits made by a single player. Edits are kept in a ring buffer bounded by the byte size,
+// and the oldest edits are dropped once it is full. Recording a new edit discards all edits that could have been redone.
+// The byte size covers the edits along with the node handles they can reference, so the whole history stays within it
+class BETTERVEHICLEPATHS_API FBVPPathEditHistory
+{
+	TArray<FBVPPathEditRecord> Edits;
+	// Maximum number of edits the ring buffer can hold
+	int32 Capacity{};
+	// Index of the oldest edit in the ring buffer
+	int32 FirstEditIndex{};
+	int32 NumEdits{};
+	// Number of edits that can be undone. Edits past that are the ones that can be redone
+	int32 NumUndoEdits{};
+
+	// Path node of each handle, and the handle of each path node
+	TArray<TWeakObjectPtr<AFGTargetPoint>> PathNodeHandles;
+	TMap<TObjectKey<AFGTargetPoint>, int32> HandlesByPathNode;
+
+	// Time at which the last move has been recorded, to coalesce the consecutive moves of the same node
+	double LastMoveTime{};
+public:
+	explicit FBVPPathEditHistory( int32 MaxBytes );
+
+	// Bytes charged against the history size for each edit, including the two node handles it can reference along with their map entries
+	static int32 GetBytesPerEdit();
+
+	// Records the move of the node. Consecutive moves of the same node within the coalesce time are merged into a single edit, so a drag is undone at once
+	void RecordMove( AFGTargetPoint* PathNode, const FTransform& OldTransform, const FTransform& NewTransform, double Time, double CoalesceTime );
+	void RecordTargetSpeed( AFGTargetPoint* PathNode, int32 OldTargetSpeed, int32 NewTargetSpeed );
+	// Records the creation of the node. Must be called after the node has been inserted into the list
+	void RecordCreate( AFGTargetPoint* PathNode, AFGTargetPoint* PrevPathNode );
+	// Records the removal of the node. Must be called before the node is removed from the list
+	void RecordRemove( AFGTargetPoint* PathNode, AFGTargetPoint* PrevPathNode );
+
+	// Returns the edit that would be undone or redone next, or null if there is none
+	const FBVPPathEditRecord* PeekUndo() const;
+	const FBVPPathEditRecord* PeekRedo() const;
+	// Moves the edit returned by PeekUndo or PeekRedo to the other side of the history once it has been applied
+	void CommitUndo();
+	void CommitRedo();
+
+	AFGTargetPoint* ResolveHandle( int32 Handle ) const;
+	// Points the handle to the node spawned in place of the removed one
+	void RebindHandle( int32 Handle, AFGTargetPoint* PathNode );
+
+	FORCEINLINE int32 GetNumUndoEdits() const { return NumUndoEdits; }
+	FORCEINLINE int32 GetNumRedoEdits() const { return NumEdits - NumUndoEdits; }
+private:
+	int32 FindOrAddHandle( AFGTargetPoint* PathNode );
+	void PushEdit( const FBVPPathEditRecord& Edit );
+	FBVPPathEditRecord& GetEdit( int32 Index );
+	const FBVPPathEditRecord& GetEdit( int32 Index ) const;
+	// Drops the handles that are no longer referenced by any edit and renumbers the remaining ones
+	void CompactHandles();
+};
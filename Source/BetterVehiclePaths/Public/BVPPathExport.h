@@ -0,0 +1,66 @@
+﻿// Copyright Nikita Zolotukhin. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+class AFGDrivingTargetList;
+
+// Path node as stored in the exported path format
+struct BETTERVEHICLEPATHS_API FBVPExportedPathNode
+{
+	FVector Location{ ForceInit };
+	FRotator Rotation{ ForceInit };
+	int32 TargetSpeed{};
+};
+
+// Path as stored in the exported path format, with the nodes in the order of the path
+struct BETTERVEHICLEPATHS_API FBVPExportedPath
+{
+	TArray<FBVPExportedPathNode> PathNodes;
+};
+
+// Compact versioned binary format used to share paths between saves and servers.
+// Locations are quantized and stored as zigzag varint deltas from the previous node, rotations are stored as quantized yaw deltas,
+// and pitch, roll and target speed are only stored when they differ from the previous node, which is signalled by the per-node flags
+class BETTERVEHICLEPATHS_API FBVPPathArchive
+{
+public:
+	// Four characters at the start of the data, "BVPP"
+	static constexpr uint32 Magic = 0x50505642;
+	// Size of a single location quantization step, in world units
+	static constexpr double LocationQuantum = 1.0;
+	// Largest quantized coordinate accepted when decoding. Anything further away is outside of the world
+	static constexpr int64 MaxQuantizedCoordinate = static_cast<int64>( UE_OLD_HALF_WORLD_MAX / LocationQuantum );
+
+	enum class EVersion : uint8
+	{
+		Initial = 1,
+
+		// -----<new versions can be added above this line>-----
+		VersionPlusOne,
+		Latest = VersionPlusOne - 1
+	};
+
+	// Collects the nodes of the target list into the exported path
+	static void ExportPath( const AFGDrivingTargetList* TargetList, FBVPExportedPath& OutPath );
+
+	// Encodes the paths into the binary format using the latest version
+	static void Encode( const TArray<FBVPExportedPath>& Paths, TArray<uint8>& OutData );
+
+	// Decodes the paths from the binary data. Returns false if the data is malformed, truncated, has been written by a newer version,
+	// or has nodes outside of the world or target speeds outside of the 32 bit range
+	static bool Decode( const TArray<uint8>& Data, TArray<FBVPExportedPath>& OutPaths );
+private:
+	enum class ENodeFlags : uint8
+	{
+		None = 0x00,
+		HasPitchAndRoll = 0x01,
+		HasTargetSpeed = 0x02,
+	};
+
+	static void WriteVarUInt( TArray<uint8>& Data, uint64 Value );
+	static void WriteVarInt( TArray<uint8>& Data, int64 Value );
+	static bool ReadVarUInt( const TArray<uint8>& Data, int32& Offset, uint64& OutValue );
+	static bool ReadVarInt( const TArray<uint8>& Data, int32& Offset, int64& OutValue );
+};
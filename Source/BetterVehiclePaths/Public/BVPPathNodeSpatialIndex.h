@@ -0,0 +1,62 @@
+﻿// Copyright Nikita Zolotukhin. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "UObject/ObjectKey.h"
+#include "UObject/WeakObjectPtrTemplates.h"
+
+class AFGTargetPoint;
+class AFGDrivingTargetList;
+
+// Uniform hash grid over the path nodes of all target lists. Nodes are bucketed by the grid cell their location falls into
+class BETTERVEHICLEPATHS_API FBVPPathNodeSpatialIndex
+{
+	struct FIndexedPathNode
+	{
+		TWeakObjectPtr<AFGTargetPoint> PathNode;
+		TObjectKey<AFGDrivingTargetList> TargetList;
+		FVector Location{ForceInit};
+		FIntVector Cell{ForceInit};
+	};
+
+	struct FIndexedTargetList
+	{
+		TWeakObjectPtr<AFGDrivingTargetList> TargetList;
+		TArray<TObjectKey<AFGTargetPoint>> PathNodes;
+		int32 GeometryGeneration{INDEX_NONE};
+	};
+
+	double CellSize{};
+	TMap<FIntVector, TArray<TObjectKey<AFGTargetPoint>>> Cells;
+	TMap<TObjectKey<AFGTargetPoint>, FIndexedPathNode> IndexedPathNodes;
+	TMap<TObjectKey<AFGDrivingTargetList>, FIndexedTargetList> IndexedTargetLists;
+public:
+	explicit FBVPPathNodeSpatialIndex( double InCellSize = 5000.0 );
+
+	// Changes the size of the grid cell. Rebuilds the index if the size has changed
+	void SetCellSize( double NewCellSize );
+
+	// Adds the node to the index, or moves it to the correct cell if it is already indexed
+	void UpdatePathNode( AFGTargetPoint* PathNode );
+	void RemovePathNode( const AFGTargetPoint* PathNode );
+
+	// Re-indexes all nodes of the target list if the geometry generation has changed since the last sync, and drops the nodes that are no longer in the list
+	void SyncTargetList( AFGDrivingTargetList* TargetList, int32 GeometryGeneration );
+	// Drops the nodes of target lists that have been destroyed
+	void RemoveStaleTargetLists();
+
+	// Returns the node closest to the location within the maximum distance, or null if there are no such nodes
+	AFGTargetPoint* FindNearestPathNode( const FVector& Location, double MaxDistance ) const;
+	void FindPathNodesInRadius( const FVector& Location, double Radius, TArray<AFGTargetPoint*>& OutPathNodes ) const;
+	void FindPathNodesInBox( const FBox& Box, TArray<AFGTargetPoint*>& OutPathNodes ) const;
+
+	FORCEINLINE int32 GetNumIndexedPathNodes() const { return IndexedPathNodes.Num(); }
+private:
+	FIntVector GetCellForLocation( const FVector& Location ) const;
+	void RemoveNodeFromCell( const TObjectKey<AFGTargetPoint>& PathNodeKey, const FIntVector& Cell );
+
+	// Calls the callback for every indexed node in the cells overlapping the box. Falls back to iterating all cells when the box covers more cells than there are populated ones
+	template<typename TCallback>
+	void ForEachPathNodeInBox( const FBox& Box, TCallback&& Callback ) const;
+};
@@ -0,0 +1,43 @@
+﻿// Copyright Nikita Zolotukhin. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "BVPPathAnalysis.h"
+
+class AFGTargetPoint;
+class AFGDrivingTargetList;
+
+// Limits the paths are validated against, captured from the settings once per validation pass
+struct BETTERVEHICLEPATHS_API FBVPPathValidationLimits
+{
+	double MinDistanceBetweenPathNodes{};
+	double MaxDistanceBetweenPathNodes{};
+	int32 MinTargetSpeed{};
+	int32 MaxTargetSpeed{};
+
+	static FBVPPathValidationLimits FromSettings();
+};
+
+// Path nodes of a target list packed into contiguous arrays. Locations are stored per component so that they can be loaded into vector registers directly
+struct BETTERVEHICLEPATHS_API FBVPPackedPathNodes
+{
+	TArray<AFGTargetPoint*> PathNodes;
+	TArray<double> LocationsX;
+	TArray<double> LocationsY;
+	TArray<double> LocationsZ;
+	TArray<int32> TargetSpeeds;
+
+	// Walks the linked list of the target list once, recording the broken links found along the way
+	void Pack( AFGDrivingTargetList* TargetList, TArray<FBVPPathViolation>& OutViolations );
+};
+
+// Checks all constraints of the path in a single pass over the packed path nodes
+class BETTERVEHICLEPATHS_API FBVPPathValidator
+{
+public:
+	// Validates the path and appends the violations found to the list. Returns true if the path has no violations other than warnings
+	static bool ValidatePath( AFGDrivingTargetList* TargetList, const FBVPPathValidationLimits& Limits, TArray<FBVPPathViolation>& OutViolations );
+private:
+	static void ValidatePackedPathNodes( AFGDrivingTargetList* TargetList, const FBVPPackedPathNodes& PackedPathNodes, const FBVPPathValidationLimits& Limits, TArray<FBVPPathViolation>& OutViolations );
+};
@@ -7,6 +7,7 @@
 #include "BVPPathVisualizationActor.generated.h"
 
 class AFGDrivingTargetList;
+class UPrimitiveComponent;
 
 UCLASS()
 class BETTERVEHICLEPATHS_API ABVPPathVisualizationActor : public AActor
@@ -18,4 +19,23 @@ public:
 	// The target list this actor belongs to.
 	UPROPERTY( VisibleAnywhere, BlueprintReadOnly, Category = "BVP Subsystem" )
 	AFGDrivingTargetList* OwnerTargetList;
+
+	// Creates a new transient component attached to the root of this actor. The caller is responsible for setting it up and registering it
+	template<typename T>
+	T* CreateVisualizationComponent()
+	{
+		T* NewComponent = NewObject<T>( this, NAME_None, RF_Transient );
+		NewComponent->SetupAttachment( GetRootComponent() );
+		NumVisualizationComponents++;
+		return NewComponent;
+	}
+
+	// Destroys the component previously created with CreateVisualizationComponent
+	void DestroyVisualizationComponent( UPrimitiveComponent* Component );
+
+	// Returns the number of the visualization components alive on this actor
+	FORCEINLINE int32 GetNumVisualizationComponents() const { return NumVisualizationComponents; }
+protected:
+	// Components are kept alive by the owned components of the actor and by their attachment, so they are only counted here rather than referenced a third time
+	int32 NumVisualizationComponents{};
 };
@@ -17,44 +17,96 @@ enum class EBVPPathVisualizationType : uint8
 {
 	None = 0x00,
 	SegmentVisualization = 0x01,
-	SegmentCollision = 0x02
+	SegmentCollision = 0x02,
+	NetworkOverview = 0x04,
+	ProblemHighlight = 0x08
 };
 ENUM_CLASS_FLAGS( EBVPPathVisualizationType );
 
+// State of a single segment as seen by the visualization tracker
+struct FBVPTrackedSegmentState
+{
+	// Visualization bits currently set on the segment by the tracker
+	EBVPPathVisualizationType VisualizationBits{};
+
+	// True if the last occlusion test has found the segment to be hidden behind the terrain
+	bool bOccluded{false};
+};
+
+// Packed data of a single segment used by the relevance evaluation. Copied out of the segments once per frame and shared between all trackers
+struct FBVPSegmentRelevanceData
+{
+	FVector ArriveLocation;
+	FVector LeaveLocation;
+	FVector BoundsCenter;
+	double BoundsRadius{};
+	FBox Bounds{ForceInit};
+	// Index of the state of the segment in the state arrays of the trackers
+	int32 StateSlotIndex{INDEX_NONE};
+
+	bool IsRelevantForObserver( const FVector& ObserverLocation, double RelevanceDistance ) const;
+	bool IsInViewCone( const FVector& ObserverLocation, const FVector& ViewDirection, double ViewConeHalfAngle ) const;
+};
+
+// State of the observer of a single tracker, captured on the game thread before the relevance evaluation
+struct FBVPRelevanceObserver
+{
+	class FBVPPlayerVisualizationTracker* Tracker{};
+	FVector ObserverLocation;
+	FVector ViewDirection;
+	double ViewConeHalfAngle{};
+	EBVPPathVisualizationType WantedVisualizationBits{};
+
+	// State of each segment as tracked by the tracker, indexed by the state slot of the segment. Only read during the evaluation
+	const TArray<FBVPTrackedSegmentState>* SegmentStates{};
+
+	// Visualization bits desired for each segment, written by the relevance evaluation
+	TArray<EBVPPathVisualizationType> DesiredVisualizationBits;
+};
+
 class BETTERVEHICLEPATHS_API FBVPPlayerVisualizationTracker
 {
-	// Maps of segments to the visualization bits set for these segments
-	TMap<const FBVPVehiclePathSegmentVisualization*, EBVPPathVisualizationType> VisualizationSegmentToVisualizationBitMap;
+	// State of each segment, including the visualization bits set for them, indexed by the state slot of the segment
+	TArray<FBVPTrackedSegmentState> TrackedSegmentStates;
 
 	// Map of VisualizationId a bitmask of all visualization bits enabled on it
 	TMap<FName, EBVPPathVisualizationType> EnabledVisualizationBits;
 
 	UBVPSubsystem* OwnerSubsystem{};
-	APlayerController* OwnerPlayer{};
-	int32 LastVisualizationSegmentArraySize{};
+	TWeakObjectPtr<APlayerController> OwnerPlayer;
+	int32 NextOcclusionTestSegmentIndex{};
 public:
 	FBVPPlayerVisualizationTracker( UBVPSubsystem* InSubsystem, APlayerController* InPlayer );
 
-	FORCEINLINE APlayerController* GetOwner() const { return OwnerPlayer; }
+	FORCEINLINE APlayerController* GetOwner() const { return OwnerPlayer.Get(); }
 	
 	void SetVisualizationBit( FName VisualizationId, EBVPPathVisualizationType VisualizationBit, bool bVisualizationEnabled );
 	bool GetVisualizationBit( FName VisualizationId, EBVPPathVisualizationType VisualizationBit ) const;
 
+	EBVPPathVisualizationType GetCombinedVisualizationFlags() const;
+
 	bool IsVisualizationTrackerValid() const;
 	bool IsVisualizationTrackerEmpty() const;
 	
 	void DestroyVisualizationTracker();
 	void ClearSegmentVisualization( const FBVPVehiclePathSegmentVisualization* SegmentVisualization );
 	
-	void UpdateVisualizationTracker();
+	// Captures the state of the observer and updates the segment occlusion. Returns false if the tracker has no valid observer.
+	bool BuildRelevanceObserver( const TArray<FBVPVehiclePathSegmentVisualization*>& AllVisualizations, FBVPRelevanceObserver& OutObserver );
+	// Applies the visualization bits evaluated for the observer of this tracker to the segments
+	void ApplyRelevanceObserver( const TArray<FBVPVehiclePathSegmentVisualization*>& AllVisualizations, const FBVPRelevanceObserver& Observer );
 
-	void AddReferencedObjects( FReferenceCollector& ReferenceCollector );
+	// Evaluates the relevance of all segments for all observers at once, in parallel. Also outputs the closest visualizing observer distance per segment
+	static void EvaluateRelevance( const TArray<FBVPVehiclePathSegmentVisualization*>& AllVisualizations, const TArray<FBVPSegmentRelevanceData>& SegmentData,
+		TArray<FBVPRelevanceObserver>& Observers, TArray<double>& OutClosestObserverDistance );
 private:
 	static constexpr EBVPPathVisualizationType AllVisualizationTypes[] { EBVPPathVisualizationType::SegmentCollision, EBVPPathVisualizationType::SegmentVisualization };
 	
-	void CollectAllVisualizationPaths( TArray<FBVPVehiclePathSegmentVisualization*>& OutAllVisualizations );
-	EBVPPathVisualizationType GetCombinedVisualizationFlags() const;
+	void UpdateSegmentOcclusion( const TArray<FBVPVehiclePathSegmentVisualization*>& AllVisualizations, const FVector& ObserverLocation, double MaxRelevanceDistance );
+	// Grows the segment state array to cover all state slots handed out by the subsystem. New slots have the default state
+	void UpdateSegmentStateSlots();
 	
-	void ApplyVisualizationBits( const TArray<FBVPVehiclePathSegmentVisualization*>& AllVisualizations, const TMap<FBVPVehiclePathSegmentVisualization*, EBVPPathVisualizationType>& NewVisualizationBits );
+	// Applies the visualization bits to the segments. Segments beyond the end of the new visualization bits array will have all of their bits cleared
+	void ApplyVisualizationBits( const TArray<FBVPVehiclePathSegmentVisualization*>& AllVisualizations, const TArray<EBVPPathVisualizationType>& NewVisualizationBits );
 	static void SetVisualizationTypeEnabledForSegment( FBVPVehiclePathSegmentVisualization* SegmentVisualization, EBVPPathVisualizationType VisualizationType, bool bEnabled );
 };
\ No newline at end of file
@@ -32,6 +32,42 @@ public:
 	UPROPERTY( EditAnywhere, Category = "General", Config )
 	TMap<EBVPPathVisualizationType, float> MaxPathVisualizationDistance;
 
+	// Additional distance beyond the visualization distance that a segment has to leave before it stops being relevant. Prevents segments on the boundary from flickering
+	UPROPERTY( EditAnywhere, Category = "General", Config )
+	float PathVisualizationRelevanceHysteresis;
+
+	// Time in seconds for which segments that are no longer relevant keep their hidden components around before destroying them
+	UPROPERTY( EditAnywhere, Category = "General", Config )
+	float PathVisualizationHibernationTime;
+
+	// Maximum number of components that can be kept by hibernated segments. Least recently hibernated segments are released first
+	UPROPERTY( EditAnywhere, Category = "General", Config )
+	int32 MaxHibernatedPathComponents;
+
+	// When enabled, segments outside of the player's view use the off-screen visualization distance instead
+	UPROPERTY( EditAnywhere, Category = "General", Config )
+	bool bEnableViewFrustumRelevance;
+
+	// Angle in degrees added to the player's field of view when checking if the segment is on screen, so quick turns do not reveal missing segments
+	UPROPERTY( EditAnywhere, Category = "General", Config )
+	float ViewFrustumRelevanceMargin;
+
+	// When enabled, segments hidden behind the terrain from the player's point of view are considered off-screen
+	UPROPERTY( EditAnywhere, Category = "General", Config )
+	bool bEnableTerrainOcclusionRelevance;
+
+	// Maximum number of occlusion traces each player can perform per frame. Segments are re-tested in a round-robin fashion
+	UPROPERTY( EditAnywhere, Category = "General", Config )
+	int32 MaxOcclusionTracesPerFrame;
+
+	// Maximum distance at which path visualizations will be rendered for off-screen or occluded segments - per visualization bit
+	UPROPERTY( EditAnywhere, Category = "General", Config )
+	TMap<EBVPPathVisualizationType, float> OffscreenPathVisualizationDistance;
+
+	// Size of a single cell of the spatial index used for path node queries. Should be close to the typical distance between path nodes
+	UPROPERTY( EditAnywhere, Category = "General", Config )
+	float PathNodeSpatialIndexCellSize;
+
 	// Minimum distance between path nodes before we are allowed to spawn new ones
 	UPROPERTY( EditAnywhere, Category = "General", Config )
 	float MinDistanceBetweenPathNodes;
@@ -48,6 +84,82 @@ public:
 	UPROPERTY( EditAnywhere, Category = "Enhanced Input", Config )
 	TSoftObjectPtr<UInputAction> InputActionOpenPathEditor;
 
+	// Maximum target speed that can be set on a path node, in km/h
+	UPROPERTY( EditAnywhere, Category = "Speed Optimizer", Config )
+	int32 MaxTargetSpeed;
+
+	// Minimum target speed the speed optimizer is allowed to set on a path node, in km/h
+	UPROPERTY( EditAnywhere, Category = "Speed Optimizer", Config )
+	int32 MinOptimizedTargetSpeed;
+
+	// Maximum lateral acceleration allowed in curves, in m/s^2
+	UPROPERTY( EditAnywhere, Category = "Speed Optimizer", Config )
+	float MaxLateralAcceleration;
+
+	// Maximum acceleration of the vehicle on flat ground, in m/s^2. Reduced when driving uphill
+	UPROPERTY( EditAnywhere, Category = "Speed Optimizer", Config )
+	float MaxLongitudinalAcceleration;
+
+	// Maximum deceleration of the vehicle on flat ground, in m/s^2. Reduced when driving downhill
+	UPROPERTY( EditAnywhere, Category = "Speed Optimizer", Config )
+	float MaxLongitudinalDeceleration;
+
+	// Number of samples per path segment used to build the speed profile
+	UPROPERTY( EditAnywhere, Category = "Speed Optimizer", Config )
+	int32 SpeedOptimizerSamplesPerSegment;
+
+	// Maximum grade of a segment before it is reported as a problem, as the sine of the slope angle
+	UPROPERTY( EditAnywhere, Category = "Problem Detector", Config )
+	float ProblemMaxGrade;
+
+	// Maximum curvature of a segment before it is reported as a problem, in 1/m. Inverse of the radius of the sharpest allowed turn
+	UPROPERTY( EditAnywhere, Category = "Problem Detector", Config )
+	float ProblemMaxCurvature;
+
+	// Maximum lateral acceleration caused by driving the sharpest turn of the segment at its target speed before it is reported as a problem, in m/s^2
+	UPROPERTY( EditAnywhere, Category = "Problem Detector", Config )
+	float ProblemMaxLateralAcceleration;
+
+	// Maximum number of paths that can be re-analyzed by the problem detector per frame
+	UPROPERTY( EditAnywhere, Category = "Problem Detector", Config )
+	int32 ProblemDetectorPathsPerFrame;
+
+	// Color used to highlight the segments with problems when the problem highlight is requested
+	UPROPERTY( EditAnywhere, Category = "Problem Detector", Config )
+	FLinearColor ProblemHighlightColor;
+
+	// Maximum distance between the segments of two different paths before they are reported as conflicting
+	UPROPERTY( EditAnywhere, Category = "Conflict Detector", Config )
+	float ConflictMaxDistance;
+
+	// Maximum angle in degrees between the directions of two conflicting segments for them to be considered overlapping instead of crossing
+	UPROPERTY( EditAnywhere, Category = "Conflict Detector", Config )
+	float ConflictOverlapMaxAngle;
+
+	// Color used to highlight the conflicting segments when the problem highlight is requested
+	UPROPERTY( EditAnywhere, Category = "Conflict Detector", Config )
+	FLinearColor ConflictHighlightColor;
+
+	// Maximum number of path nodes that can be spawned per frame when importing paths. Large imports are spread over multiple frames
+	UPROPERTY( EditAnywhere, Category = "Path Import", Config )
+	int32 PathImportNodesPerFrame;
+
+	// Maximum total number of path nodes that can be imported at once. Keeps the imported data within the size that can be sent to the server
+	UPROPERTY( EditAnywhere, Category = "Path Import", Config )
+	int32 MaxImportedPathNodes;
+
+	// Maximum size in bytes of the encoded path data that can be imported at once. Checked before the data is decoded
+	UPROPERTY( EditAnywhere, Category = "Path Import", Config )
+	int32 MaxPathImportDataSize;
+
+	// Maximum number of imported paths a single player can have waiting for their nodes to be spawned
+	UPROPERTY( EditAnywhere, Category = "Path Import", Config )
+	int32 MaxPendingPathImportsPerPlayer;
+
+	// Maximum number of imported paths waiting for their nodes to be spawned across all players
+	UPROPERTY( EditAnywhere, Category = "Path Import", Config )
+	int32 MaxPendingPathImports;
+
 	// Mesh to use as a segment for path visualization
 	UPROPERTY( EditAnywhere, Category = "Path Visualization | Mesh", Config )
 	TSoftObjectPtr<UStaticMesh> PathVisualizationMesh;
@@ -60,10 +172,52 @@ public:
 	UPROPERTY( EditAnywhere, Category = "Path Visualization | Mesh", Config )
 	TSoftObjectPtr<UMaterialInterface> PathVisualizationMaterial;
 
-	// Name of the parameter on the material instance to populate with a randomly selected color of a path
+	// Index of the custom primitive data slot to populate with the color of a path. Occupies 4 slots starting at this index.
+	// The material should read the color from the custom primitive data so that all paths can share it and be batched together
+	UPROPERTY( EditAnywhere, Category = "Path Visualization | Mesh", Config )
+	int32 PathVisualizationColorCustomDataIndex;
+
+	// Whether the material reads the path color from the custom primitive data. If not, a material instance is created for each color instead,
+	// with the color set through the parameter below
+	UPROPERTY( EditAnywhere, Category = "Path Visualization | Mesh", Config )
+	bool bPathVisualizationMaterialUsesCustomData;
+
+	// Name of the parameter on the material instance to populate with the color of a path, when the material does not use the custom primitive data
 	UPROPERTY( EditAnywhere, Category = "Path Visualization | Mesh", Config )
 	FName PathVisualizationColorParameterName;
 	
+	// Distance from the observer at which nearly straight segments are merged together into a single stretched mesh
+	UPROPERTY( EditAnywhere, Category = "Path Visualization | LOD", Config )
+	float PathVisualizationMergedLODDistance;
+
+	// Distance from the observer at which segments are rendered as lines instead of meshes
+	UPROPERTY( EditAnywhere, Category = "Path Visualization | LOD", Config )
+	float PathVisualizationLineLODDistance;
+
+	// Maximum angle in degrees between the segment tangents and the direction of the merged run for the segment to be merged into it
+	UPROPERTY( EditAnywhere, Category = "Path Visualization | LOD", Config )
+	float PathVisualizationMergeMaxAngle;
+
+	// Maximum number of segments that can be merged into a single mesh
+	UPROPERTY( EditAnywhere, Category = "Path Visualization | LOD", Config )
+	int32 PathVisualizationMaxMergedSegments;
+
+	// Number of line segments used to approximate a single path segment in the line LOD
+	UPROPERTY( EditAnywhere, Category = "Path Visualization | LOD", Config )
+	int32 PathVisualizationLineSamplesPerSegment;
+
+	// Thickness of the lines used by the line LOD, in world units
+	UPROPERTY( EditAnywhere, Category = "Path Visualization | LOD", Config )
+	float PathVisualizationLineThickness;
+
+	// Number of line segments used to approximate a single path segment in the network overview
+	UPROPERTY( EditAnywhere, Category = "Path Visualization | Network Overview", Config )
+	int32 NetworkOverviewSamplesPerSegment;
+
+	// Thickness of the lines used by the network overview, in world units
+	UPROPERTY( EditAnywhere, Category = "Path Visualization | Network Overview", Config )
+	float NetworkOverviewLineThickness;
+
 	// The thickness of the collision box to use for the visualization
 	UPROPERTY( EditAnywhere, Category = "Path Visualization | Collision", Config )
 	float PathVisualizationCollisionThickness;
@@ -96,6 +250,22 @@ public:
 	UPROPERTY( EditAnywhere, Category = "Path Editor", BlueprintReadOnly, Config )
 	float PathNodeRotationStep;
 
+	// Maximum size of the undo history of each player, in bytes, including the node handles referenced by the edits. Oldest edits are forgotten once the history is full
+	UPROPERTY( EditAnywhere, Category = "Path Editor", Config )
+	int32 MaxPathEditHistoryBytes;
+
+	// Consecutive moves of the same path node within this time in seconds are merged into a single edit in the undo history
+	UPROPERTY( EditAnywhere, Category = "Path Editor", Config )
+	float PathEditCoalesceTime;
+
+	// Distance above the path node at which the ground snapping trace starts. Allows buried nodes to be snapped back onto the surface
+	UPROPERTY( EditAnywhere, Category = "Path Editor", Config )
+	float GroundSnapTraceHeight;
+
+	// Distance below the path node at which the ground snapping trace ends
+	UPROPERTY( EditAnywhere, Category = "Path Editor", Config )
+	float GroundSnapTraceDepth;
+
 	// Retrieves the global singleton of the settings
 	UFUNCTION( BlueprintPure, Category = "BVP Subsystem", DisplayName = "Get BVP Settings" )
 	static const UBVPSettings* Get()
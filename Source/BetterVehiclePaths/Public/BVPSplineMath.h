@@ -0,0 +1,37 @@
+﻿// Copyright Nikita Zolotukhin. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+// Single cubic hermite segment of the path spline, parametrized with alpha going from 0 at the start to 1 at the end
+struct BETTERVEHICLEPATHS_API FBVPHermiteSegment
+{
+	FVector StartLocation{ForceInit};
+	FVector StartTangent{ForceInit};
+	FVector EndLocation{ForceInit};
+	FVector EndTangent{ForceInit};
+
+	FBVPHermiteSegment() = default;
+	FBVPHermiteSegment( const FVector& InStartLocation, const FVector& InStartTangent, const FVector& InEndLocation, const FVector& InEndTangent );
+
+	FVector EvaluatePosition( double Alpha ) const;
+	FVector EvaluateDerivative( double Alpha ) const;
+	FVector EvaluateSecondDerivative( double Alpha ) const;
+
+	// Evaluates the position and the derivative at all given alphas. Alphas are processed 4 at a time using vector registers.
+	// Derivatives are optional and will not be calculated if the output view is empty
+	void EvaluateBatch( TConstArrayView<double> Alphas, TArrayView<FVector> OutPositions, TArrayView<FVector> OutDerivatives ) const;
+
+	// Evaluates the segment at NumIntervals + 1 uniformly distributed alphas, including both ends of the segment
+	void EvaluateUniform( int32 NumIntervals, TArray<FVector>& OutPositions, TArray<FVector>* OutDerivatives = nullptr ) const;
+
+	// Approximates the length of the segment by summing up the lengths of the given number of chords
+	double ComputeArcLength( int32 NumIntervals = 16 ) const;
+
+	// Finds the alpha of the point on the segment closest to the given location. Uses a coarse batched search followed by a few newton iterations
+	double FindClosestAlpha( const FVector& Location, int32 NumCoarseIntervals = 16 ) const;
+
+	// Finds the alphas of the closest pair of points between this segment and the other one. Uses a coarse search over the sample pairs followed by alternating closest point refinement
+	void FindClosestAlphas( const FBVPHermiteSegment& OtherSegment, double& OutAlpha, double& OutOtherAlpha, int32 NumCoarseIntervals = 8 ) const;
+};
@@ -4,7 +4,15 @@
 
 #include "CoreMinimal.h"
 #include "FGRemoteCallObject.h"
+#include "BVPPathAnalysis.h"
+#include "BVPPathConflictDetector.h"
+#include "BVPPathEditHistory.h"
+#include "BVPPathExport.h"
+#include "BVPPathNodeSpatialIndex.h"
+#include "BVPSplineMath.h"
+#include "Engine/NetSerialization.h"
 #include "Subsystems/WorldSubsystem.h"
+#include "WorldCollision.h"
 #include "BVPSubsystem.generated.h"
 
 // Pre-declarations
@@ -20,6 +28,11 @@ struct FHitResult;
 class FBVPVehiclePathVisualization;
 class UBVPSubsystem;
 class FBVPPlayerVisualizationTracker;
+class FBVPVehiclePathSegmentVisualization;
+class ABVPPathVisualizationActor;
+class ULineBatchComponent;
+class UMaterialInstanceDynamic;
+class UBVPRemoteCallObject;
 
 enum class EBVPPathVisualizationType : uint8;
 
@@ -42,6 +55,114 @@ struct BETTERVEHICLEPATHS_API FBVPVehiclePathSegmentHit
 };
 
 DECLARE_DYNAMIC_MULTICAST_DELEGATE_TwoParams( FBVPOnNewPathNodeCreated, AFGTargetPoint*, NewPathNode, AFGPlayerController*, OwnerPlayerController );
+DECLARE_DYNAMIC_MULTICAST_DELEGATE_OneParam( FBVPOnPathImported, AFGDrivingTargetList*, NewTargetList );
+DECLARE_DYNAMIC_MULTICAST_DELEGATE_FourParams( FBVPOnGroundSnapCompleted, AFGPlayerController*, OwnerPlayerController, bool, bSuccess, int32, NumSnappedPathNodes, const FText&, ErrorMessage );
+
+// Ground snapping operation waiting for its traces to complete
+struct FBVPPendingGroundSnap
+{
+	TWeakObjectPtr<AFGPlayerController> PlayerController;
+	TArray<TWeakObjectPtr<AFGTargetPoint>> PathNodes;
+	// Ground hit for each path node, if the trace has hit anything
+	TArray<TOptional<FHitResult>> GroundHits;
+	int32 NumPendingTraces{};
+	bool bAlignToSurface{};
+};
+
+// Imported path whose nodes are being spawned over multiple frames
+struct FBVPPendingPathImport
+{
+	// Target list the nodes are spawned into. Spawned once the import of this path begins
+	TWeakObjectPtr<AFGDrivingTargetList> TargetList;
+	// Player that has requested the import, counted against the limit of pending imports per player
+	TWeakObjectPtr<AFGPlayerController> PlayerController;
+	FBVPExportedPath Path;
+	int32 NumSpawnedPathNodes{};
+};
+
+// State of a path on a client at the end of the edit stress test, sent to the server to compare it with its own
+USTRUCT()
+struct FBVPEditStressTestPathReport
+{
+	GENERATED_BODY()
+
+	UPROPERTY()
+	AFGDrivingTargetList* TargetList{};
+
+	// Locations and target speeds of the nodes of the path in order, starting at its first node
+	UPROPERTY()
+	TArray<FVector_NetQuantize> Locations;
+
+	UPROPERTY()
+	TArray<int32> TargetSpeeds;
+};
+
+// Randomized edit load issued on a client through the same server RPCs the edits of the player use, used to find out how many concurrent editors
+// the server can sustain. A single client only has one player, connection and edit history, so the concurrency comes from running the test on several
+// client processes at once, for example a number of clients started with -nullrhi connected to a dedicated server started with -server
+struct FBVPEditStressTest
+{
+	// Player the edits are issued on behalf of
+	TWeakObjectPtr<AFGPlayerController> PlayerController;
+	FRandomStream RandomStream;
+	// Multiplier of the edit rate of this client. The edits are still issued by the one player, so it does not simulate more editors
+	int32 EditRateMultiplier{};
+	float EditsPerSecond{};
+	double EndTime{};
+	// Time at which the paths are compared with the server, once the last edits have had the time to replicate back
+	double SettleEndTime{};
+	// Fractional edits carried over between frames, so that low rates still issue edits at the right pace
+	double PendingEdits{};
+	int32 NumEditsSent{};
+	// Edits rejected by the checks on the client, which never reach the server
+	int32 NumEditsRejectedLocally{};
+
+	// Bandwidth of the connection to the server in bytes per second, and the number of unacknowledged reliable bunches on the actor channel of the player, sampled every frame
+	double TotalInBytesPerSecond{};
+	double TotalOutBytesPerSecond{};
+	int32 MaxOutBytesPerSecond{};
+	double TotalNumOutReliableBunches{};
+	int32 MaxNumOutReliableBunches{};
+	int32 NumSamples{};
+
+	bool bRunning{};
+	bool bSettling{};
+};
+
+// Paths reported by a client taking part in the server side of the edit stress test
+struct FBVPServerEditStressTestClient
+{
+	// Server paths the client has reported. Repeated reports of the same path are ignored, and the paths not in it are missing on the client
+	TSet<const AFGDrivingTargetList*> ReportedTargetLists;
+	// Reported paths the server does not know about. Only counted, as their number is not bounded by the paths of the server
+	int32 NumUnknownPaths{};
+	int32 NumPathMismatches{};
+};
+
+// Server side of the edit stress test, measuring the cost of the edits received from all clients taking part in it
+struct FBVPServerEditStressTest
+{
+	// Clients that have begun the test and have not reported its end yet
+	TMap<TWeakObjectPtr<AFGPlayerController>, FBVPServerEditStressTestClient> ActiveClients;
+
+	// Server edit counters at the start of the test, and the number of edits the clients have reported sending
+	int32 StartNumServerEdits{};
+	int32 StartNumRejectedServerEdits{};
+	int32 NumEditsSent{};
+
+	// Time spent in the server edit handlers, in seconds
+	double TotalHandlerTime{};
+	double MaxHandlerTime{};
+
+	// Busy time of the game thread per frame, excluding the time spent idle waiting for the next tick, in seconds
+	double LastFrameTimestamp{};
+	double TotalGameThreadTime{};
+	double MaxGameThreadTime{};
+	int32 NumFrames{};
+
+	// Paths whose state on a client has not matched the server at the end of the test
+	int32 NumPathMismatches{};
+};
 
 UCLASS( BlueprintType )
 class BETTERVEHICLEPATHS_API UBVPSubsystem : public UTickableWorldSubsystem
@@ -54,6 +175,7 @@ public:
 	// Begin UTickableWorldSubsystem interface
 	virtual bool DoesSupportWorldType(const EWorldType::Type WorldType) const override;
 	virtual void Initialize(FSubsystemCollectionBase& Collection) override;
+	virtual void Deinitialize() override;
 	virtual void OnWorldBeginPlay(UWorld& InWorld) override;
 	virtual void Tick(float DeltaTime) override;
 	virtual TStatId GetStatId() const override;
@@ -95,6 +217,204 @@ public:
 	UFUNCTION( BlueprintCallable, Category = "BVP Subsystem" )
 	bool MovePathNode( AFGPlayerController* PlayerController, AFGTargetPoint* TargetPoint, const FVector& NewLocation, const FRotator& NewRotation, bool bClientPrediction, FText& OutErrorMessage );
 	
+	// Finds all path nodes whose screen position is within the given rectangle, up to the trace distance of the player. Rectangle corners can be given in any order
+	UFUNCTION( BlueprintCallable, Category = "BVP Subsystem" )
+	void FindPathNodesInScreenRect( APlayerController* PlayerController, const FVector2D& RectStart, const FVector2D& RectEnd, TArray<AFGTargetPoint*>& OutPathNodes ) const;
+
+	// Moves all of the given path nodes by the offset as a single edit. Paths of the affected lists are rebuilt once
+	UFUNCTION( BlueprintCallable, Category = "BVP Subsystem" )
+	bool TranslatePathNodes( AFGPlayerController* PlayerController, const TArray<AFGTargetPoint*>& PathNodes, const FVector& Offset, FText& OutErrorMessage );
+
+	// Rotates all of the given path nodes around the pivot as a single edit. Paths of the affected lists are rebuilt once
+	UFUNCTION( BlueprintCallable, Category = "BVP Subsystem" )
+	bool RotatePathNodes( AFGPlayerController* PlayerController, const TArray<AFGTargetPoint*>& PathNodes, const FVector& Pivot, const FRotator& Rotation, FText& OutErrorMessage );
+
+	// Removes all of the given path nodes as a single edit. Paths of the affected lists are rebuilt once
+	UFUNCTION( BlueprintCallable, Category = "BVP Subsystem" )
+	bool RemovePathNodes( AFGPlayerController* PlayerController, const TArray<AFGTargetPoint*>& PathNodes, FText& OutErrorMessage );
+
+	// Moves all nodes of the path by the offset as a single edit. Only a single transform is sent to the server instead of every node
+	UFUNCTION( BlueprintCallable, Category = "BVP Subsystem" )
+	bool TranslatePath( AFGPlayerController* PlayerController, AFGDrivingTargetList* TargetPointList, const FVector& Offset, FText& OutErrorMessage );
+
+	// Rotates all nodes of the path around the pivot as a single edit
+	UFUNCTION( BlueprintCallable, Category = "BVP Subsystem" )
+	bool RotatePath( AFGPlayerController* PlayerController, AFGDrivingTargetList* TargetPointList, const FVector& Pivot, const FRotator& Rotation, FText& OutErrorMessage );
+
+	// Mirrors all nodes of the path across the plane as a single edit. Nodes keep facing along the mirrored path
+	UFUNCTION( BlueprintCallable, Category = "BVP Subsystem" )
+	bool MirrorPath( AFGPlayerController* PlayerController, AFGDrivingTargetList* TargetPointList, const FVector& PlaneOrigin, const FVector& PlaneNormal, FText& OutErrorMessage );
+
+	// Moves the nodes from the first node to the last one inclusive, following the direction of the path, by the offset as a single edit.
+	// Only the distances between the ends of the range and their unmoved neighbours are checked, since the range moves rigidly
+	UFUNCTION( BlueprintCallable, Category = "BVP Subsystem" )
+	bool TranslatePathRange( AFGPlayerController* PlayerController, AFGTargetPoint* FirstPathNode, AFGTargetPoint* LastPathNode, const FVector& Offset, FText& OutErrorMessage );
+
+	// Rotates the nodes from the first node to the last one inclusive around the pivot as a single edit
+	UFUNCTION( BlueprintCallable, Category = "BVP Subsystem" )
+	bool RotatePathRange( AFGPlayerController* PlayerController, AFGTargetPoint* FirstPathNode, AFGTargetPoint* LastPathNode, const FVector& Pivot, const FRotator& Rotation, FText& OutErrorMessage );
+
+	// Mirrors the nodes from the first node to the last one inclusive across the plane as a single edit
+	UFUNCTION( BlueprintCallable, Category = "BVP Subsystem" )
+	bool MirrorPathRange( AFGPlayerController* PlayerController, AFGTargetPoint* FirstPathNode, AFGTargetPoint* LastPathNode, const FVector& PlaneOrigin, const FVector& PlaneNormal, FText& OutErrorMessage );
+
+	// Checks if the given path nodes can be moved to the new transforms. If the transform is rigid, only the links between moved and unmoved nodes are checked.
+	// Transforms claimed to be rigid are verified against the current transforms of the nodes, and have all of their links checked if they are not
+	static bool CheckCanApplyPathNodeTransforms( const TArray<AFGTargetPoint*>& PathNodes, const TArray<FTransform>& NewTransforms, bool bRigidTransform, FText& OutErrorMessage );
+
+	UFUNCTION( BlueprintPure, Category = "BVP Subsystem" )
+	static bool CheckCanRemovePathNodes( const TArray<AFGTargetPoint*>& PathNodes, FText& OutErrorMessage );
+
+	// Removes the nodes of the path that are not needed to keep the path within the tolerance of the original spline, as a single edit.
+	// Nodes with speed differences beyond the threshold are preserved, and the remaining nodes stay within the maximum distance of each other
+	UFUNCTION( BlueprintCallable, Category = "BVP Subsystem" )
+	bool SimplifyPath( AFGPlayerController* PlayerController, AFGDrivingTargetList* TargetPointList, float Tolerance, int32 SpeedChangeThreshold, int32& OutNumRemovedNodes, FText& OutErrorMessage );
+
+	// Redistributes the nodes of the path along the existing spline at uniform arc length spacing, interpolating target speeds and rotations, as a single edit.
+	// Spacing is clamped between the minimum and maximum distance between path nodes, and adjusted so that the loop is divided evenly
+	UFUNCTION( BlueprintCallable, Category = "BVP Subsystem" )
+	bool ResamplePath( AFGPlayerController* PlayerController, AFGDrivingTargetList* TargetPointList, float Spacing, int32& OutNumPathNodes, FText& OutErrorMessage );
+
+	// Computes the target speeds for all nodes of the path from its curvature and grade, limited by the acceleration settings, and applies them as a single edit.
+	// Outputs the new target speeds in the order of the path nodes
+	UFUNCTION( BlueprintCallable, Category = "BVP Subsystem" )
+	bool OptimizePathTargetSpeeds( AFGPlayerController* PlayerController, AFGDrivingTargetList* TargetPointList, TArray<int32>& OutTargetSpeeds, FText& OutErrorMessage );
+
+	// Cuts the nodes from the first node to the last one inclusive out of their path into a new path. Both paths are closed into loops at the cut,
+	// so the last node has to be close enough to the first one, and the nodes around the cut have to be close enough to each other
+	UFUNCTION( BlueprintCallable, Category = "BVP Subsystem" )
+	bool SplitPathAtNode( AFGPlayerController* PlayerController, AFGTargetPoint* FirstPathNode, AFGTargetPoint* LastPathNode, FText& OutErrorMessage );
+
+	// Splices all nodes of another path into the path after the given node, starting at the first merged node and following the merged path around.
+	// The merged path is destroyed afterwards. Nodes at both seams have to be close enough to each other
+	UFUNCTION( BlueprintCallable, Category = "BVP Subsystem" )
+	bool MergePaths( AFGPlayerController* PlayerController, AFGTargetPoint* AfterPathNode, AFGTargetPoint* FirstMergedPathNode, FText& OutErrorMessage );
+
+	// Reverses the direction of the path in place by relinking its nodes in the reverse order and turning them around.
+	// Target speeds are shifted along with the segments, so every segment keeps its speed when driven in the other direction
+	UFUNCTION( BlueprintCallable, Category = "BVP Subsystem" )
+	bool ReversePath( AFGPlayerController* PlayerController, AFGDrivingTargetList* TargetPointList, FText& OutErrorMessage );
+
+	// Estimates the time it takes a vehicle to drive the whole loop and each of its segments by following the target speeds within the acceleration limits.
+	// Results are cached for the visualized paths until their geometry or target speeds change
+	UFUNCTION( BlueprintCallable, Category = "BVP Subsystem" )
+	bool EstimatePathTravelTime( AFGDrivingTargetList* TargetPointList, FBVPPathTravelTimeEstimate& OutEstimate );
+
+	// Estimates the throughput of the route driven by the given number of vehicles carrying the given amount of cargo per trip.
+	// Station time is the time each vehicle spends loading and unloading per trip. Assumes that the vehicles do not block each other
+	UFUNCTION( BlueprintCallable, Category = "BVP Subsystem" )
+	bool EstimatePathThroughput( AFGDrivingTargetList* TargetPointList, int32 NumVehicles, float CargoPerTrip, float StationTime, FBVPPathThroughputEstimate& OutEstimate );
+
+	// Returns the metrics of the segment starting at the given path node. Only available for the paths that are currently visualized
+	UFUNCTION( BlueprintCallable, Category = "BVP Subsystem" )
+	bool GetPathSegmentMetrics( const AFGTargetPoint* SegmentStartNode, FBVPPathSegmentMetrics& OutMetrics ) const;
+
+	// Returns the metrics of all segments of the path in the order of the path nodes. Only available for the paths that are currently visualized
+	UFUNCTION( BlueprintCallable, Category = "BVP Subsystem" )
+	bool GetAllPathSegmentMetrics( const AFGDrivingTargetList* TargetPointList, TArray<FBVPPathSegmentMetrics>& OutMetrics ) const;
+
+	// Returns the estimated travel time and the length of the segment starting at the given path node, and the lap time of its path
+	UFUNCTION( BlueprintCallable, Category = "BVP Subsystem" )
+	bool GetPathSegmentTravelTime( AFGTargetPoint* SegmentStartNode, float& OutTravelTime, float& OutSegmentLength, float& OutLapTime );
+
+	// Returns the problems found on all paths by the background problem detector. Paths are re-analyzed over multiple frames after their geometry or target speeds change
+	UFUNCTION( BlueprintCallable, Category = "BVP Subsystem" )
+	void GetAllPathProblems( TArray<FBVPPathProblem>& OutProblems ) const;
+
+	// Returns the problems found on the given path by the background problem detector
+	UFUNCTION( BlueprintCallable, Category = "BVP Subsystem" )
+	void GetPathProblems( const AFGDrivingTargetList* TargetPointList, TArray<FBVPPathProblem>& OutProblems ) const;
+
+	// Returns the conflicts between the segments of different paths found by the background conflict detector. Updated when the geometry of any path changes
+	UFUNCTION( BlueprintCallable, Category = "BVP Subsystem" )
+	void GetAllPathConflicts( TArray<FBVPPathConflict>& OutConflicts ) const;
+
+	// Returns the conflicts between the segments of the given path and the segments of other paths
+	UFUNCTION( BlueprintCallable, Category = "BVP Subsystem" )
+	void GetPathConflicts( const AFGDrivingTargetList* TargetPointList, TArray<FBVPPathConflict>& OutConflicts ) const;
+
+	// Snaps the given path nodes to the ground below them, optionally aligning them with the surface. Ground is found with asynchronous traces over the next frames,
+	// after which all nodes are moved as a single edit and OnGroundSnapCompleted is broadcast. Nodes without any ground below them are left in place
+	UFUNCTION( BlueprintCallable, Category = "BVP Subsystem" )
+	bool SnapPathNodesToGround( AFGPlayerController* PlayerController, const TArray<AFGTargetPoint*>& PathNodes, bool bAlignToSurface, FText& OutErrorMessage );
+
+	// Snaps all nodes of the path to the ground below them. See SnapPathNodesToGround
+	UFUNCTION( BlueprintCallable, Category = "BVP Subsystem" )
+	bool SnapPathToGround( AFGPlayerController* PlayerController, AFGDrivingTargetList* TargetPointList, bool bAlignToSurface, FText& OutErrorMessage );
+
+	// Checks the distances between the path nodes, duplicate nodes, target speed ranges and the links of the path. Returns true if the path has no violations other than warnings
+	UFUNCTION( BlueprintCallable, Category = "BVP Subsystem" )
+	bool ValidatePath( AFGDrivingTargetList* TargetPointList, TArray<FBVPPathViolation>& OutViolations ) const;
+
+	// Validates all paths in the world. Returns true if none of the paths have any violations other than warnings
+	UFUNCTION( BlueprintCallable, Category = "BVP Subsystem" )
+	bool ValidateAllPaths( TArray<FBVPPathViolation>& OutViolations ) const;
+
+	// Collects all target lists in the world. Clients do not have the list of target lists, so they collect them from the world instead
+	void GetAllTargetLists( TArray<AFGDrivingTargetList*>& OutTargetLists ) const;
+
+	// Encodes the given paths into the compact binary path format. Returns false if none of the paths have any nodes
+	UFUNCTION( BlueprintCallable, Category = "BVP Subsystem" )
+	bool ExportPaths( const TArray<AFGDrivingTargetList*>& TargetPointLists, TArray<uint8>& OutData ) const;
+
+	// Encodes the given paths into a Base64 string that can be easily shared
+	UFUNCTION( BlueprintCallable, Category = "BVP Subsystem" )
+	bool ExportPathsToString( const TArray<AFGDrivingTargetList*>& TargetPointLists, FString& OutString ) const;
+
+	// Encodes the given paths and saves them to the file
+	UFUNCTION( BlueprintCallable, Category = "BVP Subsystem" )
+	bool ExportPathsToFile( const TArray<AFGDrivingTargetList*>& TargetPointLists, const FString& FilePath, FText& OutErrorMessage ) const;
+
+	// Imports the paths from the binary path format into new target lists. Nodes are spawned over multiple frames, and OnPathImported is broadcast on the server once each path is complete
+	UFUNCTION( BlueprintCallable, Category = "BVP Subsystem" )
+	bool ImportPaths( AFGPlayerController* PlayerController, const TArray<uint8>& Data, FText& OutErrorMessage );
+
+	// Imports the paths from a Base64 string. See ImportPaths
+	UFUNCTION( BlueprintCallable, Category = "BVP Subsystem" )
+	bool ImportPathsFromString( AFGPlayerController* PlayerController, const FString& String, FText& OutErrorMessage );
+
+	// Imports the paths from the file. The file is read on the local machine. See ImportPaths
+	UFUNCTION( BlueprintCallable, Category = "BVP Subsystem" )
+	bool ImportPathsFromFile( AFGPlayerController* PlayerController, const FString& FilePath, FText& OutErrorMessage );
+
+	// Undoes the last move, removal, creation or target speed change of a path node made by the player. Edits are validated the same way as when they have been made
+	UFUNCTION( BlueprintCallable, Category = "BVP Subsystem" )
+	bool UndoPathEdit( AFGPlayerController* PlayerController, FText& OutErrorMessage );
+
+	// Redoes the last edit undone by the player
+	UFUNCTION( BlueprintCallable, Category = "BVP Subsystem" )
+	bool RedoPathEdit( AFGPlayerController* PlayerController, FText& OutErrorMessage );
+
+	// Starts issuing randomized edits through the server RPCs of the player, at the given rate multiplied by the rate multiplier.
+	// Once the duration has passed, logs the bandwidth and the reliable RPC backlog of the connection, and sends the state of the paths to the server,
+	// which logs the paths that do not match along with its own edit handler and game thread times. Only available on clients connected to a server
+	bool StartEditStressTest( AFGPlayerController* PlayerController, int32 EditRateMultiplier, float EditsPerSecond, float Duration, int32 RandomSeed );
+	// Stops issuing the edits early. The paths are still compared with the server once the last edits have replicated
+	void StopEditStressTest();
+	FORCEINLINE bool IsEditStressTestRunning() const { return EditStressTest.bRunning || EditStressTest.bSettling; }
+
+	// Distance the node locations of a path may differ by between the client and the server, covering the quantization of the replicated locations and of the report
+	static constexpr double EditStressTestLocationTolerance = 2.0;
+	// Captures the order, locations and target speeds of the nodes of the path, and compares them with the current state of a path within the tolerance
+	static void BuildEditStressTestPathReport( AFGDrivingTargetList* TargetPointList, FBVPEditStressTestPathReport& OutReport );
+	static bool DoesPathMatchEditStressTestReport( const AFGDrivingTargetList* TargetPointList, const FBVPEditStressTestPathReport& Report );
+
+	// Number of edits received by the server edit handlers, and the number of them rejected, since the world has started
+	FORCEINLINE int32 GetNumServerEdits() const { return NumServerEdits; }
+	FORCEINLINE int32 GetNumRejectedServerEdits() const { return NumRejectedServerEdits; }
+
+	// Returns the path node closest to the location within the given distance. Does not require path visualization to be enabled
+	UFUNCTION( BlueprintCallable, Category = "BVP Subsystem" )
+	AFGTargetPoint* FindNearestPathNode( const FVector& Location, float MaxDistance ) const;
+
+	// Finds all path nodes within the radius of the location
+	UFUNCTION( BlueprintCallable, Category = "BVP Subsystem" )
+	void FindPathNodesInRadius( const FVector& Location, float Radius, TArray<AFGTargetPoint*>& OutPathNodes ) const;
+
+	// Finds all path nodes inside of the given box
+	UFUNCTION( BlueprintCallable, Category = "BVP Subsystem" )
+	void FindPathNodesInBox( const FBox& Box, TArray<AFGTargetPoint*>& OutPathNodes ) const;
+
 	UFUNCTION( BlueprintCallable, Category = "BVP Subsystem" )
 	void SetVisualizationRequesterState( APlayerController* Requester, FName VisualizationId,
 		UPARAM( meta = (Bitmask, BitmaskEnum = "/Script/BetterVehiclePaths.EBVPPathVisualizationType") ) EBVPPathVisualizationType VisualizationType, bool bVisualizationEnabled );
@@ -109,36 +429,207 @@ public:
 	
 	const TArray<FBVPVehiclePathVisualization*>& GetAllVisualizedPaths() const { return VisualizedPaths; }
 	const TArray<FBVPPlayerVisualizationTracker*>& GetAllPlayerTrackers() const { return VisualizationTrackers; }
+	void CollectAllVisualizationSegments( TArray<FBVPVehiclePathSegmentVisualization*>& OutAllSegments );
+
+	// Hibernated segments are kept in the order they have been hibernated in, and released once they expire or the component limit is exceeded
+	void AddHibernatedSegment( FBVPVehiclePathSegmentVisualization* SegmentVisualization );
+	void RemoveHibernatedSegment( FBVPVehiclePathSegmentVisualization* SegmentVisualization );
+
+	// Slots index the state the visualization trackers keep for each segment in flat arrays. Slots of destroyed segments are reused by the new ones
+	int32 AllocateSegmentStateSlot();
+	void ReleaseSegmentStateSlot( int32 SlotIndex );
+	FORCEINLINE int32 GetNumSegmentStateSlots() const { return NumSegmentStateSlots; }
 
 	static AFGTargetPoint* FindPrevTargetPoint( const AFGTargetPoint* TargetPoint );
 	static AFGTargetPoint* FindNextTargetPoint( const AFGTargetPoint* TargetPoint );
 	// This function is needed because the spline point mapping to target points is a bit weird and first 2 points are actually last 2 points of the list
 	static AFGTargetPoint* GetTargetPointAtSplinePoint( const AFGDrivingTargetList* TargetPointList, int32 SplinePointIndex, int32 NumSplinePoints );
+	// Builds the hermite segments of the path spline, one per path node, in the order of the nodes. The path must have a valid path spline built!
+	static void GetPathHermiteSegments( const AFGDrivingTargetList* TargetPointList, TArray<FBVPHermiteSegment>& OutSegments );
+	// Collects the nodes of the target list in order with a single walk of the linked list
+	static void GetTargetListPathNodes( const AFGDrivingTargetList* TargetPointList, TArray<AFGTargetPoint*>& OutPathNodes );
+	// Recalculates the target count if we have authority and rebuilds the path spline of the list if it is complete
+	static void RebuildTargetListPath( AFGDrivingTargetList* TargetPointList );
 protected:
 	friend class UBVPRemoteCallObject;
 	
-	AFGTargetPoint* CreatePawnPathNodeInternal( AFGTargetPoint* AfterPoint, const FVector& NewLocation, const FRotator& NewRotation, int32 TargetSpeed ) const;
+	AFGTargetPoint* CreatePawnPathNodeInternal( AFGTargetPoint* AfterPoint, const FVector& NewLocation, const FRotator& NewRotation, int32 TargetSpeed );
+	// Spawns a new node and inserts it after the given one without rebuilding the path. Used by the edits that spawn multiple nodes at once
+	AFGTargetPoint* SpawnPathNodeInternal( AFGTargetPoint* AfterPoint, const FTransform& Transform, int32 TargetSpeed );
 	static bool CheckDistanceBetweenTwoPoints( const FVector& LocationA, const FVector& LocationB );
+	// Returns true if the location is finite and inside of the world bounds, where the engine does not destroy the actors placed at it
+	static bool IsLocationInWorldBounds( const FVector& Location );
+
+	// Applies the transforms to the nodes without checking them, and rebuilds the path of each affected list once
+	void SetPathNodeTransformsInternal( const TArray<AFGTargetPoint*>& PathNodes, const TArray<FTransform>& NewTransforms );
+	void RemovePathNodesInternal( const TArray<AFGTargetPoint*>& PathNodes );
+	void ResamplePathInternal( AFGDrivingTargetList* TargetPointList, const TArray<FTransform>& NewTransforms, const TArray<int32>& NewTargetSpeeds );
+	// Collects the nodes from the first node to the last one inclusive, wrapping around the end of the path. Returns false if the last node is not in the same list
+	static bool GetPathNodeRange( AFGTargetPoint* FirstPathNode, AFGTargetPoint* LastPathNode, TArray<AFGTargetPoint*>& OutPathNodes );
+	// Applies the rigid or mirroring transform to the range of nodes, checking only the boundaries of the range. Clients predict the edit and send the transform to the server
+	bool TransformPathRangeInternal( AFGPlayerController* PlayerController, AFGTargetPoint* FirstPathNode, AFGTargetPoint* LastPathNode, const FMatrix& Transform, FText& OutErrorMessage );
+	// Computes the nodes spaced evenly along the path. Fails if no spacing keeps the distances between the nodes within the limits
+	static bool ComputeResampledPathNodes( const AFGDrivingTargetList* TargetPointList, float Spacing, TArray<FTransform>& OutTransforms, TArray<int32>& OutTargetSpeeds );
+	// Places the given number of nodes at equal arc length intervals, using the cumulative length table of the path segments
+	static void SampleResampledPathNodes( const TArray<AFGTargetPoint*>& PathNodes, const TArray<FBVPHermiteSegment>& PathSegments, const TArray<double>& CumulativeLengths,
+		int32 NumSamplesPerSegment, int32 NumNewPathNodes, TArray<FTransform>& OutTransforms, TArray<int32>& OutTargetSpeeds );
+	void ReversePathInternal( AFGDrivingTargetList* TargetPointList );
+	void SplitPathInternal( const TArray<AFGTargetPoint*>& SplitPathNodes );
+	void MergePathsInternal( AFGTargetPoint* AfterPathNode, const TArray<AFGTargetPoint*>& MergedPathNodes );
+	// Returns true if any vehicle has the target list assigned to it, which means the list cannot be destroyed
+	bool IsTargetListUsedByVehicles( const AFGDrivingTargetList* TargetPointList ) const;
+	// Returns true if any vehicle using the target list is currently heading to one of the given nodes of it
+	bool IsPathNodeRangeUsedByVehicles( const AFGDrivingTargetList* TargetPointList, const TArray<AFGTargetPoint*>& PathNodes ) const;
+	// Spawns a new empty target list. It is not known to the vehicles until it is registered
+	AFGDrivingTargetList* SpawnTargetListInternal();
+	// Registers the target list with the vehicle subsystem. Done once all of its nodes are in place
+	void RegisterTargetListInternal( AFGDrivingTargetList* TargetPointList );
+	// Marks the target list as complete the same way a finished recording does, so that its path can be built
+	static void MarkTargetListComplete( AFGDrivingTargetList* TargetPointList );
+	// Links the nodes into the target list in the given order and makes the list their owner, without rebuilding the path
+	void LinkPathNodesInternal( AFGDrivingTargetList* TargetPointList, const TArray<AFGTargetPoint*>& PathNodes );
+	static bool ComputeOptimizedTargetSpeeds( const AFGDrivingTargetList* TargetPointList, TArray<int32>& OutTargetSpeeds );
+	static bool ComputePathTravelTime( const AFGDrivingTargetList* TargetPointList, FBVPPathTravelTimeEstimate& OutEstimate );
+	FBVPVehiclePathVisualization* FindPathVisualization( const AFGDrivingTargetList* TargetPointList ) const;
+	static void FindPathNodesToSimplify( const AFGDrivingTargetList* TargetPointList, float Tolerance, int32 SpeedChangeThreshold, TArray<AFGTargetPoint*>& OutRemovedPathNodes );
+	bool ApplyPathNodeTransformsInternal( AFGPlayerController* PlayerController, const TArray<AFGTargetPoint*>& PathNodes, const TArray<FTransform>& NewTransforms, bool bRigidTransform, FText& OutErrorMessage );
 	static float GetTraceDistanceForPlayer( const APlayerController* PlayerController );
 
 	bool TraceForPathNodeChannelInternal( const APlayerController* PlayerController, const FVector2D& ScreenPosition, TArray<FHitResult>& OutHitResults ) const;
+	// Resolves the input key of the spline closest to the hit against the path colliders by refining the closest segment only
+	float FindInputKeyClosestToHitLocation( const AFGDrivingTargetList* TargetPointList, const USplineComponent* SplineComponent, const FVector& HitLocation ) const;
 	void Input_ToggleVisualizePaths( const FInputActionValue& ActionValue, AFGCharacterPlayer* CharacterPlayer );
 	void Input_OpenPathEditor( const FInputActionValue& ActionValue, AFGCharacterPlayer* CharacterPlayer );
 	
 	void TickActiveVisualizations();
+	void TickHibernatedSegments();
 	void TickVisualizationTrackers();
+	void TickNetworkOverview();
+	void TickProblemDetector();
+	void TickLoadValidation();
+	void TickPathImports();
+	void TickEditStressTest();
+
+	// Time the garbage collection and report it next to the number of visualization objects alive
+	void OnPreGarbageCollect();
+	void OnPostGarbageCollect();
+
+	// Issues a single random edit of the stress test against a random node of one of the paths, the same way the path editor of the player would
+	void IssueStressTestEdit( AFGPlayerController* PlayerController, const TArray<AFGDrivingTargetList*>& TargetLists );
+	// Samples the connection of the client to the server while the stress test is running
+	void SampleEditStressTestConnection( const AFGPlayerController* PlayerController );
+	// Logs the report of the client and sends the state of its paths to the server
+	void FinishEditStressTest();
+	// Counts the edit received by the server edit handlers, along with the time spent handling it
+	void RecordServerEdit( bool bEditAccepted, double HandlerTime );
+
+	// Server side of the stress test. Begins when the first client starts it, and logs the report once the last one has reported its paths
+	void BeginServerEditStressTest( AFGPlayerController* PlayerController );
+	void ReportServerEditStressTestPath( AFGPlayerController* PlayerController, const FBVPEditStressTestPathReport& Report );
+	void ReportServerEditStressTest( AFGPlayerController* PlayerController, int32 NumEditsSent );
+	void FinishServerEditStressTest();
+
+	// Checks that the decoded paths can be imported without breaking the distance constraints between the nodes
+	static bool CheckCanImportPaths( const TArray<FBVPExportedPath>& Paths, FText& OutErrorMessage );
+	// Checks that queueing the paths would not exceed the limits of pending imports of the player and of the server
+	bool CheckCanQueuePathImports( AFGPlayerController* PlayerController, int32 NumPaths, FText& OutErrorMessage ) const;
+	void ImportPathsInternal( AFGPlayerController* PlayerController, TArray<FBVPExportedPath>&& Paths );
+
+	// Validates the paths affected by an edit on the server and logs the violations found
+	void ValidateEditedPaths( const TSet<AFGDrivingTargetList*>& TargetLists ) const;
+	static void LogPathViolations( const TArray<FBVPPathViolation>& Violations );
+
+	// Returns the edit history of the player if the edits made by it should be recorded. History is kept by the server, as it is the one spawning the nodes
+	FBVPPathEditHistory* FindPathEditHistoryForRecording( AFGPlayerController* PlayerController );
+	// Applies the recorded edit in either direction and rebuilds the path once. Edit is expired if its nodes have been removed by anything but the history
+	bool ApplyPathEditInternal( FBVPPathEditHistory& EditHistory, const FBVPPathEditRecord& Edit, bool bUndo, bool& bOutEditExpired, FText& OutErrorMessage );
+
+	void OnGroundSnapTraceCompleted( const FTraceHandle& TraceHandle, FTraceDatum& TraceDatum, int32 GroundSnapId );
+	void FinishGroundSnap( int32 GroundSnapId );
 public:
 	// Called when a new path node has been created through the subsystem
 	UPROPERTY( BlueprintAssignable, Transient, Category = "BVP Subsystem" )
 	FBVPOnNewPathNodeCreated OnNewPathNodeCreated;
 
+	// Called when the ground snapping operation started by this machine has finished
+	UPROPERTY( BlueprintAssignable, Transient, Category = "BVP Subsystem" )
+	FBVPOnGroundSnapCompleted OnGroundSnapCompleted;
+
+	// Called on the server when all nodes of an imported path have been spawned and its path has been built
+	UPROPERTY( BlueprintAssignable, Transient, Category = "BVP Subsystem" )
+	FBVPOnPathImported OnPathImported;
+
 protected:
 	// List of paths being currently visualized
 	TArray<FBVPVehiclePathVisualization*> VisualizedPaths;
 
+	// Paths being currently visualized keyed by their target lists
+	TMap<TObjectKey<AFGDrivingTargetList>, FBVPVehiclePathVisualization*> VisualizedPathsByTargetList;
+
 	// Visualization trackers for each player currently online
 	TArray<FBVPPlayerVisualizationTracker*> VisualizationTrackers;
 
+	// Number of segments collected the last time, used to pre-size the segment arrays
+	int32 LastNumVisualizationSegments{};
+
+	// Segment state slots released by the destroyed segments, and the total number of slots handed out so far
+	TArray<int32> FreeSegmentStateSlots;
+	int32 NumSegmentStateSlots{};
+
+	// Segments that are no longer relevant but are keeping their components around, least recently hibernated first
+	TArray<FBVPVehiclePathSegmentVisualization*> HibernatedSegments;
+
+	// Total number of components kept alive by the hibernated segments
+	int32 NumHibernatedComponents{};
+
+	// Delegates timing the garbage collection, and the time the current one has started at
+	FDelegateHandle PreGarbageCollectDelegateHandle;
+	FDelegateHandle PostGarbageCollectDelegateHandle;
+	double GarbageCollectStartTime{};
+
+	// Actor and the line batch rendering the entire path network in a single draw when the network overview is requested
+	UPROPERTY( Transient )
+	ABVPPathVisualizationActor* NetworkOverviewActor;
+
+	UPROPERTY( Transient )
+	ULineBatchComponent* NetworkOverviewLineBatch;
+
+	// Set when the set of visualized paths changes, so that the network overview lines for the removed paths are flushed
+	bool bNetworkOverviewDirty{};
+
+	// Spatial index of all path nodes. Synced with the target lists when their geometry changes, and updated directly by the edits made through the subsystem
+	FBVPPathNodeSpatialIndex PathNodeIndex;
+
+	// Index of the next path to be re-analyzed by the problem detector
+	int32 ProblemDetectorCursor{};
+
+	// Conflicts between the segments of different paths, updated when the geometry of any path changes
+	FBVPPathConflictDetector PathConflictDetector;
+
+	// Set when the world begins play, so that the paths loaded from the save are validated on the first tick
+	bool bPendingLoadValidation{};
+
+	// Ground snapping operations waiting for their traces, keyed by their ID
+	TMap<int32, FBVPPendingGroundSnap> PendingGroundSnaps;
+	int32 NextGroundSnapId{};
+
+	// Undo histories of the players that have made edits, only populated on the server
+	TMap<TWeakObjectPtr<AFGPlayerController>, FBVPPathEditHistory> PathEditHistories;
+
+	// Imported paths waiting for their nodes to be spawned, in the order they have been imported in
+	TArray<FBVPPendingPathImport> PendingPathImports;
+
+	// Edits received by the server edit handlers, and the number of them that have been rejected
+	int32 NumServerEdits{};
+	int32 NumRejectedServerEdits{};
+
+	// Edit stress test currently running on this client, and the server side of the test receiving the edits of the clients, if any
+	FBVPEditStressTest EditStressTest;
+	FBVPServerEditStressTest ServerEditStressTest;
+
+	// Travel time estimates of the visualized paths, along with the geometry generation and the target speeds they have been computed for
+	TMap<TObjectKey<AFGDrivingTargetList>, FBVPCachedTravelTimeEstimate> TravelTimeEstimateCache;
+
 public:
 	// Number of spline points in the vehicle path spline that have negative time
 	static constexpr int32 NumBacktrackSplinePoints = 2;
@@ -150,6 +641,14 @@ public:
 	UPROPERTY( Transient )
 	UMaterialInterface* PathVisualizationMaterial;
 
+	// Returns the material instance rendering the path visualization with the given color. Only used when the material does not read the color from the custom primitive data
+	UMaterialInterface* GetPathVisualizationMaterialInstance( const FLinearColor& Color );
+protected:
+	// Material instances created for each path color quantized to 8 bits per sRGB channel, shared between all components rendered with that color.
+	// Held weakly, so that an instance is collected once no component uses it anymore, and its entry is dropped after the garbage collection
+	TMap<FColor, TWeakObjectPtr<UMaterialInstanceDynamic>> PathVisualizationMaterialInstances;
+public:
+
 	UPROPERTY( Transient )
 	TSubclassOf<UFGInteractWidget> PathEditorWidget;
 
@@ -184,6 +683,55 @@ public:
 
 	UFUNCTION( Server, Reliable )
 	void Server_SetPathNodeTargetSpeed( AFGTargetPoint* TargetPoint, int32 TargetSpeed );
+
+	UFUNCTION( Server, Reliable )
+	void Server_ApplyPathNodeTransforms( const TArray<AFGTargetPoint*>& PathNodes, const TArray<FTransform>& NewTransforms, bool bRigidTransform );
+
+	UFUNCTION( Server, Reliable )
+	void Server_TransformPathRange( AFGTargetPoint* FirstPathNode, AFGTargetPoint* LastPathNode, const FMatrix& Transform );
+
+	UFUNCTION( Server, Reliable )
+	void Server_RemovePathNodes( const TArray<AFGTargetPoint*>& PathNodes );
+
+	UFUNCTION( Server, Reliable )
+	void Server_SimplifyPath( AFGDrivingTargetList* TargetPointList, float Tolerance, int32 SpeedChangeThreshold );
+
+	UFUNCTION( Server, Reliable )
+	void Server_ResamplePath( AFGDrivingTargetList* TargetPointList, float Spacing );
+
+	UFUNCTION( Server, Reliable )
+	void Server_OptimizePathTargetSpeeds( AFGDrivingTargetList* TargetPointList );
+
+	UFUNCTION( Server, Reliable )
+	void Server_ReversePath( AFGDrivingTargetList* TargetPointList );
+
+	UFUNCTION( Server, Reliable )
+	void Server_SplitPathAtNode( AFGTargetPoint* FirstPathNode, AFGTargetPoint* LastPathNode );
+
+	UFUNCTION( Server, Reliable )
+	void Server_MergePaths( AFGTargetPoint* AfterPathNode, AFGTargetPoint* FirstMergedPathNode );
+
+	UFUNCTION( Server, Reliable )
+	void Server_ImportPaths( const TArray<uint8>& Data );
+
+	UFUNCTION( Server, Reliable )
+	void Server_UndoPathEdit();
+
+	UFUNCTION( Server, Reliable )
+	void Server_RedoPathEdit();
+
+	UFUNCTION( Server, Reliable )
+	void Server_BeginEditStressTest();
+
+	// Paths are reported one per call to keep each call well below the bunch size limit, and the end of the report follows them on the same reliable channel
+	UFUNCTION( Server, Reliable )
+	void Server_ReportEditStressTestPath( const FBVPEditStressTestPathReport& Report );
+
+	UFUNCTION( Server, Reliable )
+	void Server_ReportEditStressTest( int32 NumEditsSent );
+
+	UFUNCTION( Client, Reliable )
+	void Client_ForcePathNodeTransforms( const TArray<AFGTargetPoint*>& PathNodes, const TArray<FTransform>& NewTransforms );
 private:
 	UPROPERTY( Replicated, Meta = ( NoAutoJson ) )
 	bool ForceNetField_UBVPRemoteCallObject = false;
@@ -4,11 +4,27 @@
 
 #include "CoreMinimal.h"
 #include "UObject/Object.h"
+#include "BVPPathAnalysis.h"
+#include "BVPSplineMath.h"
 
 class FBVPVehiclePathVisualization;
 class USplineMeshComponent;
+class AFGTargetPoint;
 class UBoxComponent;
 struct FBVPSegmentColliderInfo;
+struct FBatchedLine;
+struct FBVPSegmentRelevanceData;
+
+// Level of detail at which the segment is visualized
+enum class EBVPSegmentVisualizationLOD : uint8
+{
+	// Segment is rendered using its own spline mesh
+	Full,
+	// Segment is merged with adjacent nearly straight segments into a single spline mesh owned by the path
+	Merged,
+	// Segment is rendered as a polyline by the path
+	Line
+};
 
 // Visualization of a single segment of the path spline
 class BETTERVEHICLEPATHS_API FBVPVehiclePathSegmentVisualization
@@ -16,39 +32,112 @@ class BETTERVEHICLEPATHS_API FBVPVehiclePathSegmentVisualization
 protected:
 	FBVPVehiclePathVisualization* OwnerVisualization{};
 	int32 SegmentIndex{INDEX_NONE};
+	// Index of the state of this segment in the visualization trackers, allocated from the subsystem for the lifetime of the segment
+	int32 StateSlotIndex{INDEX_NONE};
 	FVector ArriveLocation;
 	FVector ArriveTangent;
 	FVector LeaveLocation;
 	FVector LeaveTangent;
+	FBox SegmentBounds{ForceInit};
+
+	// Path nodes the segment starts and ends at, assigned by the path visualization every update
+	TWeakObjectPtr<AFGTargetPoint> StartPathNode;
+	TWeakObjectPtr<AFGTargetPoint> EndPathNode;
+
+	// Metrics of the segment curve, recalculated when the geometry or the target speeds of the segment change
+	FBVPPathSegmentMetrics SegmentMetrics;
 	
-	USplineMeshComponent* VisualizationComponent{};
-	TArray<UBoxComponent*> CollisionComponents;
+	// Components are owned by the visualization actor of the path, the segment only keeps weak handles to them
+	TWeakObjectPtr<USplineMeshComponent> VisualizationComponent;
+	TArray<TWeakObjectPtr<UBoxComponent>> CollisionComponents;
 
 	int32 VisualizationRequestCounter{};
 	int32 CollisionRequestCounter{};
 	bool bNeedsVisualizationRebuild{};
 	bool bNeedsCollisionRebuild{};
+
+	// Color to render the segment with instead of the path color, passed to the shared material through the custom primitive data
+	TOptional<FLinearColor> ColorOverride;
+
+	// LOD the segment is currently visualized at, and the distance to the closest observer reported by the trackers since the last update
+	EBVPSegmentVisualizationLOD VisualizationLOD{EBVPSegmentVisualizationLOD::Full};
+	double ClosestObserverDistance{UE_BIG_NUMBER};
+
+	// Time at which the segment has lost all of its requests and was hibernated, or negative if the segment is not hibernated
+	double HibernationStartTime{-1.0};
+	// Number of components the segment had when it was hibernated, as accounted for in the hibernation budget of the subsystem
+	int32 NumHibernatedComponents{};
 public:
 	FBVPVehiclePathSegmentVisualization( FBVPVehiclePathVisualization* InOwner, int32 InSegmentIndex );
+	~FBVPVehiclePathSegmentVisualization();
 	
 	void AddRemoveVisualizationRequest( bool bRemove );
 	void AddRemoveCollisionRequest( bool bRemove );
 
+	// Assigns the path nodes at the ends of the segment. Returns true if the start path node has changed
+	bool SetSegmentPathNodes( AFGTargetPoint* InStartPathNode, AFGTargetPoint* InEndPathNode );
+
 	// Updates the segment with the new spline data. The path must have a valid path spline built!
 	void UpdateSegmentWithNewSpline();
 	
 	bool IsSegmentUpToDate() const;
 	bool IsSegmentRelevantForObserver( const FVector& ObserverLocation, double RelevanceDistance ) const;
+	// Copies the data needed for the relevance evaluation into the packed representation
+	void GetRelevanceData( FBVPSegmentRelevanceData& OutRelevanceData ) const;
+
+	FORCEINLINE const FBox& GetSegmentBounds() const { return SegmentBounds; }
+	FORCEINLINE const FVector& GetArriveLocation() const { return ArriveLocation; }
+	FORCEINLINE const FVector& GetArriveTangent() const { return ArriveTangent; }
+	FORCEINLINE const FVector& GetLeaveLocation() const { return LeaveLocation; }
+	FORCEINLINE const FVector& GetLeaveTangent() const { return LeaveTangent; }
+	FORCEINLINE int32 GetSegmentIndex() const { return SegmentIndex; }
+	FORCEINLINE int32 GetStateSlotIndex() const { return StateSlotIndex; }
+	// Moves the segment to another position in the path. The geometry is re-read from the spline on the next update
+	FORCEINLINE void SetSegmentIndex( int32 NewSegmentIndex ) { SegmentIndex = NewSegmentIndex; }
+	FORCEINLINE AFGTargetPoint* GetStartPathNode() const { return StartPathNode.Get(); }
+	FORCEINLINE AFGTargetPoint* GetEndPathNode() const { return EndPathNode.Get(); }
+	FORCEINLINE const FBVPPathSegmentMetrics& GetSegmentMetrics() const { return SegmentMetrics; }
+	FORCEINLINE FBVPHermiteSegment GetHermiteSegment() const { return FBVPHermiteSegment( ArriveLocation, ArriveTangent, LeaveLocation, LeaveTangent ); }
+
+	// Converts the alpha along this segment into the input key of the path spline
+	float GetSplineInputKeyAtAlpha( double Alpha ) const;
+
+	FORCEINLINE bool WantsVisualization() const { return VisualizationRequestCounter != 0; }
+	FORCEINLINE EBVPSegmentVisualizationLOD GetVisualizationLOD() const { return VisualizationLOD; }
+
+	// Called by the visualization trackers to report the distance from their observer to this segment
+	void ReportObserverDistance( double ObserverDistance );
+	// Picks the LOD for the segment based on the closest observer distance reported since the last update
+	void UpdateVisualizationLOD();
+
+	// Returns true if the segment deviates from its chord by no more than the given angle, in degrees
+	bool IsSegmentNearlyStraight( float MaxAngleDegrees ) const;
+
+	// Overrides the color of the segment visualization, or resets it back to the path color if the override is not set
+	void SetSegmentColorOverride( const TOptional<FLinearColor>& NewColorOverride );
+	FLinearColor GetSegmentColor() const;
+
+	// Approximates the segment curve with the given number of lines and appends them to the list
+	void AppendSegmentLines( TArray<FBatchedLine>& OutLines, const FLinearColor& LineColor, int32 NumLines, float LineThickness ) const;
 	
 	void UpdateSegment();
 	void DestroySegment();
-	
-	void AddReferencedObjects( FReferenceCollector& ReferenceCollector );
+
+	FORCEINLINE bool IsSegmentHibernated() const { return HibernationStartTime >= 0.0; }
+	FORCEINLINE double GetHibernationStartTime() const { return HibernationStartTime; }
+	FORCEINLINE int32 GetNumHibernatedComponents() const { return NumHibernatedComponents; }
+	int32 GetNumSegmentComponents() const;
+
+	// Destroys the components kept around by the hibernated segment. They will be re-created once the segment becomes relevant again
+	void ReleaseHibernatedComponents();
 private:
 	void GetSplinePointsForSegment( int32& OutStartPoint, int32& OutEndPoint ) const;
 	
 	void ForceUpdateVisualization();
 	void ForceUpdateCollision();
+	void UpdateHibernationState();
+	void DestroySegmentComponents();
 
 	void RebuildCollidersForSpline( TArray<FBVPSegmentColliderInfo>& ColliderList ) const;
+	void UpdateSegmentGeometryMetrics();
 };
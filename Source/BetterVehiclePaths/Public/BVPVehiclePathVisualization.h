@@ -4,46 +4,120 @@
 
 #include "CoreMinimal.h"
 #include "UObject/Object.h"
+#include "Components/LineBatchComponent.h"
+#include "UObject/ObjectKey.h"
+#include "BVPPathAnalysis.h"
 
 class UBVPSubsystem;
 class AFGTargetPoint;
 class AFGDrivingTargetList;
-class UMaterialInstanceDynamic;
 class FBVPVehiclePathSegmentVisualization;
 class UMaterialInterface;
-class AActor;
+class ABVPPathVisualizationActor;
+class UPrimitiveComponent;
+class USplineMeshComponent;
 
 // Visualization of a vehicle path (e.g. target point list).
 class BETTERVEHICLEPATHS_API FBVPVehiclePathVisualization
 {
 protected:
 	UBVPSubsystem* OwnerSubsystem{};
-	AFGDrivingTargetList* TargetPointList{};
-	UMaterialInstanceDynamic* MaterialInstance{};
-	AActor* VisualizationActor{};
+
+	// Target list is owned by the vehicle subsystem and can be destroyed at any time, so only a weak handle to it is kept.
+	// Key of the target list stays valid after that, allowing the stale visualization to be removed from the subsystem
+	TWeakObjectPtr<AFGDrivingTargetList> TargetPointList;
+	TObjectKey<AFGDrivingTargetList> TargetListKey;
+
+	// Actor owning all components of this visualization. Native structures only keep weak handles to the components
+	TWeakObjectPtr<ABVPPathVisualizationActor> VisualizationActor;
+	FLinearColor PathColor;
 	TArray<FBVPVehiclePathSegmentVisualization*> VisualizationSegments;
+
+	// Segments keyed by the path node they start at. Rebuilt when the path nodes of any of the segments change
+	TMap<TObjectKey<AFGTargetPoint>, FBVPVehiclePathSegmentVisualization*> SegmentsByStartPathNode;
+
+	// Meshes used to render runs of merged segments, and lines used to render segments at the line LOD
+	TArray<TWeakObjectPtr<USplineMeshComponent>> MergedRunComponents;
+	TWeakObjectPtr<ULineBatchComponent> LineBatchComponent;
+	bool bNeedsLODRepresentationRebuild{};
+
+	// Incremented every time the geometry of any of the segments changes
+	int32 GeometryGeneration{};
+
+	// Lines used to render this path in the network overview, and the geometry generation they have been built for
+	TArray<FBatchedLine> NetworkOverviewLines;
+	int32 NetworkOverviewLinesGeneration{INDEX_NONE};
+
+	// Problems found on the segments of this path, and the geometry generation and the target speeds they have been found for
+	TArray<FBVPPathProblem> PathProblems;
+	int32 PathProblemsGeneration{INDEX_NONE};
+	uint32 PathProblemsSpeedChecksum{};
+
+	// Start path nodes of the segments conflicting with the segments of other paths, as reported by the conflict detector
+	TArray<TObjectKey<AFGTargetPoint>> ConflictingSegmentStartNodes;
+
+	// Whether the segments with problems are currently highlighted, and whether the highlight needs to be re-applied because the problems have changed
+	bool bProblemHighlightApplied{};
+	bool bProblemHighlightDirty{};
 public:
 	FBVPVehiclePathVisualization( UBVPSubsystem* InSubsystem, AFGDrivingTargetList* InTargetList );
 	~FBVPVehiclePathVisualization();
 
 	FORCEINLINE UBVPSubsystem* GetSubsystem() const { return OwnerSubsystem; }
-	FORCEINLINE AFGDrivingTargetList* GetTargetList() const { return TargetPointList; }
+	FORCEINLINE AFGDrivingTargetList* GetTargetList() const { return TargetPointList.Get(); }
+	FORCEINLINE TObjectKey<AFGDrivingTargetList> GetTargetListKey() const { return TargetListKey; }
 	FORCEINLINE const TArray<FBVPVehiclePathSegmentVisualization*>& GetVisualizationSegments() const { return VisualizationSegments; }
 
-	AActor* GetVisualizationActor();
-	UMaterialInterface* GetOrCreateMaterialInstance();
+	// Returns the actor holding the components of this visualization, spawning it if it does not exist yet
+	ABVPPathVisualizationActor* GetVisualizationActor();
+
+	// Returns the number of the components alive on the visualization actor
+	int32 GetNumVisualizationComponents() const;
+
+	// Destroys the component created on the visualization actor
+	void DestroyVisualizationComponent( UPrimitiveComponent* Component ) const;
+	FORCEINLINE FLinearColor GetPathColor() const { return PathColor; }
+
+	// Sets up the material and the custom primitive data of the component to render it with the given color. All paths share the same material.
+	void ApplyVisualizationMaterial( UPrimitiveComponent* PrimitiveComponent, const FLinearColor& Color ) const;
+
+	// Marks the merged meshes and lines of the path as outdated. They will be rebuilt on the next update
+	FORCEINLINE void MarkLODRepresentationDirty() { bNeedsLODRepresentationRebuild = true; }
+
+	FORCEINLINE int32 GetGeometryGeneration() const { return GeometryGeneration; }
+	FORCEINLINE void IncrementGeometryGeneration() { GeometryGeneration++; }
+
+	// Rebuilds the network overview lines if the geometry has changed since they were built. Returns true if the lines have been rebuilt
+	bool UpdateNetworkOverviewLines();
+	FORCEINLINE const TArray<FBatchedLine>& GetNetworkOverviewLines() const { return NetworkOverviewLines; }
+
+	// Re-analyzes the segments for problems if the geometry or the target speeds have changed since the last analysis. Returns true if the problems have been updated
+	bool UpdatePathProblems();
+	FORCEINLINE const TArray<FBVPPathProblem>& GetPathProblems() const { return PathProblems; }
+
+	// Sets the segments conflicting with other paths. They will be highlighted together with the segments with problems
+	void SetConflictingSegmentStartNodes( TArray<TObjectKey<AFGTargetPoint>>&& NewSegmentStartNodes );
+
+	// Overrides the color of the segments with problems and conflicts with the highlight colors, or resets them back to the path color
+	void ApplyProblemHighlight( bool bHighlightEnabled, const FLinearColor& ProblemColor, const FLinearColor& ConflictColor );
 
 	// Attempts to find a visualization segment by index. First segment is 0->1, second 1->2 and so on. The last one is Num->0
 	FBVPVehiclePathSegmentVisualization* FindSegmentByIndex( int32 SegmentIndex ) const;
 
 	// Attempts to find a path visualization segment that starts at the provided node
-	FBVPVehiclePathSegmentVisualization* FindSegmentByStartPathNode( const AFGTargetPoint* InPathNodeAfter ) const;
+	FBVPVehiclePathSegmentVisualization* FindSegmentByStartPathNode( TObjectKey<AFGTargetPoint> InPathNodeAfter ) const;
+
+	// Finds the segment closest to the location among the segments whose bounds are within the search radius, and the alpha of the closest point on it
+	FBVPVehiclePathSegmentVisualization* FindSegmentClosestToLocation( const FVector& Location, double SearchRadius, double& OutAlpha ) const;
 
 	// Returns true if this visualization is valid. If not, it should not be used and should be destroyed.
 	bool IsVisualizationValid() const;
 	
 	void UpdateVisualization();
 	void DestroyVisualization();
-	
-	void AddStructReferencedObjects( FReferenceCollector& Collector );
+private:
+	void RebuildLODRepresentation();
+	// Re-orders the segments to match the path nodes, keeping the segments whose start path node is still in the list so that they do not have to be rebuilt.
+	// Segments of the nodes that have left the list are reused for the new nodes, and the rest are spawned or destroyed as needed
+	void ReconcileSegments( int32 NumSegments );
 };
@@ -5,6 +5,8 @@
 #include "CoreMinimal.h"
 #include "Modules/ModuleManager.h"
 
+BETTERVEHICLEPATHS_API DECLARE_LOG_CATEGORY_EXTERN( LogBetterVehiclePaths, Log, All );
+
 class FBetterVehiclePathsModule : public IModuleInterface
 {
 public: